@@ -0,0 +1,121 @@
+#include "colonreader.h"
+#include <cstring>
+
+/**
+ * @brief ColonReader::ColonReader
+ * @param data raw output, shared not copied
+ */
+ColonReader::ColonReader(const QByteArray &data)
+    : buffer(data), pos(buffer.constData()),
+      end(buffer.constData() + buffer.size()), count(0) {}
+
+/**
+ * @brief ColonReader::next move on to the next record, empty lines are
+ * skipped.
+ * @return false when there are no more records
+ */
+bool ColonReader::next() {
+  while (pos < end && (*pos == '\n' || *pos == '\r'))
+    ++pos;
+  if (pos >= end) {
+    count = 0;
+    return false;
+  }
+  const char *lineEnd = pos;
+  while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+    ++lineEnd;
+
+  count = 0;
+  const char *start = pos;
+  for (const char *c = pos; c <= lineEnd && count < maxFields; ++c) {
+    if (c == lineEnd || *c == ':') {
+      fieldStart[count] = start;
+      fieldLength[count] = c - start;
+      ++count;
+      start = c + 1;
+    }
+  }
+  pos = lineEnd;
+  return true;
+}
+
+/**
+ * @brief ColonReader::fieldCount number of fields in the current record.
+ * @return
+ */
+int ColonReader::fieldCount() const { return count; }
+
+/**
+ * @brief ColonReader::fieldIs compare a field without converting it.
+ * @param index
+ * @param value
+ * @return
+ */
+bool ColonReader::fieldIs(int index, const char *value) const {
+  if (index >= count)
+    return false;
+  int length = static_cast<int>(strlen(value));
+  return fieldLength[index] == length &&
+         memcmp(fieldStart[index], value, length) == 0;
+}
+
+/**
+ * @brief ColonReader::firstChar first character of a field, like validity.
+ * @param index
+ * @return '\0' for empty or missing fields
+ */
+char ColonReader::firstChar(int index) const {
+  if (index >= count || fieldLength[index] == 0)
+    return '\0';
+  return fieldStart[index][0];
+}
+
+/**
+ * @brief ColonReader::number a numeric field such as a timestamp.
+ * @param index
+ * @return 0 for empty, missing or non numeric fields
+ */
+uint ColonReader::number(int index) const {
+  if (index >= count)
+    return 0;
+  uint value = 0;
+  for (int i = 0; i < fieldLength[index]; ++i) {
+    char c = fieldStart[index][i];
+    if (c < '0' || c > '9')
+      return 0;
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
+
+/**
+ * @brief ColonReader::text a field as text, gpg escapes colons and control
+ * characters as \\xHH and encodes as UTF-8.
+ * @param index
+ * @return
+ */
+QString ColonReader::text(int index) const {
+  if (index >= count)
+    return QString();
+  const char *field = fieldStart[index];
+  int length = fieldLength[index];
+  if (memchr(field, '\\', length) == Q_NULLPTR)
+    return QString::fromUtf8(field, length);
+
+  QByteArray unescaped;
+  unescaped.reserve(length);
+  for (int i = 0; i < length; ++i) {
+    if (field[i] == '\\' && i + 3 < length && field[i + 1] == 'x') {
+      bool ok = false;
+      char c = static_cast<char>(
+          QByteArray(field + i + 2, 2).toUInt(&ok, 16));
+      if (ok) {
+        unescaped += c;
+        i += 3;
+        continue;
+      }
+    }
+    unescaped += field[i];
+  }
+  return QString::fromUtf8(unescaped);
+}
@@ -0,0 +1,41 @@
+#ifndef COLONREADER_H_
+#define COLONREADER_H_
+
+#include <QByteArray>
+#include <QString>
+
+/*!
+    \class ColonReader
+    \brief Walks the records of gpg --with-colons output without copying it.
+
+    Fields are kept as positions in the original buffer and only converted
+    when asked for.
+    http://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob_plain;f=doc/DETAILS
+ */
+class ColonReader {
+public:
+  explicit ColonReader(const QByteArray &data);
+
+  bool next();
+  int fieldCount() const;
+  bool fieldIs(int index, const char *value) const;
+  char firstChar(int index) const;
+  uint number(int index) const;
+  QString text(int index) const;
+
+  /**
+   * @brief ColonReader::maxFields fields beyond this are ignored, DETAILS
+   * currently defines 21.
+   */
+  static const int maxFields = 21;
+
+private:
+  QByteArray buffer;
+  const char *pos;
+  const char *end;
+  const char *fieldStart[maxFields];
+  int fieldLength[maxFields];
+  int count;
+};
+
+#endif // COLONREADER_H_
@@ -702,6 +702,7 @@ void ConfigDialog::on_checkBoxUseGit_clicked() {
   ui->checkBoxAddGPGId->setEnabled(ui->checkBoxUseGit->isChecked());
   ui->checkBoxAutoPull->setEnabled(ui->checkBoxUseGit->isChecked());
   ui->checkBoxAutoPush->setEnabled(ui->checkBoxUseGit->isChecked());
+  ui->spinBoxSyncInterval->setEnabled(ui->checkBoxUseGit->isChecked());
 }
 
 /**
@@ -1013,6 +1014,21 @@ bool ConfigDialog::autoPull() { return ui->checkBoxAutoPull->isChecked(); }
  */
 bool ConfigDialog::autoPush() { return ui->checkBoxAutoPush->isChecked(); }
 
+/**
+ * @brief ConfigDialog::syncInterval set how often to fetch in the background
+ * @param minutes   0 to never fetch
+ */
+void ConfigDialog::syncInterval(int minutes) {
+  ui->spinBoxSyncInterval->setValue(minutes);
+}
+
+/**
+ * @brief ConfigDialog::syncInterval return how often to fetch in the
+ * background
+ * @return minutes, 0 for never
+ */
+int ConfigDialog::syncInterval() { return ui->spinBoxSyncInterval->value(); }
+
 /**
  * @brief ConfigDialog::templateAllFields return preference for templating all
  * tokenisable fields
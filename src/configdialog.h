@@ -94,6 +94,8 @@ public:
   void autoPull(bool autoPull);
   bool autoPush();
   void autoPush(bool autoPush);
+  int syncInterval();
+  void syncInterval(int minutes);
   bool alwaysOnTop();
   void alwaysOnTop(bool alwaysOnTop);
 
@@ -2,7 +2,9 @@
 #define DATAHELPERS_H
 
 #include <QDateTime>
+#include <QList>
 #include <QString>
+#include <QStringList>
 
 /*!
     \struct passwordConfiguration
@@ -50,16 +52,16 @@ struct UserInfo {
    * @brief UserInfo::fullyValid when validity is f or u.
    * http://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob_plain;f=doc/DETAILS
    */
-  bool fullyValid() { return validity == 'f' || validity == 'u'; }
+  bool fullyValid() const { return validity == 'f' || validity == 'u'; }
   /**
    * @brief UserInfo::marginallyValid when validity is m.
    * http://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob_plain;f=doc/DETAILS
    */
-  bool marginallyValid() { return validity == 'm'; }
+  bool marginallyValid() const { return validity == 'm'; }
   /**
    * @brief UserInfo::isValid when fullyValid or marginallyValid.
    */
-  bool isValid() { return fullyValid() || marginallyValid(); }
+  bool isValid() const { return fullyValid() || marginallyValid(); }
 
   /**
    * @brief UserInfo::name full name
@@ -69,6 +71,19 @@ struct UserInfo {
    * @brief UserInfo::key_id hexadecimal representation
    */
   QString key_id;
+  /**
+   * @brief UserInfo::fingerprint of the primary key, hexadecimal
+   */
+  QString fingerprint;
+  /**
+   * @brief UserInfo::subkey_ids hexadecimal ids of the subkeys
+   */
+  QStringList subkey_ids;
+  /**
+   * @brief UserInfo::subkey_fingerprints of the subkeys, same order as
+   * UserInfo::subkey_ids
+   */
+  QStringList subkey_fingerprints;
   /**
    * @brief UserInfo::validity GnuPG representation of validity
    * http://git.gnupg.org/cgi-bin/gitweb.cgi?p=gnupg.git;a=blob_plain;f=doc/DETAILS
@@ -93,4 +108,35 @@ struct UserInfo {
   QDateTime created;
 };
 
+/*!
+    \struct RecipientInfo
+    \brief How a recipient from .gpg-id resolves against the keyring.
+ */
+struct RecipientInfo {
+  /**
+   * @brief RecipientInfo::Status outcome of the lookup.
+   */
+  enum Status {
+    FOUND = 0,
+    NOT_FOUND,
+    AMBIGUOUS, //  more than one key matches
+    UNUSABLE   //  the only match is invalid, revoked or expired
+  };
+
+  RecipientInfo() : status(NOT_FOUND) {}
+
+  /**
+   * @brief RecipientInfo::recipient as written in .gpg-id
+   */
+  QString recipient;
+  /**
+   * @brief RecipientInfo::status
+   */
+  Status status;
+  /**
+   * @brief RecipientInfo::keys the matching keys
+   */
+  QList<UserInfo> keys;
+};
+
 #endif // DATAHELPERS_H
@@ -0,0 +1,6 @@
+#include "debughelper.h"
+
+Q_LOGGING_CATEGORY(logExecutor, "qtpass.executor")
+Q_LOGGING_CATEGORY(logPass, "qtpass.pass")
+Q_LOGGING_CATEGORY(logGit, "qtpass.git")
+Q_LOGGING_CATEGORY(logTransactions, "qtpass.transactions")
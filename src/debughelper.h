@@ -2,8 +2,71 @@
 #define DEBUG_H
 
 #include <QDebug>
+#include <QLoggingCategory>
 
 //  this is soooooo ugly...
 #define dbg() qDebug() << __FILE__ ":" << __LINE__
 
+/*
+ * Logging for code that runs for every process, transaction step or git
+ * command. Each category can be left out of the build by defining its
+ * QTPASS_LOG_* macro to 0, by default they are only built into debug builds.
+ * Categories that are built in can be filtered at runtime with
+ * QT_LOGGING_RULES, e.g. QT_LOGGING_RULES="qtpass.executor.debug=false".
+ * The arguments of a disabled category are never evaluated.
+ */
+#ifndef QTPASS_LOG
+#ifdef QT_NO_DEBUG
+#define QTPASS_LOG 0
+#else
+#define QTPASS_LOG 1
+#endif
+#endif
+
+#ifndef QTPASS_LOG_EXECUTOR
+#define QTPASS_LOG_EXECUTOR QTPASS_LOG
+#endif
+#ifndef QTPASS_LOG_PASS
+#define QTPASS_LOG_PASS QTPASS_LOG
+#endif
+#ifndef QTPASS_LOG_GIT
+#define QTPASS_LOG_GIT QTPASS_LOG
+#endif
+#ifndef QTPASS_LOG_TRANSACTIONS
+#define QTPASS_LOG_TRANSACTIONS QTPASS_LOG
+#endif
+
+#define QTPASS_NO_LOG()                                                        \
+  while (false)                                                                \
+  QMessageLogger().noDebug()
+
+Q_DECLARE_LOGGING_CATEGORY(logExecutor)
+Q_DECLARE_LOGGING_CATEGORY(logPass)
+Q_DECLARE_LOGGING_CATEGORY(logGit)
+Q_DECLARE_LOGGING_CATEGORY(logTransactions)
+
+#if QTPASS_LOG_EXECUTOR
+#define dbgExecutor() qCDebug(logExecutor)
+#else
+#define dbgExecutor() QTPASS_NO_LOG()
+#endif
+
+#if QTPASS_LOG_PASS
+#define dbgPass() qCDebug(logPass)
+#else
+#define dbgPass() QTPASS_NO_LOG()
+#endif
+
+#if QTPASS_LOG_GIT
+#define dbgGit() qCDebug(logGit)
+#else
+#define dbgGit() QTPASS_NO_LOG()
+#endif
+
+#if QTPASS_LOG_TRANSACTIONS
+#define dbgTransactions() qCDebug(logTransactions)
+#else
+#define dbgTransactions() QTPASS_NO_LOG()
+#endif
+
 #endif // DEBUG_H
@@ -1,20 +1,69 @@
 #include "executor.h"
 #include "debughelper.h"
+#include "executorstats.h"
+#include "tracer.h"
+#if LIBGIT2
+#include "gitworker.h"
+#endif
 #include <QCoreApplication>
 #include <QDir>
+#include <QFileInfo>
 #include <QTextCodec>
 
 /**
  * @brief Executor::Executor executes external applications
  * @param parent
  */
-Executor::Executor(QObject *parent) : QObject(parent), running(false) {
+Executor::Executor(QObject *parent)
+    : QObject(parent), running(false), spawnMode(QPROCESS),
+      gitWorker(Q_NULLPTR) {
   connect(&m_process,
           static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
               &QProcess::finished),
           this, static_cast<void (Executor::*)(int, QProcess::ExitStatus)>(
                     &Executor::finished));
-  connect(&m_process, &QProcess::started, this, &Executor::starting);
+  connect(&m_process, &QProcess::started, this, &Executor::processStarted);
+  // queued, executeNext() still uses the job when waiting for the start fails
+  connect(&m_process,
+          static_cast<void (QProcess::*)(QProcess::ProcessError)>(
+              &QProcess::error),
+          this, &Executor::processError, Qt::QueuedConnection);
+  connect(&m_spawner, &Spawner::started, this, &Executor::processStarted);
+  connect(&m_spawner, &Spawner::finished, this, &Executor::spawnFinished);
+}
+
+/**
+ * @brief Executor::~Executor gives back the git worker if it used one
+ */
+Executor::~Executor() {
+#if LIBGIT2
+  GitWorker::release(gitWorker);
+#endif
+}
+
+/**
+ * @brief Executor::ensureGitWorker switches to the shared worker running git
+ * in-process for the store of workDir, only while nothing runs on the
+ * current one
+ * @return the worker, or Q_NULLPTR when QtPass was built without libgit2
+ */
+GitWorker *Executor::ensureGitWorker(const QString &workDir) {
+#if LIBGIT2
+  GitWorker *worker = GitWorker::acquire(workDir);
+  if (worker == gitWorker) {
+    GitWorker::release(worker);
+    return gitWorker;
+  }
+  if (gitWorker != Q_NULLPTR) {
+    disconnect(gitWorker, &GitWorker::finished, this, &Executor::gitFinished);
+    GitWorker::release(gitWorker);
+  }
+  gitWorker = worker;
+  connect(gitWorker, &GitWorker::finished, this, &Executor::gitFinished);
+#else
+  Q_UNUSED(workDir)
+#endif
+  return gitWorker;
 }
 
 /**
@@ -23,8 +72,25 @@ Executor::Executor(QObject *parent) : QObject(parent), running(false) {
 void Executor::executeNext() {
   if (!running) {
     if (!m_execQueue.isEmpty()) {
-      const execQueueItem &i = m_execQueue.head();
+      execQueueItem &i = m_execQueue.head();
       running = true;
+      i.started = ExecutorStats::now();
+      ExecutorStats::dequeued();
+      Tracer::end("queued", i.trace);
+      Tracer::begin("running", i.trace);
+      if (i.inProcess) {
+        i.spawned = i.started;
+        emit starting();
+        QMetaObject::invokeMethod(ensureGitWorker(i.workingDir), "run",
+                                  Qt::QueuedConnection, Q_ARG(QObject *, this),
+                                  Q_ARG(QString, i.workingDir),
+                                  Q_ARG(QStringList, i.args));
+        return;
+      }
+      // falls back to QProcess when posix_spawn can not be used
+      if (spawnMode == POSIX_SPAWN &&
+          m_spawner.start(i.app, i.args, i.workingDir, i.input.toUtf8()))
+        return;
       if (!i.workingDir.isEmpty())
         m_process.setWorkingDirectory(i.workingDir);
       m_process.start(i.app, i.args);
@@ -32,7 +98,7 @@ void Executor::executeNext() {
         m_process.waitForStarted(-1);
         QByteArray data = i.input.toUtf8();
         if (m_process.write(data) != data.length())
-          dbg() << "Not all data written to process:" << i.id << " " << i.app;
+          dbgExecutor() << "Not all data written to process:" << i.id << i.app;
       }
       m_process.closeWriteChannel();
     }
@@ -99,16 +165,50 @@ void Executor::execute(int id, const QString &workDir, const QString &app,
   // This will result in bogus "QProcess::FailedToStart" messages,
   // also hiding legitimate errors from the gpg commands.
   if (app.isEmpty()) {
-    dbg() << "Trying to execute nothing...";
+    dbgExecutor() << "Trying to execute nothing...";
     return;
   }
   QString appPath =
       QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(app);
-  m_execQueue.push_back(
-      {id, appPath, args, input, readStdout, readStderr, workDir});
+  int trace = Tracer::newId();
+  if (trace != 0)
+    Tracer::begin("queued", trace,
+                  QFileInfo(app).fileName() + " " + args.value(0));
+  m_execQueue.push_back({id, appPath, args, input, readStdout, readStderr,
+                         workDir, false, trace, ExecutorStats::now(), 0, 0});
+  ExecutorStats::queued();
   executeNext();
 }
 
+/**
+ * @brief Executor::executeGit queues a git command, it is run in-process by
+ * the GitWorker when QtPass was built with libgit2 and falls back to the git
+ * executable otherwise
+ * @param id
+ * @param workDir
+ * @param app       git executable used as fallback
+ * @param args
+ * @param readStdout
+ * @param readStderr
+ */
+void Executor::executeGit(int id, const QString &workDir, const QString &app,
+                          const QStringList &args, bool readStdout,
+                          bool readStderr) {
+#if LIBGIT2
+  if (GitWorker::handles(args)) {
+    int trace = Tracer::newId();
+    if (trace != 0)
+      Tracer::begin("queued", trace, "libgit2 " + args.value(0));
+    m_execQueue.push_back({id, app, args, QString(), readStdout, readStderr,
+                           workDir, true, trace, ExecutorStats::now(), 0, 0});
+    ExecutorStats::queued();
+    executeNext();
+    return;
+  }
+#endif
+  execute(id, workDir, app, args, readStdout, readStderr);
+}
+
 /**
  * @brief Executor::executeBlocking blocking version of the executor,
  * takes input and presents it as stdin
@@ -130,7 +230,7 @@ int Executor::executeBlocking(QString app, const QStringList &args,
     QByteArray data = input.toUtf8();
     internal.waitForStarted(-1);
     if (internal.write(data) != data.length()) {
-      dbg() << "Not all input written:" << app;
+      dbgExecutor() << "Not all input written:" << app;
     }
     internal.closeWriteChannel();
   }
@@ -163,6 +263,35 @@ int Executor::executeBlocking(QString app, const QStringList &args,
   return executeBlocking(app, args, QString(), process_out, process_err);
 }
 
+/**
+ * @brief Executor::executeGitBlocking blocking version of executeGit
+ * @param workDir
+ * @param app       git executable used as fallback
+ * @param args
+ * @param process_out
+ * @param process_err
+ * @return
+ */
+int Executor::executeGitBlocking(const QString &workDir, const QString &app,
+                                 const QStringList &args, QString *process_out,
+                                 QString *process_err) {
+#if LIBGIT2
+  if (GitWorker::handles(args)) {
+    if (!running)
+      return ensureGitWorker(workDir)->execute(workDir, args, process_out,
+                                               process_err);
+    // the current worker may be busy with another store
+    GitWorker *worker = GitWorker::acquire(workDir);
+    int exitCode = worker->execute(workDir, args, process_out, process_err);
+    GitWorker::release(worker);
+    return exitCode;
+  }
+#else
+  Q_UNUSED(workDir)
+#endif
+  return executeBlocking(app, args, process_out, process_err);
+}
+
 /**
  * @brief Executor::setEnvironment set environment variables
  * for executor processes
@@ -170,8 +299,17 @@ int Executor::executeBlocking(QString app, const QStringList &args,
  */
 void Executor::setEnvironment(const QStringList &env) {
   m_process.setEnvironment(env);
+  m_spawner.setEnvironment(env);
 }
 
+/**
+ * @brief Executor::setSpawnMode choose how the processes queued afterwards
+ * are started, posix_spawn saves most of the cost of starting a process when
+ * many short ones run in a row
+ * @param mode
+ */
+void Executor::setSpawnMode(SpawnMode mode) { spawnMode = mode; }
+
 /**
  * @brief Executor::cancelNext  cancels execution of first process in queue
  *                              if it's not already running
@@ -181,29 +319,129 @@ void Executor::setEnvironment(const QStringList &env) {
 int Executor::cancelNext() {
   if (running || m_execQueue.isEmpty())
     return -1; //  TODO(bezet): definitely throw here
+  ExecutorStats::dequeued();
   return m_execQueue.dequeue().id;
 }
 
+/**
+ * @brief Executor::processStarted note when the process of the job at the
+ * head of the queue got running
+ */
+void Executor::processStarted() {
+  if (!m_execQueue.isEmpty())
+    m_execQueue.head().spawned = ExecutorStats::now();
+  emit starting();
+}
+
+/**
+ * @brief Executor::record add a finished job to ExecutorStats
+ * @param item
+ * @param exitCode  -1 when the process crashed
+ */
+void Executor::record(const execQueueItem &item, int exitCode) {
+  qint64 spawned = item.spawned > 0 ? item.spawned : item.started;
+  ExecutorStats::record(item.inProcess ? QString("libgit2")
+                                       : QFileInfo(item.app).fileName(),
+                        item.started - item.queued, spawned - item.started,
+                        ExecutorStats::now() - spawned, exitCode);
+}
+
 /**
  * @brief Executor::finished called when an executed process finishes
  * @param exitCode
  * @param exitStatus
  */
 void Executor::finished(int exitCode, QProcess::ExitStatus exitStatus) {
+  complete(exitCode, exitStatus == QProcess::NormalExit,
+           m_process.readAllStandardOutput(), m_process.readAllStandardError(),
+           m_process.errorString());
+}
+
+/**
+ * @brief Executor::processError called when the process could not be
+ * started, it never finishes then
+ * @param error
+ */
+void Executor::processError(QProcess::ProcessError error) {
+  if (error == QProcess::FailedToStart && running)
+    complete(-1, false, QByteArray(), QByteArray(), m_process.errorString());
+}
+
+/**
+ * @brief Executor::spawnFinished called when a process started with
+ * posix_spawn finishes
+ * @param exitCode
+ * @param crashed
+ * @param output
+ * @param errout
+ */
+void Executor::spawnFinished(int exitCode, bool crashed,
+                             const QByteArray &output,
+                             const QByteArray &errout) {
+  complete(exitCode, !crashed, output, errout, tr("Process crashed"));
+}
+
+/**
+ * @brief Executor::complete report the process at the head of the queue and
+ * start the next one, a process that did not exit normally is reported as
+ * failed with exit code -1
+ * @param exitCode
+ * @param normalExit    false when the process crashed, was killed or did not
+ *                      start
+ * @param output
+ * @param errout
+ * @param error         why the process did not exit normally
+ */
+void Executor::complete(int exitCode, bool normalExit,
+                        const QByteArray &output, const QByteArray &errout,
+                        const QString &error) {
   execQueueItem i = m_execQueue.dequeue();
   running = false;
-  if (exitStatus == QProcess::NormalExit) {
-    QString output, err;
-    QTextCodec *codec = QTextCodec::codecForLocale();
-    if (i.readStdout)
-      output = codec->toUnicode(m_process.readAllStandardOutput());
-    if (i.readStderr or exitCode != 0) {
-      err = codec->toUnicode(m_process.readAllStandardError());
-      if (exitCode != 0)
-        dbg() << exitCode << err;
-    }
-    emit finished(i.id, exitCode, output, err);
+  Tracer::end("running", i.trace);
+  if (!normalExit)
+    exitCode = -1;
+  record(i, exitCode);
+  QString out, err;
+  QTextCodec *codec = QTextCodec::codecForLocale();
+  if (i.readStdout)
+    out = codec->toUnicode(output);
+  if (i.readStderr or exitCode != 0) {
+    err = codec->toUnicode(errout);
+    if (!normalExit)
+      err += error;
+    if (exitCode != 0)
+      dbgExecutor() << i.app << "exited with" << exitCode << err;
+  }
+  {
+    Tracer::Span span("Executor::finished", i.trace);
+    emit finished(i.id, exitCode, out, err);
+  }
+  executeNext();
+}
+
+/**
+ * @brief Executor::gitFinished called when the GitWorker is done with the
+ * command at the head of the queue
+ * @param requester the Executor that ran it, the worker is shared
+ * @param exitCode
+ * @param output
+ * @param errout
+ */
+void Executor::gitFinished(QObject *requester, int exitCode,
+                           const QString &output, const QString &errout) {
+  if (requester != this)
+    return;
+  execQueueItem i = m_execQueue.dequeue();
+  running = false;
+  Tracer::end("running", i.trace);
+  record(i, exitCode);
+  if (exitCode != 0)
+    dbgExecutor() << "git" << i.args.value(0) << "failed with" << exitCode
+                  << errout;
+  {
+    Tracer::Span span("Executor::finished", i.trace);
+    emit finished(i.id, exitCode, i.readStdout ? output : QString(),
+                  i.readStderr || exitCode != 0 ? errout : QString());
   }
-  //	else: emit crashed with ID, which may give a chance to recover ?
   executeNext();
 }
@@ -1,10 +1,13 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
+#include "spawner.h"
 #include <QObject>
 #include <QProcess>
 #include <QQueue>
 
+class GitWorker;
+
 /*!
     \class Executor
     \brief Executes external commands for handleing password, git and other data
@@ -12,6 +15,16 @@
 class Executor : public QObject {
   Q_OBJECT
 
+public:
+  /**
+   * @brief SpawnMode how processes are started
+   */
+  enum SpawnMode {
+    QPROCESS,   /**< with QProcess */
+    POSIX_SPAWN /**< with posix_spawn where available, QProcess otherwise */
+  };
+
+private:
   /*!
       \struct execQueueItem
       \brief Execution queue items for non-interactive ordered execution.
@@ -48,15 +61,43 @@ class Executor : public QObject {
      *                      started
      */
     QString workingDir;
+    /**
+     * @brief inProcess     run by the GitWorker instead of starting app
+     */
+    bool inProcess;
+    /**
+     * @brief trace     id of the job for Tracer, 0 when not tracing
+     */
+    int trace;
+    /**
+     * @brief queued    ExecutorStats::now() when it was added to the queue
+     */
+    qint64 queued;
+    /**
+     * @brief started   when it left the queue
+     */
+    qint64 started;
+    /**
+     * @brief spawned   when its process was running
+     */
+    qint64 spawned;
   };
 
   QQueue<execQueueItem> m_execQueue;
   QProcess m_process;
+  Spawner m_spawner;
   bool running;
+  SpawnMode spawnMode;
+  GitWorker *gitWorker;
   void executeNext();
+  GitWorker *ensureGitWorker(const QString &workDir);
+  void record(const execQueueItem &item, int exitCode);
+  void complete(int exitCode, bool normalExit, const QByteArray &output,
+                const QByteArray &errout, const QString &error);
 
 public:
   explicit Executor(QObject *parent = 0);
+  ~Executor();
 
   void execute(int id, const QString &app, const QStringList &args,
                bool readStdout, bool readStderr = true);
@@ -81,11 +122,27 @@ public:
   int executeBlocking(QString app, const QStringList &args,
                       QString *process_out, QString *process_err = Q_NULLPTR);
 
+  void executeGit(int id, const QString &workDir, const QString &app,
+                  const QStringList &args, bool readStdout,
+                  bool readStderr = true);
+
+  int executeGitBlocking(const QString &workDir, const QString &app,
+                         const QStringList &args,
+                         QString *process_out = Q_NULLPTR,
+                         QString *process_err = Q_NULLPTR);
+
   void setEnvironment(const QStringList &env);
+  void setSpawnMode(SpawnMode mode);
 
   int cancelNext();
 private slots:
+  void processStarted();
   void finished(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError(QProcess::ProcessError error);
+  void spawnFinished(int exitCode, bool crashed, const QByteArray &output,
+                     const QByteArray &errout);
+  void gitFinished(QObject *requester, int exitCode, const QString &output,
+                   const QString &errout);
 signals:
   /**
    * @brief finished    signal that is emited when process finishes
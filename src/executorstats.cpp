@@ -0,0 +1,163 @@
+#include "executorstats.h"
+#include <algorithm>
+
+QHash<QString, ExecutorStats::Program> ExecutorStats::stats;
+QElapsedTimer ExecutorStats::clock;
+int ExecutorStats::depth = 0;
+int ExecutorStats::maxDepth = 0;
+bool ExecutorStats::dump = false;
+
+/**
+ * @brief ExecutorStats::now microseconds on a monotonic clock, used for the
+ * timestamps of a job.
+ */
+qint64 ExecutorStats::now() {
+  if (!clock.isValid())
+    clock.start();
+  return clock.nsecsElapsed() / 1000;
+}
+
+/**
+ * @brief ExecutorStats::queued a job was added to a queue.
+ */
+void ExecutorStats::queued() { maxDepth = qMax(maxDepth, ++depth); }
+
+/**
+ * @brief ExecutorStats::dequeued a job left its queue, it was started or
+ * cancelled.
+ */
+void ExecutorStats::dequeued() { depth = qMax(depth - 1, 0); }
+
+/**
+ * @brief ExecutorStats::record add a finished job.
+ * @param program   name the job is counted under, e.g. gpg
+ * @param wait      microseconds from being queued until started
+ * @param spawn     microseconds from being started until the process ran
+ * @param run       microseconds from then until it finished
+ * @param exitCode  -1 when the process crashed
+ */
+void ExecutorStats::record(const QString &program, qint64 wait, qint64 spawn,
+                           qint64 run, int exitCode) {
+  Program &p = stats[program];
+  qint64 values[3] = {wait, spawn, run};
+  for (int metric = WAIT; metric <= RUN; ++metric) {
+    QVector<qint64> &samples = p.samples[metric];
+    if (samples.size() < window)
+      samples.append(values[metric]);
+    else
+      samples[p.jobs % window] = values[metric];
+  }
+  ++p.jobs;
+  ++p.exitCodes[exitCode];
+}
+
+/**
+ * @brief ExecutorStats::programs names of the programs that ran, sorted.
+ */
+QStringList ExecutorStats::programs() {
+  QStringList names = stats.keys();
+  names.sort();
+  return names;
+}
+
+/**
+ * @brief ExecutorStats::jobs number of jobs of a program that finished.
+ * @param program
+ */
+int ExecutorStats::jobs(const QString &program) {
+  return stats.value(program).jobs;
+}
+
+/**
+ * @brief ExecutorStats::exitCodes how often a program exited with each code.
+ * @param program
+ */
+QMap<int, int> ExecutorStats::exitCodes(const QString &program) {
+  return stats.value(program).exitCodes;
+}
+
+/**
+ * @brief ExecutorStats::percentile of the jobs in the window of a program.
+ * @param program
+ * @param metric
+ * @param percentile    0 to 100
+ * @return microseconds, -1 when the program did not run
+ */
+qint64 ExecutorStats::percentile(const QString &program, Metric metric,
+                                 int percentile) {
+  QVector<qint64> samples = stats.value(program).samples[metric];
+  if (samples.isEmpty())
+    return -1;
+  int rank = qBound(0, (samples.size() * percentile + 99) / 100 - 1,
+                    samples.size() - 1);
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples.at(rank);
+}
+
+/**
+ * @brief ExecutorStats::queueDepth jobs waiting in all queues right now.
+ */
+int ExecutorStats::queueDepth() { return depth; }
+
+/**
+ * @brief ExecutorStats::maxQueueDepth most jobs that waited at once.
+ */
+int ExecutorStats::maxQueueDepth() { return maxDepth; }
+
+/**
+ * @brief ExecutorStats::enableDump print report() when QtPass quits.
+ */
+void ExecutorStats::enableDump() { dump = true; }
+
+/**
+ * @brief ExecutorStats::isDumpEnabled whether report() is to be printed.
+ */
+bool ExecutorStats::isDumpEnabled() { return dump; }
+
+/**
+ * @brief ExecutorStats::report one line per program with its job count,
+ * exit codes and p50/p99 of the timings in milliseconds.
+ */
+QString ExecutorStats::report() {
+  QString text = QString("%1 %2 %3 %4 %5  %6\n")
+                     .arg("program", -10)
+                     .arg("jobs", 6)
+                     .arg("wait p50/p99", 16)
+                     .arg("spawn p50/p99", 16)
+                     .arg("run p50/p99", 16)
+                     .arg("exit codes");
+  foreach (const QString &program, programs()) {
+    QStringList times;
+    for (int metric = WAIT; metric <= RUN; ++metric)
+      times << QString("%1/%2")
+                   .arg(percentile(program, Metric(metric), 50) / 1000.0, 0,
+                        'f', 1)
+                   .arg(percentile(program, Metric(metric), 99) / 1000.0, 0,
+                        'f', 1);
+    QStringList codes;
+    QMap<int, int> exits = exitCodes(program);
+    for (QMap<int, int>::const_iterator i = exits.constBegin();
+         i != exits.constEnd(); ++i)
+      codes << QString("%1x%2").arg(i.value()).arg(i.key());
+    text += QString("%1 %2 %3 %4 %5  %6\n")
+                .arg(program, -10)
+                .arg(jobs(program), 6)
+                .arg(times.at(WAIT), 16)
+                .arg(times.at(SPAWN), 16)
+                .arg(times.at(RUN), 16)
+                .arg(codes.join(" "));
+  }
+  text += QString("queue depth %1, at most %2\n")
+              .arg(queueDepth())
+              .arg(maxQueueDepth());
+  return text;
+}
+
+/**
+ * @brief ExecutorStats::reset forget everything recorded.
+ */
+void ExecutorStats::reset() {
+  stats.clear();
+  depth = 0;
+  maxDepth = 0;
+}
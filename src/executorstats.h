@@ -0,0 +1,67 @@
+#ifndef EXECUTORSTATS_H_
+#define EXECUTORSTATS_H_
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/*!
+    \class ExecutorStats
+    \brief Timing and exit codes of the jobs run by every Executor, grouped
+    by program.
+
+    For each job the time it waited in the queue, the time until its process
+    was started and the time it ran are kept, the last ones of every program
+    in a fixed size window, together with counters of exit codes and the
+    depth of the queues. `qtpass --stats` prints a summary to stderr when
+    QtPass quits. Executors live in the GUI thread, so this is not
+    synchronised.
+ */
+class ExecutorStats {
+public:
+  enum Metric { WAIT, SPAWN, RUN };
+
+  static qint64 now();
+
+  static void queued();
+  static void dequeued();
+  static void record(const QString &program, qint64 wait, qint64 spawn,
+                     qint64 run, int exitCode);
+
+  static QStringList programs();
+  static int jobs(const QString &program);
+  static QMap<int, int> exitCodes(const QString &program);
+  static qint64 percentile(const QString &program, Metric metric,
+                           int percentile);
+  static int queueDepth();
+  static int maxQueueDepth();
+
+  static void enableDump();
+  static bool isDumpEnabled();
+  static QString report();
+  static void reset();
+
+private:
+  /*!
+      \struct Program
+      \brief Rolling window of the jobs of one program.
+   */
+  struct Program {
+    int jobs = 0;
+    QMap<int, int> exitCodes;
+    QVector<qint64> samples[3];
+  };
+
+  static QHash<QString, Program> stats;
+  static QElapsedTimer clock;
+  static int depth;
+  static int maxDepth;
+  static bool dump;
+
+  static const int window = 256;
+};
+
+#endif // EXECUTORSTATS_H_
@@ -0,0 +1,61 @@
+#include "filecontent.h"
+
+/**
+ * @brief FileContent::parse split the output of decrypting a password file,
+ * the first line is the password.
+ * @param fileContent
+ * @param passTemplate  fields that are shown separately, one per line
+ * @param allFields     show all "field: value" lines separately
+ * @return
+ */
+FileContent FileContent::parse(const QString &fileContent,
+                               const QString &passTemplate, bool allFields) {
+  FileContent content;
+  content.lines = fileContent.split("\n");
+  content.password = content.lines.takeFirst();
+  for (int j = 0; j < content.lines.length(); ++j) {
+    const QString &line = content.lines.at(j);
+    int colon = line.indexOf(':');
+    if (colon < 0) {
+      content.remainingLines.append(line);
+      continue;
+    }
+    QString field = line.left(colon);
+    bool inTemplate = passTemplate.contains(field);
+    if (!allFields && !inTemplate)
+      continue;
+    QString value = line.mid(colon + 1);
+    if (!inTemplate && value.startsWith("//")) {
+      content.remainingLines.append(line);
+      continue; // colon is probably from a url
+    }
+    NamedValue namedValue = {field, value, j + 1};
+    content.namedValues.append(namedValue);
+  }
+  return content;
+}
+
+/**
+ * @brief FileContent::getPassword the first line.
+ */
+QString FileContent::getPassword() const { return password; }
+
+/**
+ * @brief FileContent::getNamedValues the fields to show separately.
+ */
+QList<NamedValue> FileContent::getNamedValues() const { return namedValues; }
+
+/**
+ * @brief FileContent::getRemainingData the lines that are neither the
+ * password nor a field shown separately.
+ */
+QString FileContent::getRemainingData() const {
+  return remainingLines.join("\n");
+}
+
+/**
+ * @brief FileContent::getContentWithoutPassword all lines but the first.
+ */
+QString FileContent::getContentWithoutPassword() const {
+  return lines.join("\n");
+}
@@ -0,0 +1,45 @@
+#ifndef FILECONTENT_H_
+#define FILECONTENT_H_
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/*!
+    \struct NamedValue
+    \brief A "field: value" line of a password file.
+ */
+struct NamedValue {
+  QString name;
+  QString value;
+  /**
+   * @brief position    line of the field, the password is line 0
+   */
+  int position;
+};
+
+/*!
+    \class FileContent
+    \brief Splits decrypted password files into the password, the fields
+    known from the template and everything else.
+ */
+class FileContent {
+public:
+  static FileContent parse(const QString &fileContent,
+                           const QString &passTemplate, bool allFields);
+
+  QString getPassword() const;
+  QList<NamedValue> getNamedValues() const;
+  QString getRemainingData() const;
+  QString getContentWithoutPassword() const;
+
+private:
+  FileContent() {}
+
+  QString password;
+  QStringList lines;
+  QList<NamedValue> namedValues;
+  QStringList remainingLines;
+};
+
+#endif // FILECONTENT_H_
@@ -0,0 +1,610 @@
+#include "gitworker.h"
+#include "debughelper.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QVector>
+#include <git2.h>
+
+/*!
+    \struct GitFree
+    \brief QScopedPointer cleanup for libgit2 objects.
+ */
+template <typename T, void (*Free)(T *)> struct GitFree {
+  static inline void cleanup(T *pointer) {
+    if (pointer)
+      Free(pointer);
+  }
+};
+
+typedef QScopedPointer<git_tree, GitFree<git_tree, git_tree_free>> TreePtr;
+typedef QScopedPointer<git_commit, GitFree<git_commit, git_commit_free>>
+    CommitPtr;
+typedef QScopedPointer<git_reference,
+                       GitFree<git_reference, git_reference_free>>
+    ReferencePtr;
+typedef QScopedPointer<git_remote, GitFree<git_remote, git_remote_free>>
+    RemotePtr;
+typedef QScopedPointer<git_signature,
+                       GitFree<git_signature, git_signature_free>>
+    SignaturePtr;
+typedef QScopedPointer<git_object, GitFree<git_object, git_object_free>>
+    ObjectPtr;
+typedef QScopedPointer<git_annotated_commit,
+                       GitFree<git_annotated_commit, git_annotated_commit_free>>
+    AnnotatedPtr;
+typedef QScopedPointer<git_index, GitFree<git_index, git_index_free>> IndexPtr;
+typedef QScopedPointer<git_pathspec, GitFree<git_pathspec, git_pathspec_free>>
+    PathspecPtr;
+
+QMutex GitWorker::workersMutex;
+QHash<QString, GitWorker *> GitWorker::workers;
+
+/*!
+    \class PathSpec
+    \brief Keeps the encoded paths of a git_strarray alive.
+ */
+class PathSpec {
+  QList<QByteArray> encoded;
+  QVector<char *> pointers;
+
+public:
+  git_strarray array;
+
+  explicit PathSpec(const QStringList &paths) {
+    foreach (const QString &path, paths)
+      encoded << QFile::encodeName(path);
+    for (int i = 0; i < encoded.size(); ++i)
+      pointers << encoded[i].data();
+    array.strings = pointers.data();
+    array.count = pointers.size();
+  }
+};
+
+/**
+ * @brief credentials ask the ssh agent once, gives up when it has no key
+ * instead of letting libgit2 retry forever.
+ */
+static int credentials(git_cred **out, const char *url,
+                       const char *usernameFromUrl, unsigned int allowedTypes,
+                       void *payload) {
+  Q_UNUSED(url)
+  int *attempts = static_cast<int *>(payload);
+  if ((*attempts)++ > 0)
+    return GIT_EUSER;
+  if (allowedTypes & GIT_CREDTYPE_SSH_KEY)
+    return git_cred_ssh_key_from_agent(
+        out, usernameFromUrl ? usernameFromUrl : "git");
+  if (allowedTypes & GIT_CREDTYPE_DEFAULT)
+    return git_cred_default_new(out);
+  return GIT_EUSER;
+}
+
+/**
+ * @brief copyPath copy a file or a whole folder.
+ */
+static bool copyPath(const QString &src, const QString &dest) {
+  if (!QFileInfo(src).isDir())
+    return QFile::copy(src, dest);
+  if (!QDir().mkpath(dest))
+    return false;
+  QDir srcDir(src);
+  QDirIterator it(src, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    QString path = it.next();
+    QString target = QDir(dest).filePath(srcDir.relativeFilePath(path));
+    if (it.fileInfo().isDir() ? !QDir().mkpath(target)
+                              : !QFile::copy(path, target))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief GitWorker::GitWorker
+ * @param parent
+ */
+GitWorker::GitWorker(QObject *parent)
+    : QObject(parent), repo(Q_NULLPTR), index(Q_NULLPTR), thread(Q_NULLPTR),
+      users(0) {
+  git_libgit2_init();
+}
+
+/**
+ * @brief GitWorker::~GitWorker close the repository.
+ */
+GitWorker::~GitWorker() {
+  close();
+  git_libgit2_shutdown();
+}
+
+/**
+ * @brief GitWorker::handles whether a git command line can be run in-process.
+ * @param args  arguments as they would be given to the git executable
+ */
+bool GitWorker::handles(const QStringList &args) {
+  static const QStringList commands = {"init", "add",    "rm",   "mv",
+                                       "cp",   "commit", "pull", "push"};
+  return !args.isEmpty() && commands.contains(args.first());
+}
+
+/**
+ * @brief GitWorker::acquire the worker of the store workDir is in, started on
+ * its own thread when nobody uses it yet.
+ * @param workDir   folder the git executable would be started in
+ * @return the worker, give it back with release()
+ */
+GitWorker *GitWorker::acquire(const QString &workDir) {
+  QString store = QDir::cleanPath(workDir);
+  QMutexLocker lock(&workersMutex);
+  GitWorker *worker = workers.value(store, Q_NULLPTR);
+  if (worker == Q_NULLPTR) {
+    worker = new GitWorker;
+    worker->store = store;
+    worker->thread = new QThread;
+    worker->moveToThread(worker->thread);
+    worker->thread->start();
+    workers.insert(store, worker);
+  }
+  ++worker->users;
+  return worker;
+}
+
+/**
+ * @brief GitWorker::release give back a worker from acquire(), the last user
+ * stops its thread and closes the repository.
+ * @param worker
+ */
+void GitWorker::release(GitWorker *worker) {
+  if (worker == Q_NULLPTR)
+    return;
+  QMutexLocker lock(&workersMutex);
+  if (--worker->users > 0)
+    return;
+  workers.remove(worker->store);
+  worker->thread->quit();
+  worker->thread->wait();
+  delete worker->thread;
+  delete worker;
+}
+
+/**
+ * @brief GitWorker::run run a command and report through finished(), used
+ * from the queue of the Executor.
+ * @param requester   passed on to finished(), the worker is shared
+ * @param workDir
+ * @param args
+ */
+void GitWorker::run(QObject *requester, const QString &workDir,
+                    const QStringList &args) {
+  QString out, err;
+  int exitCode = execute(workDir, args, &out, &err);
+  emit finished(requester, exitCode, out, err);
+}
+
+/**
+ * @brief GitWorker::execute run a command, safe to call from any thread.
+ * @param workDir   folder the git executable would be started in
+ * @param args      arguments as they would be given to the git executable
+ * @param out
+ * @param err
+ * @return 0 on success, 1 otherwise
+ */
+int GitWorker::execute(const QString &workDir, const QStringList &args,
+                       QString *out, QString *err) {
+  QMutexLocker lock(&mutex);
+  QString output;
+  giterr_clear();
+
+  bool ok = false;
+  QString command = args.value(0);
+  if (command == "init") {
+    ok = init(args, &output);
+  } else if (!open(workDir)) {
+    ok = false;
+  } else if (command == "add") {
+    ok = add(workDir, args);
+  } else if (command == "rm") {
+    ok = remove(workDir, args);
+  } else if (command == "mv" || command == "cp") {
+    ok = move(workDir, args, command == "cp");
+  } else if (command == "commit") {
+    ok = commit(workDir, args, &output);
+  } else if (command == "pull") {
+    ok = pull(&output);
+  } else if (command == "push") {
+    ok = push(&output);
+  }
+
+  if (out != Q_NULLPTR)
+    *out = output;
+  if (!ok) {
+    const git_error *error = giterr_last();
+    QString message = error ? QString::fromUtf8(error->message)
+                            : QString("git %1 failed").arg(command);
+    dbgGit() << args << message;
+    if (err != Q_NULLPTR)
+      *err = message;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief GitWorker::open open the repository of workDir, or refresh the index
+ * of the one that is already open.
+ */
+bool GitWorker::open(const QString &workDir) {
+  if (repo != Q_NULLPTR && workTree == workDir)
+    return git_index_read(index, false) == 0;
+
+  close();
+  if (git_repository_open_ext(&repo, QFile::encodeName(workDir).constData(), 0,
+                              Q_NULLPTR) != 0 ||
+      git_repository_index(&index, repo) != 0) {
+    close();
+    return false;
+  }
+  workTree = workDir;
+  return true;
+}
+
+/**
+ * @brief GitWorker::close
+ */
+void GitWorker::close() {
+  if (index != Q_NULLPTR)
+    git_index_free(index);
+  if (repo != Q_NULLPTR)
+    git_repository_free(repo);
+  index = Q_NULLPTR;
+  repo = Q_NULLPTR;
+  workTree.clear();
+}
+
+/**
+ * @brief GitWorker::relativePath path inside the repository for a path given
+ * relative to the working directory of the command.
+ */
+QString GitWorker::relativePath(const QString &workDir,
+                                const QString &path) const {
+  QDir root(QFile::decodeName(git_repository_workdir(repo)));
+  return QDir::cleanPath(
+      root.relativeFilePath(QDir(workDir).absoluteFilePath(path)));
+}
+
+/**
+ * @brief GitWorker::init git init <path>
+ */
+bool GitWorker::init(const QStringList &args, QString *out) {
+  close();
+  QString path = args.value(1);
+  if (git_repository_init(&repo, QFile::encodeName(path).constData(),
+                          false) != 0 ||
+      git_repository_index(&index, repo) != 0) {
+    close();
+    return false;
+  }
+  workTree = path;
+  *out = "Initialized empty Git repository in " + path;
+  return true;
+}
+
+/**
+ * @brief GitWorker::add git add <path>...
+ */
+bool GitWorker::add(const QString &workDir, const QStringList &args) {
+  QStringList paths;
+  foreach (const QString &arg, args.mid(1)) {
+    if (!arg.startsWith('-'))
+      paths << relativePath(workDir, arg);
+  }
+  return stage(paths);
+}
+
+/**
+ * @brief GitWorker::remove git rm [-f|-rf] <path>...
+ */
+bool GitWorker::remove(const QString &workDir, const QStringList &args) {
+  QStringList paths;
+  foreach (const QString &arg, args.mid(1)) {
+    if (arg.startsWith('-'))
+      continue;
+    QString path = QDir(workDir).absoluteFilePath(arg);
+    if (QFileInfo(path).isDir())
+      QDir(path).removeRecursively();
+    else
+      QFile::remove(path);
+    paths << relativePath(workDir, arg);
+  }
+  PathSpec spec(paths);
+  return git_index_remove_all(index, &spec.array, Q_NULLPTR, Q_NULLPTR) == 0 &&
+         git_index_write(index) == 0;
+}
+
+/**
+ * @brief GitWorker::move git mv [-f] <src>... <dest>, or the same as a copy
+ */
+bool GitWorker::move(const QString &workDir, const QStringList &args,
+                     bool copy) {
+  bool force = args.contains("-f");
+  QStringList paths;
+  foreach (const QString &arg, args.mid(1)) {
+    if (!arg.startsWith('-'))
+      paths << QDir(workDir).absoluteFilePath(arg);
+  }
+  QString destination = paths.isEmpty() ? QString() : paths.takeLast();
+  bool intoDir = QFileInfo(destination).isDir();
+  if (paths.isEmpty() || (paths.size() > 1 && !intoDir)) {
+    giterr_set_str(GITERR_INVALID,
+                   "usage: git mv [-f] <source>... <destination>");
+    return false;
+  }
+
+  QStringList removed, added;
+  foreach (const QString &src, paths) {
+    QString dest = intoDir
+                       ? QDir(destination).filePath(QFileInfo(src).fileName())
+                       : destination;
+    if (QFileInfo(dest).exists()) {
+      if (!force) {
+        giterr_set_str(GITERR_INVALID, "destination exists");
+        return false;
+      }
+      if (QFileInfo(dest).isDir())
+        QDir(dest).removeRecursively();
+      else
+        QFile::remove(dest);
+    }
+    if (copy ? !copyPath(src, dest) : !QDir().rename(src, dest)) {
+      giterr_set_str(GITERR_OS, "could not write destination");
+      return false;
+    }
+    if (!copy)
+      removed << relativePath(workDir, src);
+    added << relativePath(workDir, dest);
+  }
+
+  if (!removed.isEmpty()) {
+    PathSpec spec(removed);
+    if (git_index_remove_all(index, &spec.array, Q_NULLPTR, Q_NULLPTR) != 0)
+      return false;
+  }
+  return stage(added);
+}
+
+/**
+ * @brief GitWorker::commit git commit -m <msg> [--] [<path>...], paths are
+ * staged first like git does and only they are committed, other staged
+ * changes stay in the index.
+ */
+bool GitWorker::commit(const QString &workDir, const QStringList &args,
+                       QString *out) {
+  QString message;
+  QStringList paths;
+  for (int i = 1; i < args.size(); ++i) {
+    const QString &arg = args.at(i);
+    if (arg == "-m")
+      message = args.value(++i);
+    else if (!arg.isEmpty() && !arg.startsWith('-'))
+      paths << relativePath(workDir, arg);
+  }
+  if (paths.isEmpty())
+    return createCommit(index, message, Q_NULLPTR, out);
+
+  git_index *rawPartial;
+  if (!stage(paths) || git_index_new(&rawPartial) != 0)
+    return false;
+  IndexPtr partial(rawPartial);
+  return stagedOnly(paths, partial.data()) &&
+         createCommit(partial.data(), message, Q_NULLPTR, out);
+}
+
+/**
+ * @brief GitWorker::pull fetch origin and merge the upstream of the current
+ * branch, fast-forwarding when possible.
+ */
+bool GitWorker::pull(QString *out) {
+  git_remote *rawRemote;
+  if (git_remote_lookup(&rawRemote, repo, "origin") != 0)
+    return false;
+  RemotePtr remote(rawRemote);
+
+  int attempts = 0;
+  git_fetch_options fetchOptions = GIT_FETCH_OPTIONS_INIT;
+  fetchOptions.callbacks.credentials = credentials;
+  fetchOptions.callbacks.payload = &attempts;
+  if (git_remote_fetch(remote.data(), Q_NULLPTR, &fetchOptions, Q_NULLPTR) != 0)
+    return false;
+
+  git_reference *rawHead, *rawUpstream;
+  if (git_repository_head(&rawHead, repo) != 0)
+    return false;
+  ReferencePtr head(rawHead);
+  if (git_branch_upstream(&rawUpstream, head.data()) != 0)
+    return false;
+  ReferencePtr upstream(rawUpstream);
+
+  git_annotated_commit *rawTheirs;
+  if (git_annotated_commit_from_ref(&rawTheirs, repo, upstream.data()) != 0)
+    return false;
+  AnnotatedPtr theirs(rawTheirs);
+  const git_annotated_commit *heads[] = {theirs.data()};
+
+  git_merge_analysis_t analysis;
+  git_merge_preference_t preference;
+  if (git_merge_analysis(&analysis, &preference, repo, heads, 1) != 0)
+    return false;
+
+  if (analysis & GIT_MERGE_ANALYSIS_UP_TO_DATE) {
+    *out = "Already up to date.";
+    return true;
+  }
+
+  const git_oid *theirId = git_annotated_commit_id(theirs.data());
+  git_checkout_options checkoutOptions = GIT_CHECKOUT_OPTIONS_INIT;
+  checkoutOptions.checkout_strategy = GIT_CHECKOUT_SAFE;
+
+  if (analysis & GIT_MERGE_ANALYSIS_FASTFORWARD &&
+      !(preference & GIT_MERGE_PREFERENCE_NO_FASTFORWARD)) {
+    git_object *rawTarget;
+    git_reference *rawMoved;
+    if (git_object_lookup(&rawTarget, repo, theirId, GIT_OBJ_COMMIT) != 0)
+      return false;
+    ObjectPtr target(rawTarget);
+    if (git_checkout_tree(repo, target.data(), &checkoutOptions) != 0 ||
+        git_reference_set_target(&rawMoved, head.data(), theirId,
+                                 "pull: Fast-forward") != 0)
+      return false;
+    ReferencePtr moved(rawMoved);
+    *out = "Fast-forward";
+    return git_index_read(index, true) == 0;
+  }
+
+  git_merge_options mergeOptions = GIT_MERGE_OPTIONS_INIT;
+  if (git_merge(repo, heads, 1, &mergeOptions, &checkoutOptions) != 0 ||
+      git_index_read(index, true) != 0)
+    return false;
+  if (git_index_has_conflicts(index)) {
+    giterr_set_str(GITERR_MERGE, "Automatic merge failed; fix conflicts and "
+                                 "then commit the result.");
+    return false;
+  }
+
+  QString message = QString("Merge branch '%1'")
+                        .arg(QString::fromUtf8(
+                            git_reference_shorthand(upstream.data())));
+  if (!createCommit(index, message, theirId, out))
+    return false;
+  return git_repository_state_cleanup(repo) == 0;
+}
+
+/**
+ * @brief GitWorker::push push the current branch to origin.
+ */
+bool GitWorker::push(QString *out) {
+  git_remote *rawRemote;
+  git_reference *rawHead;
+  if (git_remote_lookup(&rawRemote, repo, "origin") != 0)
+    return false;
+  RemotePtr remote(rawRemote);
+  if (git_repository_head(&rawHead, repo) != 0)
+    return false;
+  ReferencePtr head(rawHead);
+
+  QByteArray refspec = git_reference_name(head.data());
+  refspec += ":" + refspec;
+  PathSpec refspecs(QStringList() << QString::fromUtf8(refspec));
+
+  int attempts = 0;
+  git_push_options pushOptions = GIT_PUSH_OPTIONS_INIT;
+  pushOptions.callbacks.credentials = credentials;
+  pushOptions.callbacks.payload = &attempts;
+  if (git_remote_push(remote.data(), &refspecs.array, &pushOptions) != 0)
+    return false;
+  *out = "To " + QString::fromUtf8(git_remote_url(remote.data()));
+  return true;
+}
+
+/**
+ * @brief GitWorker::stage add new and changed files and drop deleted ones
+ * below paths from the index.
+ */
+bool GitWorker::stage(const QStringList &paths) {
+  PathSpec spec(paths);
+  return git_index_add_all(index, &spec.array, GIT_INDEX_ADD_DEFAULT,
+                           Q_NULLPTR, Q_NULLPTR) == 0 &&
+         git_index_update_all(index, &spec.array, Q_NULLPTR, Q_NULLPTR) == 0 &&
+         git_index_write(index) == 0;
+}
+
+/**
+ * @brief GitWorker::stagedOnly fill partial with the tree of HEAD and, for
+ * what is below paths, the entries of the index on top.
+ */
+bool GitWorker::stagedOnly(const QStringList &paths, git_index *partial) {
+  int unborn = git_repository_head_unborn(repo);
+  if (unborn < 0)
+    return false;
+  if (unborn == 0) {
+    git_object *rawHead;
+    if (git_revparse_single(&rawHead, repo, "HEAD^{tree}") != 0)
+      return false;
+    ObjectPtr head(rawHead);
+    if (git_index_read_tree(partial,
+                            reinterpret_cast<git_tree *>(head.data())) != 0)
+      return false;
+  }
+
+  PathSpec spec(paths);
+  git_pathspec *rawMatcher;
+  if (git_index_remove_all(partial, &spec.array, Q_NULLPTR, Q_NULLPTR) != 0 ||
+      git_pathspec_new(&rawMatcher, &spec.array) != 0)
+    return false;
+  PathspecPtr matcher(rawMatcher);
+  for (size_t i = 0; i < git_index_entrycount(index); ++i) {
+    const git_index_entry *entry = git_index_get_byindex(index, i);
+    if (git_pathspec_matches_path(matcher.data(), GIT_PATHSPEC_DEFAULT,
+                                  entry->path) == 1 &&
+        git_index_add(partial, entry) != 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief GitWorker::createCommit commit an index on top of HEAD.
+ * @param from      the index of the repository or one built in memory
+ * @param message
+ * @param mergeHead second parent when concluding a merge
+ * @param out       summary line like the one of git commit
+ */
+bool GitWorker::createCommit(git_index *from, const QString &message,
+                             const git_oid *mergeHead, QString *out) {
+  git_oid treeId, headId, commitId;
+  git_tree *rawTree;
+  git_signature *rawSignature;
+  if (git_index_write_tree_to(&treeId, from, repo) != 0 ||
+      git_tree_lookup(&rawTree, repo, &treeId) != 0)
+    return false;
+  TreePtr tree(rawTree);
+  if (git_signature_default(&rawSignature, repo) != 0)
+    return false;
+  SignaturePtr signature(rawSignature);
+
+  CommitPtr parent, merged;
+  const git_commit *parents[2];
+  int parentCount = 0;
+  git_commit *rawCommit;
+  if (git_reference_name_to_id(&headId, repo, "HEAD") == 0) {
+    if (git_commit_lookup(&rawCommit, repo, &headId) != 0)
+      return false;
+    parent.reset(rawCommit);
+    parents[parentCount++] = rawCommit;
+    if (mergeHead == Q_NULLPTR &&
+        git_oid_equal(git_commit_tree_id(rawCommit), &treeId)) {
+      giterr_set_str(GITERR_INVALID, "nothing to commit, working tree clean");
+      return false;
+    }
+  }
+  if (mergeHead != Q_NULLPTR) {
+    if (git_commit_lookup(&rawCommit, repo, mergeHead) != 0)
+      return false;
+    merged.reset(rawCommit);
+    parents[parentCount++] = rawCommit;
+  }
+
+  QByteArray utf8 = message.toUtf8();
+  if (git_commit_create(&commitId, repo, "HEAD", signature.data(),
+                        signature.data(), Q_NULLPTR, utf8.constData(),
+                        tree.data(), parentCount, parents) != 0)
+    return false;
+
+  char shortId[8];
+  git_oid_tostr(shortId, sizeof(shortId), &commitId);
+  *out = QString("[%1] %2").arg(QString::fromLatin1(shortId), message);
+  return true;
+}
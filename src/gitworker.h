@@ -0,0 +1,88 @@
+#ifndef GITWORKER_H_
+#define GITWORKER_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+
+struct git_repository;
+struct git_index;
+struct git_oid;
+
+/*!
+    \class GitWorker
+    \brief Runs the git commands QtPass needs with libgit2 instead of
+    starting the git executable.
+
+    The worker lives on its own thread, the repository and its index stay
+    open between commands and are only re-read when they changed on disk.
+    Commands are given with the same arguments the git executable would get.
+    There is one worker per store, shared by every Executor through
+    acquire() and release(), so commands on the same repository never run
+    at the same time.
+ */
+class GitWorker : public QObject {
+  Q_OBJECT
+
+public:
+  explicit GitWorker(QObject *parent = 0);
+  ~GitWorker();
+
+  static bool handles(const QStringList &args);
+  static GitWorker *acquire(const QString &workDir);
+  static void release(GitWorker *worker);
+
+  int execute(const QString &workDir, const QStringList &args,
+              QString *out = Q_NULLPTR, QString *err = Q_NULLPTR);
+
+public slots:
+  void run(QObject *requester, const QString &workDir,
+           const QStringList &args);
+
+signals:
+  /**
+   * @brief finished a command started with run() is done.
+   *
+   * @param requester   the object given to run()
+   * @param exitCode    0 on success, like the git executable
+   * @param output      what git would have written to stdout
+   * @param errout      error message from libgit2
+   */
+  void finished(QObject *requester, int exitCode, const QString &output,
+                const QString &errout);
+
+private:
+  QMutex mutex;
+  git_repository *repo;
+  git_index *index;
+  QString workTree;
+  QString store;
+  QThread *thread;
+  int users;
+
+  static QMutex workersMutex;
+  static QHash<QString, GitWorker *> workers;
+
+  bool open(const QString &workDir);
+  void close();
+
+  QString relativePath(const QString &workDir, const QString &path) const;
+
+  bool init(const QStringList &args, QString *out);
+  bool add(const QString &workDir, const QStringList &args);
+  bool remove(const QString &workDir, const QStringList &args);
+  bool move(const QString &workDir, const QStringList &args, bool copy);
+  bool commit(const QString &workDir, const QStringList &args,
+              QString *out);
+  bool pull(QString *out);
+  bool push(QString *out);
+
+  bool stage(const QStringList &paths);
+  bool stagedOnly(const QStringList &paths, git_index *partial);
+  bool createCommit(git_index *from, const QString &message,
+                    const git_oid *mergeHead, QString *out);
+};
+
+#endif // GITWORKER_H_
@@ -0,0 +1,316 @@
+#include "gpgkeyring.h"
+#include "colonreader.h"
+#include "debughelper.h"
+#include "qtpasssettings.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSet>
+
+/**
+ * @brief GpgKeyring::GpgKeyring nothing is loaded until the first lookup or
+ * GpgKeyring::refresh.
+ * @param parent
+ */
+GpgKeyring::GpgKeyring(QObject *parent)
+    : QObject(parent), stage(IDLE), loaded(false), refreshAgain(false) {
+  process.setStandardErrorFile(QProcess::nullDevice());
+  connect(&process,
+          static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(
+              &QProcess::finished),
+          this, &GpgKeyring::processFinished);
+  connect(&process,
+          static_cast<void (QProcess::*)(QProcess::ProcessError)>(
+              &QProcess::error),
+          this, &GpgKeyring::processError);
+
+  // gpg rewrites several files at once, only refresh when it is done
+  refreshTimer.setSingleShot(true);
+  refreshTimer.setInterval(500);
+  connect(&refreshTimer, &QTimer::timeout, this, &GpgKeyring::refresh);
+  connect(&watcher, &QFileSystemWatcher::directoryChanged, this,
+          &GpgKeyring::keyringChanged);
+  connect(&watcher, &QFileSystemWatcher::fileChanged, this,
+          &GpgKeyring::keyringChanged);
+}
+
+/**
+ * @brief GpgKeyring::keys all public keys, have_secret is set for the ones we
+ * also have the secret key for.
+ * @return
+ */
+KeyTable GpgKeyring::keys() {
+  ensureLoaded();
+  return keyIndex.keys();
+}
+
+/**
+ * @brief GpgKeyring::secretKeys the keys we can decrypt with.
+ * @return
+ */
+QList<UserInfo> GpgKeyring::secretKeys() {
+  ensureLoaded();
+  return secretList;
+}
+
+/**
+ * @brief GpgKeyring::find public keys matching a key specification.
+ * @param keystring
+ * @return
+ * @sa KeyIndex::find
+ */
+QList<UserInfo> GpgKeyring::find(const QString &keystring) {
+  ensureLoaded();
+  return keyIndex.find(keystring);
+}
+
+/**
+ * @brief GpgKeyring::index the current keys, for batch lookups.
+ * @return
+ */
+const KeyIndex &GpgKeyring::index() {
+  ensureLoaded();
+  return keyIndex;
+}
+
+/**
+ * @brief GpgKeyring::parseKeys turn gpg --with-colons output into UserInfo.
+ * @param colons output of --list-keys or --list-secret-keys
+ * @param secret whether colons lists secret keys
+ * @param uids receives all user ids of every key when given
+ * @return
+ */
+QList<UserInfo> GpgKeyring::parseKeys(const QByteArray &colons, bool secret,
+                                      QList<QStringList> *uids) {
+  QList<UserInfo> users;
+  QStringList current_uids;
+  UserInfo *current_user = Q_NULLPTR;
+  bool primary = false;
+  ColonReader record(colons);
+  while (record.next()) {
+    if (record.fieldCount() < 10)
+      continue;
+    if (record.fieldIs(0, secret ? "sec" : "pub")) {
+      if (current_user != Q_NULLPTR && uids != Q_NULLPTR)
+        uids->append(current_uids);
+      current_uids.clear();
+      users.append(UserInfo());
+      current_user = &users.last();
+      primary = true;
+      current_user->key_id = record.text(4);
+      current_user->name = record.text(9);
+      if (record.firstChar(1) != '\0')
+        current_user->validity = record.firstChar(1);
+      current_user->created.setTime_t(record.number(5));
+      current_user->expiry.setTime_t(record.number(6));
+      // GnuPG 1 puts the primary user id on the key line
+      if (!current_user->name.isEmpty())
+        current_uids << current_user->name;
+    } else if (current_user == Q_NULLPTR) {
+      continue;
+    } else if (record.fieldIs(0, "sub") || record.fieldIs(0, "ssb")) {
+      primary = false;
+      current_user->subkey_ids << record.text(4);
+    } else if (record.fieldIs(0, "fpr")) {
+      if (primary && current_user->fingerprint.isEmpty())
+        current_user->fingerprint = record.text(9);
+      else if (!primary &&
+               current_user->subkey_fingerprints.size() <
+                   current_user->subkey_ids.size())
+        current_user->subkey_fingerprints << record.text(9);
+    } else if (record.fieldIs(0, "uid")) {
+      QString uid = record.text(9);
+      if (current_user->name.isEmpty())
+        current_user->name = uid;
+      current_uids << uid;
+    }
+  }
+  if (current_user != Q_NULLPTR && uids != Q_NULLPTR)
+    uids->append(current_uids);
+  return users;
+}
+
+/**
+ * @brief GpgKeyring::parseKeys convenience for output that was already
+ * decoded.
+ * @param colons
+ * @param secret
+ * @param uids
+ * @return
+ */
+QList<UserInfo> GpgKeyring::parseKeys(const QString &colons, bool secret,
+                                      QList<QStringList> *uids) {
+  return parseKeys(colons.toUtf8(), secret, uids);
+}
+
+/**
+ * @brief GpgKeyring::refresh re-read the keyring in the background, a refresh
+ * asked for while one is running is done right after it.
+ */
+void GpgKeyring::refresh() {
+  if (stage != IDLE) {
+    refreshAgain = true;
+    return;
+  }
+  start(PUBLIC);
+}
+
+/**
+ * @brief GpgKeyring::processFinished a listing is done, parse it and continue
+ * with the next one.
+ * @param exitCode
+ * @param exitStatus
+ */
+void GpgKeyring::processFinished(int exitCode,
+                                 QProcess::ExitStatus exitStatus) {
+  if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+    dbg() << "Listing keys failed" << exitCode;
+    finishRefresh(false);
+    return;
+  }
+  QByteArray output = process.readAllStandardOutput();
+  if (stage == PUBLIC) {
+    newUids.clear();
+    newPublicKeys = parseKeys(output, false, &newUids);
+    start(SECRET);
+    return;
+  }
+  secretList = parseKeys(output, true);
+  QSet<QString> secretIds;
+  foreach (const UserInfo &sec, secretList)
+    secretIds << sec.key_id.toUpper();
+  for (QList<UserInfo>::iterator it = newPublicKeys.begin();
+       it != newPublicKeys.end(); ++it)
+    it->have_secret = secretIds.contains(it->key_id.toUpper());
+  keyIndex = KeyIndex(newPublicKeys, newUids);
+  newPublicKeys.clear();
+  newUids.clear();
+  finishRefresh(true);
+}
+
+/**
+ * @brief GpgKeyring::processError gpg could not be started at all.
+ * @param error
+ */
+void GpgKeyring::processError(QProcess::ProcessError error) {
+  if (error == QProcess::FailedToStart && stage != IDLE)
+    finishRefresh(false);
+}
+
+/**
+ * @brief GpgKeyring::keyringChanged something changed in the GnuPG home.
+ */
+void GpgKeyring::keyringChanged() { refreshTimer.start(); }
+
+/**
+ * @brief GpgKeyring::ensureLoaded make sure known changes are in, the first
+ * lookup and lookups during a refresh have to wait for gpg. Usually nothing
+ * changed and the parsed keys are used right away. A gpg that hangs, for
+ * example on a locked keyring, is given up on after loadTimeout and the keys
+ * we already had are used.
+ */
+void GpgKeyring::ensureLoaded() {
+  if (refreshTimer.isActive()) {
+    refreshTimer.stop();
+    refresh();
+  }
+  if (!loaded && stage == IDLE)
+    start(PUBLIC);
+  QElapsedTimer waited;
+  waited.start();
+  while (stage != IDLE) {
+    int left = loadTimeout - static_cast<int>(waited.elapsed());
+    if (left > 0 && process.waitForFinished(left))
+      continue;
+    if (stage == IDLE)
+      break;
+    dbg() << "Listing keys timed out";
+    refreshAgain = false;
+    process.blockSignals(true);
+    process.kill();
+    process.waitForFinished(1000);
+    process.blockSignals(false);
+    finishRefresh(false);
+  }
+}
+
+/**
+ * @brief GpgKeyring::start run gpg for one of the listings.
+ * @param next
+ */
+void GpgKeyring::start(Stage next) {
+  stage = next;
+  QStringList env = QProcess::systemEnvironment();
+  if (!QtPassSettings::getGpgHome().isEmpty())
+    env << "GNUPGHOME=" + keyringHome();
+  process.setEnvironment(env);
+  QStringList args = {"--no-tty", "--with-colons", "--with-fingerprint",
+                      next == SECRET ? "--list-secret-keys" : "--list-keys"};
+  process.start(QtPassSettings::getGpgExecutable(), args);
+}
+
+/**
+ * @brief GpgKeyring::finishRefresh back to idle, on failure the keys we
+ * already had are kept.
+ * @param succeeded
+ */
+void GpgKeyring::finishRefresh(bool succeeded) {
+  stage = IDLE;
+  loaded = true;
+  watch();
+  if (succeeded)
+    emit keysChanged();
+  if (refreshAgain) {
+    refreshAgain = false;
+    refresh();
+  }
+}
+
+/**
+ * @brief GpgKeyring::watch keep an eye on the GnuPG home and the keyring
+ * files in it, files are watched again after gpg replaced them.
+ */
+void GpgKeyring::watch() {
+  QDir home(keyringHome());
+  QStringList wanted;
+  if (home.exists())
+    wanted << home.absolutePath();
+  QStringList files = {"pubring.kbx", "pubring.gpg", "secring.gpg",
+                       "trustdb.gpg"};
+  foreach (const QString &file, files) {
+    if (home.exists(file))
+      wanted << home.absoluteFilePath(file);
+  }
+
+  QStringList watched = watcher.directories() + watcher.files();
+  QStringList stale;
+  foreach (const QString &path, watched) {
+    if (!wanted.contains(path))
+      stale << path;
+  }
+  if (!stale.isEmpty())
+    watcher.removePaths(stale);
+  QStringList missing;
+  foreach (const QString &path, wanted) {
+    if (!watched.contains(path))
+      missing << path;
+  }
+  if (!missing.isEmpty())
+    watcher.addPaths(missing);
+}
+
+/**
+ * @brief GpgKeyring::keyringHome the GnuPG home directory in use.
+ * @return
+ */
+QString GpgKeyring::keyringHome() {
+  QString home = QtPassSettings::getGpgHome();
+  if (home.isEmpty())
+    home = qgetenv("GNUPGHOME");
+  if (home.isEmpty())
+#ifdef Q_OS_WIN
+    home = QDir(qgetenv("APPDATA")).filePath("gnupg");
+#else
+    home = QDir::home().filePath(".gnupg");
+#endif
+  return QDir(home).absolutePath();
+}
@@ -0,0 +1,81 @@
+#ifndef GPGKEYRING_H_
+#define GPGKEYRING_H_
+
+#include "datahelpers.h"
+#include "keyindex.h"
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+
+/*!
+    \class GpgKeyring
+    \brief Parsed copy of the GnuPG keyring, shared by everything that needs
+    to list or look up keys.
+
+    gpg is run in the background when the keyring changes on disk, lookups
+    are answered from the parsed keys without starting gpg.
+ */
+class GpgKeyring : public QObject {
+  Q_OBJECT
+
+public:
+  explicit GpgKeyring(QObject *parent = 0);
+
+  KeyTable keys();
+  QList<UserInfo> secretKeys();
+  QList<UserInfo> find(const QString &keystring);
+  const KeyIndex &index();
+
+  static QList<UserInfo> parseKeys(const QByteArray &colons, bool secret,
+                                   QList<QStringList> *uids = Q_NULLPTR);
+  static QList<UserInfo> parseKeys(const QString &colons, bool secret,
+                                   QList<QStringList> *uids = Q_NULLPTR);
+
+public slots:
+  void refresh();
+
+signals:
+  /**
+   * @brief keysChanged a refresh finished, the keys might be different.
+   */
+  void keysChanged();
+
+private slots:
+  void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError(QProcess::ProcessError error);
+  void keyringChanged();
+
+private:
+  /**
+   * @brief The Stage enum which listing is running.
+   */
+  enum Stage { IDLE = 0, PUBLIC, SECRET };
+
+  /**
+   * @brief loadTimeout how long a lookup waits for gpg, in milliseconds.
+   */
+  static const int loadTimeout = 5000;
+
+  QProcess process;
+  Stage stage;
+  bool loaded;
+  bool refreshAgain;
+  QFileSystemWatcher watcher;
+  QTimer refreshTimer;
+
+  KeyIndex keyIndex;
+  QList<UserInfo> secretList;
+  QList<UserInfo> newPublicKeys;
+  QList<QStringList> newUids;
+
+  void ensureLoaded();
+  void start(Stage next);
+  void finishRefresh(bool succeeded);
+  void watch();
+
+  static QString keyringHome();
+};
+
+#endif // GPGKEYRING_H_
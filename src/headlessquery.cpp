@@ -0,0 +1,262 @@
+#include "headlessquery.h"
+#include "executorstats.h"
+#include "qtpasssettings.h"
+#include "startuptrace.h"
+#include "tracer.h"
+#include "util.h"
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QTextStream>
+#if SINGLE_APP
+#include "ipcclient.h"
+#endif
+
+/**
+ * @brief HeadlessQuery::HeadlessQuery resolve and decrypt a single entry
+ * without any widgets, only an application object is needed.
+ * @param mode print the entry or copy the password
+ * @param query exact entry name or search words
+ * @param parent
+ */
+HeadlessQuery::HeadlessQuery(Mode mode, const QString &query, QObject *parent)
+    : QObject(parent), mode(mode), query(query) {
+  clearClipboardTimer.setSingleShot(true);
+  connect(&clearClipboardTimer, SIGNAL(timeout()), this,
+          SLOT(clearClipboard()));
+}
+
+/**
+ * @brief HeadlessQuery::parseArguments look for --show or --clip, all other
+ * arguments are joined to the query text. --startup-trace enables
+ * StartupTrace, --trace=<file> the Tracer and --stats the summary of
+ * ExecutorStats.
+ * @param argc
+ * @param argv
+ * @param query receives the remaining arguments separated by spaces
+ * @return requested mode or HeadlessQuery::NONE for the GUI
+ */
+HeadlessQuery::Mode HeadlessQuery::parseArguments(int argc, char *argv[],
+                                                  QString *query) {
+  Mode mode = NONE;
+  QString text;
+  for (int i = 1; i < argc; ++i) {
+    QString arg = QString::fromLocal8Bit(argv[i]);
+    if (mode == NONE && arg == "--show") {
+      mode = SHOW;
+      continue;
+    }
+    if (mode == NONE && arg == "--clip") {
+      mode = CLIP;
+      continue;
+    }
+    if (arg == "--startup-trace") {
+      StartupTrace::enable();
+      continue;
+    }
+    if (arg.startsWith("--trace=")) {
+      Tracer::enable(arg.mid(8));
+      continue;
+    }
+    if (arg == "--stats") {
+      ExecutorStats::enableDump();
+      continue;
+    }
+    if (!text.isEmpty())
+      text += " ";
+    text += arg;
+  }
+  if (query != Q_NULLPTR)
+    *query = text;
+  return mode;
+}
+
+/**
+ * @brief HeadlessQuery::exec start decryption and run the event loop until it
+ * is done.
+ * @return exit code for the process
+ */
+int HeadlessQuery::exec() {
+#if SINGLE_APP
+  // a running instance is already set up, let it do the work
+  IpcResponse response;
+  if (IpcClient().request(mode == SHOW ? IpcRequest::SHOW : IpcRequest::COPY,
+                          query, &response) &&
+      response.status != IpcResponse::BAD_REQUEST &&
+      response.status != IpcResponse::UNSUPPORTED_VERSION) {
+    switch (response.status) {
+    case IpcResponse::OK:
+      if (mode == SHOW && !response.values.isEmpty())
+        printEntry(response.values.first());
+      return 0;
+    case IpcResponse::NOT_FOUND:
+      printNotFound();
+      return 1;
+    case IpcResponse::AMBIGUOUS:
+      printAmbiguous(response.values);
+      return 1;
+    default:
+      QTextStream(stderr) << response.values.join("\n");
+      return 1;
+    }
+  }
+#endif
+
+  QTextStream err(stderr);
+  if (Util::checkConfig()) {
+    err << tr("QtPass is not configured yet, start it once without "
+              "arguments.")
+        << endl;
+    return 1;
+  }
+  QString app = QtPassSettings::isUsePass()
+                    ? QtPassSettings::getPassExecutable()
+                    : QtPassSettings::getGpgExecutable();
+  if (app.isEmpty()) {
+    err << tr("No pass or gpg executable configured.") << endl;
+    return 1;
+  }
+
+  QString entry = resolveEntry();
+  if (entry.isEmpty())
+    return 1;
+
+  Pass *pass = QtPassSettings::getPass();
+  connect(pass, &Pass::finishedShow, this, &HeadlessQuery::passShowHandler);
+  connect(pass, &Pass::processErrorExit, this,
+          &HeadlessQuery::processErrorExit);
+  pass->updateEnv();
+  pass->Show(entry);
+  return QCoreApplication::exec();
+}
+
+/**
+ * @brief HeadlessQuery::resolveEntry find the one entry matching the query,
+ * lists the candidates on stderr when there is more than one.
+ * @return entry name relative to the store or empty on failure
+ */
+QString HeadlessQuery::resolveEntry() {
+  QTextStream err(stderr);
+  if (query.isEmpty()) {
+    err << tr("No password name given.") << endl;
+    return QString();
+  }
+  QStringList entries =
+      Util::findPasswordEntries(QtPassSettings::getPassStore(), query);
+  if (entries.isEmpty()) {
+    printNotFound();
+    return QString();
+  }
+  if (entries.size() > 1) {
+    printAmbiguous(entries);
+    return QString();
+  }
+  return entries.first();
+}
+
+/**
+ * @brief HeadlessQuery::printEntry write decrypted content to stdout.
+ * @param output
+ */
+void HeadlessQuery::printEntry(const QString &output) {
+  QTextStream out(stdout);
+  out << output;
+  if (!output.endsWith("\n"))
+    out << endl;
+  out.flush();
+}
+
+/**
+ * @brief HeadlessQuery::printNotFound nothing matched the query.
+ */
+void HeadlessQuery::printNotFound() {
+  QTextStream(stderr) << tr("No password found for \"%1\".").arg(query)
+                      << endl;
+}
+
+/**
+ * @brief HeadlessQuery::printAmbiguous list the candidates matching the query.
+ * @param entries
+ */
+void HeadlessQuery::printAmbiguous(const QStringList &entries) {
+  QTextStream err(stderr);
+  err << tr("\"%1\" matches more than one password:").arg(query) << endl;
+  foreach (const QString &entry, entries)
+    err << "  " << entry << endl;
+}
+
+/**
+ * @brief HeadlessQuery::passShowHandler print the decrypted entry or copy the
+ * password (first line) to the clipboard.
+ * @param file      the only entry asked for
+ * @param output
+ */
+void HeadlessQuery::passShowHandler(const QString &file,
+                                    const QString &output) {
+  Q_UNUSED(file)
+  if (mode == SHOW) {
+    printEntry(output);
+    QCoreApplication::exit(0);
+  } else {
+    copyTextToClipboard(output.split("\n").at(0));
+  }
+}
+
+/**
+ * @brief HeadlessQuery::processErrorExit decryption failed.
+ * @param exitCode
+ * @param err
+ */
+void HeadlessQuery::processErrorExit(int exitCode, const QString &err) {
+  QTextStream(stderr) << err;
+  QCoreApplication::exit(exitCode != 0 ? exitCode : 1);
+}
+
+/**
+ * @brief HeadlessQuery::copyTextToClipboard copy and stay around as long as
+ * the clipboard needs us.
+ *
+ * On X11 the clipboard content is served by the owning process, so we keep
+ * running until someone else takes the clipboard or autoclear kicks in.
+ * @param text
+ */
+void HeadlessQuery::copyTextToClipboard(const QString &text) {
+  QClipboard *clip = QGuiApplication::clipboard();
+  clip->setText(text, QtPassSettings::isUseSelection() ? QClipboard::Selection
+                                                       : QClipboard::Clipboard);
+  clippedText = text;
+  if (QtPassSettings::isUseAutoclear())
+    clearClipboardTimer.start(1000 * QtPassSettings::getAutoclearSeconds());
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+  connect(clip, SIGNAL(changed(QClipboard::Mode)), this,
+          SLOT(clipboardChanged()));
+#else
+  if (!clearClipboardTimer.isActive())
+    QCoreApplication::exit(0);
+#endif
+}
+
+/**
+ * @brief HeadlessQuery::clipboardChanged quit when another application took
+ * over the clipboard, there is nothing left to serve or clear.
+ */
+void HeadlessQuery::clipboardChanged() {
+  QClipboard *clip = QGuiApplication::clipboard();
+  bool owned = QtPassSettings::isUseSelection() ? clip->ownsSelection()
+                                                : clip->ownsClipboard();
+  if (!owned)
+    QCoreApplication::exit(0);
+}
+
+/**
+ * @brief HeadlessQuery::clearClipboard autoclear, only when the clipboard
+ * still holds our password.
+ */
+void HeadlessQuery::clearClipboard() {
+  QClipboard *clip = QGuiApplication::clipboard();
+  QClipboard::Mode clipMode = QtPassSettings::isUseSelection()
+                                  ? QClipboard::Selection
+                                  : QClipboard::Clipboard;
+  if (clip->text(clipMode) == clippedText)
+    clip->clear(clipMode);
+  QCoreApplication::exit(0);
+}
@@ -0,0 +1,51 @@
+#ifndef HEADLESSQUERY_H_
+#define HEADLESSQUERY_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class Pass;
+
+/*!
+    \class HeadlessQuery
+    \brief Resolves and decrypts a single entry from the commandline without
+    constructing the GUI.
+
+    Used for `qtpass --show <entry>` and `qtpass --clip <entry>`.
+ */
+class HeadlessQuery : public QObject {
+  Q_OBJECT
+
+public:
+  /**
+   * @brief The Mode enum what to do with the decrypted entry.
+   */
+  enum Mode { NONE = 0, SHOW, CLIP };
+
+  HeadlessQuery(Mode mode, const QString &query, QObject *parent = 0);
+
+  static Mode parseArguments(int argc, char *argv[], QString *query);
+  int exec();
+
+private slots:
+  void passShowHandler(const QString &file, const QString &output);
+  void processErrorExit(int exitCode, const QString &err);
+  void clipboardChanged();
+  void clearClipboard();
+
+private:
+  Mode mode;
+  QString query;
+  QString clippedText;
+  QTimer clearClipboardTimer;
+
+  QString resolveEntry();
+  void printEntry(const QString &output);
+  void printNotFound();
+  void printAmbiguous(const QStringList &entries);
+  void copyTextToClipboard(const QString &text);
+};
+
+#endif // HEADLESSQUERY_H_
@@ -1,6 +1,7 @@
 #include "imitatepass.h"
 #include "debughelper.h"
 #include "qtpasssettings.h"
+#include "util.h"
 #include <QDirIterator>
 
 using namespace Enums;
@@ -9,7 +10,14 @@ using namespace Enums;
  * @brief ImitatePass::ImitatePass for situaions when pass is not available
  * we imitate the behavior of pass https://www.passwordstore.org/
  */
-ImitatePass::ImitatePass() {}
+ImitatePass::ImitatePass() {
+  connect(&transactions, &TransactionScheduler::finished, this,
+          &ImitatePass::finished);
+  connect(&transactions, &TransactionScheduler::starting, this,
+          &ImitatePass::startingExecuteWrapper);
+  connect(&transactions, &TransactionScheduler::singleStepFinished, this,
+          &ImitatePass::showFinished);
+}
 
 /**
  * @brief ImitatePass::GitInit git init wrapper
@@ -27,9 +35,16 @@ void ImitatePass::GitPull() { executeGit(GIT_PULL, {"pull"}); }
  * @brief ImitatePass::GitPull_b git pull wrapper
  */
 void ImitatePass::GitPull_b() {
-  exec.executeBlocking(QtPassSettings::getGitExecutable(), {"pull"});
+  exec.executeGitBlocking(QtPassSettings::getPassStore(),
+                          QtPassSettings::getGitExecutable(), {"pull"});
 }
 
+/**
+ * @brief ImitatePass::scheduler git commands claim the "git" resource of
+ * these transactions
+ */
+TransactionScheduler *ImitatePass::scheduler() { return &transactions; }
+
 /**
  * @brief ImitatePass::GitPush git init wrapper
  */
@@ -40,14 +55,36 @@ void ImitatePass::GitPush() {
 }
 
 /**
- * @brief ImitatePass::Show shows content of file
+ * @brief ImitatePass::Show shows content of file, decryptions run side by
+ * side and each result is reported with its file
  */
 
 void ImitatePass::Show(QString file) {
-  file = QtPassSettings::getPassStore() + file + ".gpg";
+  QString path = QtPassSettings::getPassStore() + file + ".gpg";
   QStringList args = {"-d",      "--quiet",     "--yes", "--no-encrypt-to",
-                      "--batch", "--use-agent", file};
-  executeGpg(PASS_SHOW, args);
+                      "--batch", "--use-agent", path};
+  int id = executeGpg(PASS_SHOW, path, args);
+  if (id >= 0)
+    shows.insert(id, file);
+}
+
+/**
+ * @brief ImitatePass::showFinished report a decryption with the file it was
+ * asked for
+ * @param id        step of the decryption
+ * @param exitCode
+ * @param output
+ * @param errout
+ */
+void ImitatePass::showFinished(int id, int exitCode, const QString &output,
+                               const QString &errout) {
+  if (!shows.contains(id))
+    return;
+  QString file = shows.take(id);
+  if (exitCode == 0)
+    emit finishedShow(file, output);
+  else
+    emit failedShow(file, exitCode, errout);
 }
 
 /**
@@ -59,7 +96,7 @@ void ImitatePass::Show(QString file) {
  */
 void ImitatePass::Insert(QString file, QString newValue, bool overwrite) {
   file = file + ".gpg";
-  transactionHelper trans(this, PASS_INSERT);
+  transactionHelper trans(&transactions, PASS_INSERT);
   QStringList recipients = Pass::getRecipientList(file);
   if (recipients.isEmpty()) {
     //  TODO(bezet): probably throw here
@@ -76,11 +113,14 @@ void ImitatePass::Insert(QString file, QString newValue, bool overwrite) {
   if (overwrite)
     args.append("--yes");
   args.append("-");
-  executeGpg(PASS_INSERT, args, newValue);
+  transactions.backupFile(file);
+  executeGpg(PASS_INSERT, file, args, newValue);
   if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit()) {
     //    TODO(bezet) why not?
-    if (!overwrite)
+    if (!overwrite) {
       executeGit(GIT_ADD, {"add", file});
+      undoGit({"reset", "-q", "--", file});
+    }
     QString path = QDir(QtPassSettings::getPassStore()).relativeFilePath(file);
     path.replace(QRegExp("\\.gpg$"), "");
     QString msg =
@@ -99,16 +139,28 @@ void ImitatePass::GitCommit(const QString &file, const QString &msg) {
   executeGit(GIT_COMMIT, {"commit", "-m", msg, "--", file});
 }
 
+/**
+ * @brief ImitatePass::GitCommit commit several files to git at once
+ * @param files
+ * @param msg
+ */
+void ImitatePass::GitCommit(const QStringList &files, const QString &msg) {
+  executeGit(GIT_COMMIT, QStringList() << "commit"
+                                       << "-m" << msg << "--" << files);
+}
+
 /**
  * @brief ImitatePass::Remove custom implementation of "pass remove"
  */
 void ImitatePass::Remove(QString file, bool isDir) {
   file = QtPassSettings::getPassStore() + file;
-  transactionHelper trans(this, PASS_REMOVE);
+  transactionHelper trans(&transactions, PASS_REMOVE);
   if (!isDir)
     file += ".gpg";
   if (QtPassSettings::isUseGit()) {
     executeGit(GIT_RM, {"rm", (isDir ? "-rf" : "-f"), file});
+    undoGit({"checkout", "HEAD", "--", file});
+    undoGit({"reset", "-q", "HEAD", "--", file});
     //  TODO(bezet): commit message used to have pass-like file name inside(ie.
     //  getFile(file, true)
     GitCommit(file, "Remove for " + file + " using QtPass.");
@@ -132,26 +184,27 @@ void ImitatePass::Remove(QString file, bool isDir) {
  * @param users     list of users who shall be able to decrypt passwords in
  * path
  */
-void ImitatePass::Init(QString path, const QList<UserInfo> &users) {
+void ImitatePass::Init(QString path, const KeyTable &users) {
   QString gpgIdFile = path + ".gpg-id";
   QFile gpgId(gpgIdFile);
   bool addFile = false;
-  transactionHelper trans(this, PASS_INIT);
+  transactionHelper trans(&transactions, PASS_INIT);
   if (QtPassSettings::isAddGPGId(true)) {
     QFileInfo checkFile(gpgIdFile);
     if (!checkFile.exists() || !checkFile.isFile())
       addFile = true;
   }
+  transactions.backupFile(gpgIdFile);
   if (!gpgId.open(QIODevice::WriteOnly | QIODevice::Text)) {
     emit critical(tr("Cannot update"),
                   tr("Failed to open .gpg-id for writing."));
     return;
   }
   bool secret_selected = false;
-  foreach (const UserInfo &user, users) {
-    if (user.enabled) {
-      gpgId.write((user.key_id + "\n").toUtf8());
-      secret_selected |= user.have_secret;
+  for (int row = 0; row < users.size(); ++row) {
+    if (users.isEnabled(row)) {
+      gpgId.write((users.keyIdText(row).toString() + "\n").toUtf8());
+      secret_selected |= users.haveSecret(row);
     }
   }
   gpgId.close();
@@ -165,8 +218,10 @@ void ImitatePass::Init(QString path, const QList<UserInfo> &users) {
 
   if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit() &&
       !QtPassSettings::getGitExecutable().isEmpty()) {
-    if (addFile)
+    if (addFile) {
       executeGit(GIT_ADD, {"add", gpgIdFile});
+      undoGit({"reset", "-q", "--", gpgIdFile});
+    }
     QString path = gpgIdFile;
     path.replace(QRegExp("\\.gpg$"), "");
     GitCommit(gpgIdFile, "Added " + path + " using QtPass.");
@@ -203,7 +258,7 @@ bool ImitatePass::removeDir(const QString &dirName) {
 
 /**
  * @brief ImitatePass::reencryptPath reencrypt all files under the chosen
- * directory
+ * directory, as steps of one transaction with a single commit
  *
  * This is stil quite experimental..
  * @param dir
@@ -216,213 +271,577 @@ void ImitatePass::reencryptPath(QString dir) {
     emit statusMsg(tr("Updating password-store"), 2000);
     GitPull_b();
   }
-  QDir currentDir;
-  QDirIterator gpgFiles(dir, QStringList() << "*.gpg", QDir::Files,
-                        QDirIterator::Subdirectories);
+  transactionHelper trans(&transactions, PASS_INIT);
+  QStringList changed = reencryptTree(dir);
+  if (!changed.isEmpty() && !QtPassSettings::isUseWebDav() &&
+      QtPassSettings::isUseGit()) {
+    executeGit(GIT_ADD, QStringList() << "add"
+                                      << "--" << changed);
+    undoGit(QStringList() << "reset"
+                          << "-q"
+                          << "--" << changed);
+    GitCommit(changed, QString("Edit for %1 using QtPass.")
+                           .arg(storeNames(changed).join(", ")));
+  }
+  if (QtPassSettings::isAutoPush()) {
+    emit statusMsg(tr("Updating password-store"), 2000);
+    //  TODO(bezet): this is non-blocking and shall be done outside
+    GitPush();
+  }
+  emit endReencryptPath();
+}
+
+/**
+ * @brief ImitatePass::reencryptTree reencrypt a file, or all files below a
+ * folder, that are not encrypted for the recipients of their folder
+ * @param path
+ * @return the files that were reencrypted
+ */
+QStringList ImitatePass::reencryptTree(const QString &path) {
+  QStringList files;
+  if (QFileInfo(path).isDir()) {
+    QDirIterator gpgFiles(path, QStringList() << "*.gpg", QDir::Files,
+                          QDirIterator::Subdirectories);
+    while (gpgFiles.hasNext())
+      files << gpgFiles.next();
+  } else {
+    files << path;
+  }
+
+  QStringList changed;
+  QString currentDir;
   QStringList gpgId;
-  while (gpgFiles.hasNext()) {
-    QString fileName = gpgFiles.next();
-    if (gpgFiles.fileInfo().path() != currentDir.path()) {
+  foreach (const QString &fileName, files) {
+    QString folder = QFileInfo(fileName).path();
+    if (folder != currentDir) {
+      currentDir = folder;
       gpgId = getRecipientList(fileName);
       gpgId.sort();
     }
-    //  TODO(bezet): enable --with-colons for better future-proofness?
-    QStringList args = {
-        "-v",          "--no-secmem-warning", "--no-permission-warning",
-        "--list-only", "--keyid-format=long", fileName};
-    QString keys, err;
-    exec.executeBlocking(QtPassSettings::getGpgExecutable(), args, &keys, &err);
-    QStringList actualKeys;
-    keys += err;
-    QStringList key = keys.split("\n");
-    QListIterator<QString> itr(key);
-    while (itr.hasNext()) {
-      QString current = itr.next();
-      QStringList cur = current.split(" ");
-      if (cur.length() > 4) {
-        QString actualKey = cur.takeAt(4);
-        if (actualKey.length() == 16) {
-          actualKeys << actualKey;
-        }
+    if (gpgId.isEmpty()) {
+      emit critical(tr("Can not edit"),
+                    tr("Could not read encryption key to use, .gpg-id "
+                       "file missing or invalid."));
+      break;
+    }
+    if (reencryptFile(fileName, gpgId))
+      changed << fileName;
+  }
+  return changed;
+}
+
+/**
+ * @brief ImitatePass::reencryptFile queue reencrypting a file unless it is
+ * encrypted for exactly the given recipients already
+ * @param fileName
+ * @param gpgId     sorted recipients
+ * @return whether the file is reencrypted
+ */
+bool ImitatePass::reencryptFile(const QString &fileName,
+                                const QStringList &gpgId) {
+  //  TODO(bezet): enable --with-colons for better future-proofness?
+  QStringList args = {
+      "-v",          "--no-secmem-warning", "--no-permission-warning",
+      "--list-only", "--keyid-format=long", fileName};
+  QString keys, err;
+  exec.executeBlocking(QtPassSettings::getGpgExecutable(), args, &keys, &err);
+  QStringList actualKeys;
+  keys += err;
+  QStringList key = keys.split("\n");
+  QListIterator<QString> itr(key);
+  while (itr.hasNext()) {
+    QString current = itr.next();
+    QStringList cur = current.split(" ");
+    if (cur.length() > 4) {
+      QString actualKey = cur.takeAt(4);
+      if (actualKey.length() == 16) {
+        actualKeys << actualKey;
       }
     }
-    actualKeys.sort();
-    if (actualKeys != gpgId) {
-      // dbg()<< actualKeys << gpgId << getRecipientList(fileName);
-      dbg() << "reencrypt " << fileName << " for " << gpgId;
-      QString local_lastDecrypt = "Could not decrypt";
-      args = QStringList{"-d",      "--quiet",     "--yes", "--no-encrypt-to",
-                         "--batch", "--use-agent", fileName};
-      exec.executeBlocking(QtPassSettings::getGpgExecutable(), args,
-                           &local_lastDecrypt);
-
-      if (!local_lastDecrypt.isEmpty() &&
-          local_lastDecrypt != "Could not decrypt") {
-        if (local_lastDecrypt.right(1) != "\n")
-          local_lastDecrypt += "\n";
-
-        QStringList recipients = Pass::getRecipientList(fileName);
-        if (recipients.isEmpty()) {
-          emit critical(tr("Can not edit"),
-                        tr("Could not read encryption key to use, .gpg-id "
-                           "file missing or invalid."));
-          return;
-        }
-        args = QStringList{"--yes", "--batch", "-eq", "--output", fileName};
-        for (auto &i : recipients) {
-          args.append("-r");
-          args.append(i);
-        }
-        args.append("-");
-        exec.executeBlocking(QtPassSettings::getGpgExecutable(), args,
-                             local_lastDecrypt);
-
-        if (!QtPassSettings::isUseWebDav() && QtPassSettings::isUseGit()) {
-          exec.executeBlocking(QtPassSettings::getGitExecutable(),
-                               {"add", fileName});
-          QString path =
-              QDir(QtPassSettings::getPassStore()).relativeFilePath(fileName);
-          path.replace(QRegExp("\\.gpg$"), "");
-          exec.executeBlocking(QtPassSettings::getGitExecutable(),
-                               {"commit", fileName, "-m",
-                                "Edit for " + path + " using QtPass."});
-        }
+  }
+  actualKeys.sort();
+  if (actualKeys == gpgId)
+    return false;
 
-      } else {
-        dbg() << "Decrypt error on re-encrypt";
+  transactions.backupFile(fileName);
+  queueReencrypt(fileName, gpgId);
+  return true;
+}
+
+/**
+ * @brief ImitatePass::queueReencrypt add steps decrypting a file and
+ * encrypting it again for other recipients, the decrypted content is passed
+ * between them and never stored
+ * @param fileName
+ * @param gpgId     recipients
+ */
+void ImitatePass::queueReencrypt(const QString &fileName,
+                                 const QStringList &gpgId) {
+  dbgPass() << "reencrypt" << fileName << "for" << gpgId;
+  int decrypt = executeGpg(PASS_SHOW, fileName,
+                           {"-d", "--quiet", "--yes", "--no-encrypt-to",
+                            "--batch", "--use-agent", fileName});
+  QStringList args = {"--yes", "--batch", "-eq", "--output", fileName};
+  foreach (const QString &recipient, gpgId)
+    args << "-r" << recipient;
+  args << "-";
+  TransactionScheduler::Step encrypt;
+  encrypt.process = PASS_INSERT;
+  encrypt.resources << fileName;
+  encrypt.workDir = QtPassSettings::getPassStore();
+  encrypt.app = QtPassSettings::getGpgExecutable();
+  encrypt.args = args;
+  encrypt.inputFrom = decrypt;
+  transactions.then(encrypt);
+}
+
+/**
+ * @brief ImitatePass::movedReencryptions files of a moved or copied entry
+ * that have to be reencrypted, because their new location has other
+ * recipients than the old one
+ * @param src
+ * @param target        the new path
+ * @param recipients    set to the recipients of the new location
+ * @return the files at their new path
+ */
+QStringList ImitatePass::movedReencryptions(const QString &src,
+                                            const QString &target,
+                                            QStringList *recipients) {
+  QFileInfo srcInfo(src);
+  // a folder with its own .gpg-id takes its recipients along
+  if (srcInfo.isDir() && QFile(QDir(src).filePath(".gpg-id")).exists())
+    return QStringList();
+  *recipients = getRecipientList(target);
+  if (recipients->toSet() == getRecipientList(src).toSet())
+    return QStringList();
+  if (recipients->isEmpty()) {
+    emit critical(tr("Can not edit"),
+                  tr("Could not read encryption key to use, .gpg-id "
+                     "file missing or invalid."));
+    return QStringList();
+  }
+  if (!srcInfo.isDir())
+    return QStringList(target);
+  QStringList files;
+  QDir srcDir(src);
+  QDirIterator gpgFiles(src, QStringList() << "*.gpg", QDir::Files,
+                        QDirIterator::Subdirectories);
+  while (gpgFiles.hasNext()) {
+    QString relative = srcDir.relativeFilePath(gpgFiles.next());
+    // files below a folder with its own .gpg-id keep their recipients
+    QStringList folders = relative.split('/');
+    folders.removeLast();
+    QString folder;
+    bool own = false;
+    foreach (const QString &name, folders) {
+      folder += name + '/';
+      if (QFile::exists(srcDir.filePath(folder + ".gpg-id"))) {
+        own = true;
+        break;
       }
     }
+    if (!own)
+      files << QDir(target).filePath(relative);
   }
-  if (QtPassSettings::isAutoPush()) {
-    emit statusMsg(tr("Updating password-store"), 2000);
-    //  TODO(bezet): this is non-blocking and shall be done outside
-    GitPush();
+  return files;
+}
+
+/**
+ * @brief ImitatePass::entryTarget where an entry ends up when it is moved or
+ * copied
+ * @param src
+ * @param dest  new path, or the folder to put a file in
+ * @return the new path
+ */
+QString ImitatePass::entryTarget(const QString &src, const QString &dest) {
+  QFileInfo srcFileInfo(src);
+  if (srcFileInfo.isFile() && QFileInfo(dest).isDir())
+    return QDir(dest).filePath(srcFileInfo.fileName());
+  return dest;
+}
+
+/**
+ * @brief ImitatePass::canPlace whether an entry may be moved or copied to a
+ * path, a folder is never put inside itself and nothing but a file asked to
+ * be replaced is overwritten
+ * @param src
+ * @param target    the new path
+ * @param force     replace an existing file
+ * @param copy      copy instead of move
+ * @return false after telling the user why not
+ */
+bool ImitatePass::canPlace(const QString &src, const QString &target,
+                           bool force, bool copy) {
+  QString title = copy ? tr("Can not copy") : tr("Can not move");
+  if (QFileInfo(src).isDir() && Util::isInside(target, src)) {
+    emit critical(title, tr("%1 can not be put inside itself.").arg(src));
+    return false;
   }
-  emit endReencryptPath();
+  QFileInfo targetInfo(target);
+  if (targetInfo.exists() && !(force && targetInfo.isFile())) {
+    emit critical(title, tr("%1 already exists.").arg(target));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief ImitatePass::placeEntry move or copy a file or folder on disk and
+ * register how to undo it
+ * @param src
+ * @param target    the new path, checked with canPlace()
+ * @param copy      copy instead of move
+ * @return false after telling the user it failed
+ */
+bool ImitatePass::placeEntry(const QString &src, const QString &target,
+                             bool copy) {
+  bool isDir = QFileInfo(src).isDir();
+  if (QFileInfo(target).exists()) {
+    // only a file asked to be replaced gets here
+    transactions.backupFile(target);
+    QFile::remove(target);
+  }
+  bool placed;
+  if (copy)
+    placed = isDir ? copyDir(src, target) : QFile::copy(src, target);
+  else
+    placed = QDir().rename(src, target);
+  if (!placed) {
+    dbg() << "Could not place" << src << "at" << target;
+    // the target did not exist before, so a partial copy is all ours
+    if (copy && isDir)
+      QDir(target).removeRecursively();
+    else if (copy)
+      QFile::remove(target);
+    emit critical(copy ? tr("Can not copy") : tr("Can not move"),
+                  tr("Could not put %1 at %2.").arg(src).arg(target));
+    return false;
+  }
+  if (copy)
+    transactions.undoCreate(target);
+  else
+    transactions.undoRename(src, target);
+  return true;
+}
+
+/**
+ * @brief ImitatePass::queuePlace move or copy an entry once the steps added
+ * before on it, or on what is inside it, are done, and reencrypt it after
+ * that when it ends up with other recipients
+ * @param src
+ * @param target    the new path
+ * @param force     replace an existing file
+ * @param copy      copy instead of move
+ */
+void ImitatePass::queuePlace(const QString &src, const QString &target,
+                             bool force, bool copy) {
+  QStringList recipients;
+  QStringList reencrypted = movedReencryptions(src, target, &recipients);
+  TransactionScheduler::Step step;
+  step.process = copy ? PASS_COPY : PASS_MOVE;
+  step.resources << src << target;
+  step.receiver = this;
+  step.slot = copy ? "copyEntry" : "moveEntry";
+  step.args << src << target << (force ? "force" : "");
+  // a moved file is backed up once it is at its new path
+  if (!copy)
+    step.args << reencrypted;
+  transactions.then(step);
+  if (reencrypted.isEmpty())
+    return;
+  emit statusMsg(tr("Re-encrypting %1").arg(target), 3000);
+  foreach (const QString &fileName, reencrypted)
+    queueReencrypt(fileName, recipients);
+}
+
+/**
+ * @brief ImitatePass::moveEntry step moving an entry
+ * @param args  source, target, "force" or empty and the moved files that are
+ *              reencrypted afterwards
+ * @return whether the entry was moved
+ */
+bool ImitatePass::moveEntry(const QStringList &args) {
+  QString src = args.value(0);
+  QString target = args.value(1);
+  bool force = args.value(2) == "force";
+  // the store may have changed while the step waited for its turn
+  if (!canPlace(src, target, force, false) || !placeEntry(src, target, false))
+    return false;
+  // restored before the entry is moved back
+  foreach (const QString &fileName, args.mid(3))
+    transactions.backupFile(fileName);
+  return true;
+}
+
+/**
+ * @brief ImitatePass::copyEntry step copying an entry
+ * @param args  source, target and "force" or empty
+ * @return whether the entry was copied
+ */
+bool ImitatePass::copyEntry(const QStringList &args) {
+  QString src = args.value(0);
+  QString target = args.value(1);
+  bool force = args.value(2) == "force";
+  return canPlace(src, target, force, true) && placeEntry(src, target, true);
 }
 
+/**
+ * @brief ImitatePass::Move move a file or folder, reencrypting it only when
+ * it ends up with other recipients
+ * @param src
+ * @param dest
+ * @param force
+ */
 void ImitatePass::Move(const QString src, const QString dest,
                        const bool force) {
-  QFileInfo destFileInfo(dest);
-  transactionHelper trans(this, PASS_MOVE);
-  if (QtPassSettings::isUseGit()) {
-    QStringList args;
-    args << "mv";
-    if (force) {
-      args << "-f";
-    }
-    args << src;
-    args << dest;
-    executeGit(GIT_MOVE, args);
-
+  transactionHelper trans(&transactions, PASS_MOVE);
+  QString target = entryTarget(src, dest);
+  if (!canPlace(src, target, force, false))
+    return;
+  bool useGit = QtPassSettings::isUseGit();
+  if (useGit)
+    stageSources(QStringList(src), QStringList(target));
+  queuePlace(src, target, force, false);
+  if (useGit) {
+    executeGit(GIT_MOVE, {"add", "--", target});
     QString message = QString("moved from %1 to %2 using QTPass.");
     message = message.arg(src).arg(dest);
-    GitCommit("", message);
-  } else {
-    QDir qDir;
-    QFileInfo srcFileInfo(src);
-    QString destCopy = dest;
-    if (srcFileInfo.isFile() && destFileInfo.isDir()) {
-      destCopy = destFileInfo.absoluteFilePath() + QDir::separator() +
-                 srcFileInfo.fileName();
-    }
-    if (force) {
-      qDir.remove(destCopy);
-    }
-    qDir.rename(src, destCopy);
-  }
-  // reecrypt all files under the new folder
-  if (destFileInfo.isDir()) {
-    reencryptPath(destFileInfo.absoluteFilePath());
-  } else if (destFileInfo.isFile()) {
-    reencryptPath(destFileInfo.dir().path());
+    GitCommit(QStringList() << src << target, message);
   }
 }
 
+/**
+ * @brief ImitatePass::Copy copy a file or folder, reencrypting the copy only
+ * when it ends up with other recipients
+ * @param src
+ * @param dest
+ * @param force
+ */
 void ImitatePass::Copy(const QString src, const QString dest,
                        const bool force) {
-  QFileInfo destFileInfo(dest);
-  transactionHelper trans(this, PASS_COPY);
+  transactionHelper trans(&transactions, PASS_COPY);
+  QString target = entryTarget(src, dest);
+  if (!canPlace(src, target, force, true))
+    return;
+  queuePlace(src, target, force, true);
   if (QtPassSettings::isUseGit()) {
-    QStringList args;
-    args << "cp";
-    if (force) {
-      args << "-f";
-    }
-    args << src;
-    args << dest;
-    executeGit(GIT_COPY, args);
-
+    executeGit(GIT_COPY, {"add", "--", target});
+    undoGit({"reset", "-q", "--", target});
     QString message = QString("copied from %1 to %2 using QTPass.");
     message = message.arg(src).arg(dest);
-    GitCommit("", message);
+    GitCommit(target, message);
+  }
+}
+
+/**
+ * @brief ImitatePass::RemoveAll remove several files and folders as one
+ * transaction and a single commit
+ * @param paths absolute paths of files and folders in the store
+ */
+void ImitatePass::RemoveAll(const QStringList &paths) {
+  transactionHelper trans(&transactions, PASS_REMOVE);
+  if (QtPassSettings::isUseGit()) {
+    executeGit(GIT_RM, QStringList() << "rm"
+                                     << "-rf"
+                                     << "--" << paths);
+    undoGit(QStringList() << "checkout"
+                          << "HEAD"
+                          << "--" << paths);
+    undoGit(QStringList() << "reset"
+                          << "-q"
+                          << "HEAD"
+                          << "--" << paths);
+    GitCommit(paths, QString("Remove for %1 using QtPass.")
+                         .arg(storeNames(paths).join(", ")));
   } else {
-    QDir qDir;
-    if (force) {
-      qDir.remove(dest);
+    foreach (const QString &path, paths) {
+      if (QFileInfo(path).isDir()) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+        QDir(path).removeRecursively();
+#else
+        removeDir(path);
+#endif
+      } else {
+        QFile(path).remove();
+      }
     }
-    QFile::copy(src, dest);
   }
-  // reecrypt all files under the new folder
-  if (destFileInfo.isDir()) {
-    reencryptPath(destFileInfo.absoluteFilePath());
-  } else if (destFileInfo.isFile()) {
-    reencryptPath(destFileInfo.dir().path());
+}
+
+/**
+ * @brief ImitatePass::MoveAll move several files and folders into a folder as
+ * one transaction and a single commit
+ * @param srcs      absolute paths of files and folders in the store
+ * @param destDir   absolute path of the folder to move them to
+ */
+void ImitatePass::MoveAll(const QStringList &srcs, const QString &destDir) {
+  transactionHelper trans(&transactions, PASS_MOVE);
+  QStringList moved, targets;
+  foreach (const QString &src, srcs) {
+    QString target = QDir(destDir).filePath(QFileInfo(src).fileName());
+    if (!canPlace(src, target, false, false))
+      continue;
+    moved << src;
+    targets << target;
+  }
+  if (moved.isEmpty())
+    return;
+  bool useGit = QtPassSettings::isUseGit();
+  if (useGit)
+    stageSources(moved, targets);
+  for (int i = 0; i < moved.size(); ++i)
+    queuePlace(moved.at(i), targets.at(i), false, false);
+  if (useGit) {
+    executeGit(GIT_MOVE, QStringList() << "add"
+                                       << "--" << targets);
+    GitCommit(moved + targets, QString("moved %1 to %2 using QTPass.")
+                                   .arg(storeNames(moved).join(", "))
+                                   .arg(destDir));
+  }
+}
+
+/**
+ * @brief ImitatePass::stageSources stage entries about to be moved, so git
+ * knows them, untracked ones included, when the move is committed by path
+ * @param srcs
+ * @param targets   where they are moved to, unstaged as well on rollback
+ */
+void ImitatePass::stageSources(const QStringList &srcs,
+                               const QStringList &targets) {
+  executeGit(GIT_ADD, QStringList() << "add"
+                                    << "--" << srcs);
+  undoGit(QStringList() << "reset"
+                        << "-q"
+                        << "--" << srcs << targets);
+}
+
+/**
+ * @brief ImitatePass::CopyAll copy several files and folders into a folder as
+ * one transaction and a single commit
+ * @param srcs      absolute paths of files and folders in the store
+ * @param destDir   absolute path of the folder to copy them to
+ */
+void ImitatePass::CopyAll(const QStringList &srcs, const QString &destDir) {
+  transactionHelper trans(&transactions, PASS_COPY);
+  QStringList copies;
+  foreach (const QString &src, srcs) {
+    QString target = QDir(destDir).filePath(QFileInfo(src).fileName());
+    if (!canPlace(src, target, false, true))
+      continue;
+    queuePlace(src, target, false, true);
+    copies << target;
+  }
+  if (QtPassSettings::isUseGit() && !copies.isEmpty()) {
+    executeGit(GIT_ADD, QStringList() << "add"
+                                      << "--" << copies);
+    undoGit(QStringList() << "reset"
+                          << "-q"
+                          << "--" << copies);
+    GitCommit(copies, QString("copied %1 to %2 using QTPass.")
+                          .arg(storeNames(srcs).join(", "))
+                          .arg(destDir));
+  }
+}
+
+/**
+ * @brief ImitatePass::copyDir copy a folder with everything in it
+ * @param src
+ * @param dest
+ * @return whether everything was copied
+ */
+bool ImitatePass::copyDir(const QString &src, const QString &dest) {
+  if (!QDir().mkpath(dest))
+    return false;
+  QDirIterator it(src, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    QString path = it.next();
+    QString target = QDir(dest).filePath(QDir(src).relativeFilePath(path));
+    if (it.fileInfo().isDir() ? !QDir().mkpath(target)
+                              : !QFile::copy(path, target))
+      return false;
   }
+  return true;
+}
+
+/**
+ * @brief ImitatePass::storeNames names of files and folders like pass shows
+ * them, for commit messages
+ * @param paths absolute paths in the store
+ */
+QStringList ImitatePass::storeNames(const QStringList &paths) {
+  QDir store(QtPassSettings::getPassStore());
+  QStringList names;
+  foreach (const QString &path, paths)
+    names << store.relativeFilePath(path).replace(QRegExp("\\.gpg$"), "");
+  return names;
 }
 
 /**
  * @brief ImitatePass::executeGpg easy wrapper for running gpg commands
+ * @param file  password file the command works on, commands on the same
+ * file run one after another
  * @param args
+ * @return id of the step
  */
-void ImitatePass::executeGpg(PROCESS id, const QStringList &args, QString input,
-                             bool readStdout, bool readStderr) {
-  executeWrapper(id, QtPassSettings::getGpgExecutable(), args, input,
-                 readStdout, readStderr);
+int ImitatePass::executeGpg(PROCESS id, const QString &file,
+                            const QStringList &args, QString input,
+                            bool readStdout, bool readStderr) {
+  return executeStep(id, QStringList(file), QtPassSettings::getGpgExecutable(),
+                     args, input, readStdout, readStderr);
 }
 /**
- * @brief ImitatePass::executeGit easy wrapper for running git commands
+ * @brief ImitatePass::executeGit easy wrapper for running git commands, they
+ * run in-process when QtPass was built with libgit2
  * @param args
  */
 void ImitatePass::executeGit(PROCESS id, const QStringList &args, QString input,
                              bool readStdout, bool readStderr) {
-  executeWrapper(id, QtPassSettings::getGitExecutable(), args, input,
-                 readStdout, readStderr);
+  // git locks its index, so git commands never run side by side
+  executeStep(id, QStringList("git"), QtPassSettings::getGitExecutable(), args,
+              input, readStdout, readStderr, true);
+}
+
+/**
+ * @brief ImitatePass::undoGit run a git command to roll back the current
+ * transaction should one of its steps fail
+ * @param args
+ */
+void ImitatePass::undoGit(const QStringList &args) {
+  transactions.undoCommand(QtPassSettings::getPassStore(),
+                           QtPassSettings::getGitExecutable(), args);
 }
 
 /**
- * @brief ImitatePass::finished this function is overloaded to ensure
- *                              identical behaviour to RealPass ie. only PASS_*
- *                              processes are visible inside Pass::finish, so
- *                              that interface-wise it all looks the same
+ * @brief ImitatePass::executeStep add a step to the current transaction, it
+ * runs after the steps added before it
  * @param id
- * @param exitCode
- * @param out
- * @param err
- */
-void ImitatePass::finished(int id, int exitCode, const QString &out,
-                           const QString &err) {
-  dbg() << "Imitate Pass";
-  static QString transactionOutput;
-  PROCESS pid = transactionIsOver(static_cast<PROCESS>(id));
-  transactionOutput.append(out);
-
-  if (exitCode == 0) {
-    if (pid == INVALID)
-      return;
-  } else {
-    while (pid == INVALID) {
-      id = exec.cancelNext();
-      if (id == -1) {
-        //  this is probably irrecoverable and shall not happen
-        dbg() << "No such transaction!";
-        return;
-      }
-      pid = transactionIsOver(static_cast<PROCESS>(id));
-    }
-  }
-  Pass::finished(pid, exitCode, transactionOutput, err);
-  transactionOutput.clear();
+ * @param resources what the step works on, empty when it may run any time
+ * @param app
+ * @param args
+ * @param input
+ * @param readStdout
+ * @param readStderr
+ * @param git       whether app is git
+ * @return id of the step
+ */
+int ImitatePass::executeStep(PROCESS id, const QStringList &resources,
+                             const QString &app, const QStringList &args,
+                             QString input, bool readStdout, bool readStderr,
+                             bool git) {
+  dbgPass() << app << args;
+  TransactionScheduler::Step step;
+  step.process = id;
+  step.resources = resources;
+  step.workDir = QtPassSettings::getPassStore();
+  step.app = app;
+  step.args = args;
+  step.input = input;
+  step.readStdout = readStdout;
+  step.readStderr = readStderr;
+  step.git = git;
+  transactions.setEnvironment(env);
+  return transactions.then(step);
 }
 
 /**
@@ -437,6 +856,5 @@ void ImitatePass::finished(int id, int exitCode, const QString &out,
 void ImitatePass::executeWrapper(PROCESS id, const QString &app,
                                  const QStringList &args, QString input,
                                  bool readStdout, bool readStderr) {
-  transactionAdd(id);
-  Pass::executeWrapper(id, app, args, input, readStdout, readStderr);
+  executeStep(id, QStringList(), app, args, input, readStdout, readStderr);
 }
@@ -2,42 +2,67 @@
 #define IMITATEPASS_H
 
 #include "pass.h"
-#include "simpletransaction.h"
+#include "transactionscheduler.h"
 
 /*!
     \class ImitatePass
     \brief Imitates pass features when pass is not enabled or available
 */
-class ImitatePass : public Pass, private simpleTransaction {
+class ImitatePass : public Pass {
   Q_OBJECT
 
+  TransactionScheduler transactions;
+  QHash<int, QString> shows;
+
   bool removeDir(const QString &dirName);
+  bool copyDir(const QString &src, const QString &dest);
+  static QString entryTarget(const QString &src, const QString &dest);
+  bool canPlace(const QString &src, const QString &target, bool force,
+                bool copy);
+  bool placeEntry(const QString &src, const QString &target, bool copy);
+  void queuePlace(const QString &src, const QString &target, bool force,
+                  bool copy);
+  void stageSources(const QStringList &srcs, const QStringList &targets);
+  QStringList reencryptTree(const QString &path);
+  bool reencryptFile(const QString &fileName, const QStringList &gpgId);
+  void queueReencrypt(const QString &fileName, const QStringList &gpgId);
+  QStringList movedReencryptions(const QString &src, const QString &target,
+                                 QStringList *recipients);
+  static QStringList storeNames(const QStringList &paths);
 
   void GitCommit(const QString &file, const QString &msg);
+  void GitCommit(const QStringList &files, const QString &msg);
 
   void executeGit(PROCESS id, const QStringList &args,
                   QString input = QString(), bool readStdout = true,
                   bool readStderr = true);
-  void executeGpg(PROCESS id, const QStringList &args,
-                  QString input = QString(), bool readStdout = true,
-                  bool readStderr = true);
+  int executeGpg(PROCESS id, const QString &file, const QStringList &args,
+                 QString input = QString(), bool readStdout = true,
+                 bool readStderr = true);
+  int executeStep(PROCESS id, const QStringList &resources, const QString &app,
+                  const QStringList &args, QString input, bool readStdout,
+                  bool readStderr, bool git = false);
+  void undoGit(const QStringList &args);
+
+private slots:
+  bool moveEntry(const QStringList &args);
+  bool copyEntry(const QStringList &args);
+  void showFinished(int id, int exitCode, const QString &output,
+                    const QString &errout);
 
   class transactionHelper {
-    simpleTransaction *m_transaction;
+    TransactionScheduler *m_transaction;
     PROCESS m_result;
 
   public:
-    transactionHelper(simpleTransaction *trans, PROCESS result)
+    transactionHelper(TransactionScheduler *trans, PROCESS result)
         : m_transaction(trans), m_result(result) {
-      m_transaction->transactionStart();
+      m_transaction->begin();
     }
-    ~transactionHelper() { m_transaction->transactionEnd(m_result); }
+    ~transactionHelper() { m_transaction->end(m_result); }
   };
 
 protected:
-  virtual void finished(int id, int exitCode, const QString &out,
-                        const QString &err) Q_DECL_OVERRIDE;
-
   virtual void executeWrapper(PROCESS id, const QString &app,
                               const QStringList &args, QString input,
                               bool readStdout = true,
@@ -54,7 +79,7 @@ public:
   virtual void Insert(QString file, QString value,
                       bool overwrite = false) Q_DECL_OVERRIDE;
   virtual void Remove(QString file, bool isDir = false) Q_DECL_OVERRIDE;
-  virtual void Init(QString path, const QList<UserInfo> &list) Q_DECL_OVERRIDE;
+  virtual void Init(QString path, const KeyTable &users) Q_DECL_OVERRIDE;
 
   void reencryptPath(QString dir);
 signals:
@@ -67,6 +92,10 @@ public:
             const bool force = false) Q_DECL_OVERRIDE;
   void Copy(const QString src, const QString dest,
             const bool force = false) Q_DECL_OVERRIDE;
+  void RemoveAll(const QStringList &paths) Q_DECL_OVERRIDE;
+  void MoveAll(const QStringList &srcs, const QString &destDir) Q_DECL_OVERRIDE;
+  void CopyAll(const QStringList &srcs, const QString &destDir) Q_DECL_OVERRIDE;
+  TransactionScheduler *scheduler() Q_DECL_OVERRIDE;
 };
 
 #endif // IMITATEPASS_H
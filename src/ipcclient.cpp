@@ -0,0 +1,93 @@
+#include "ipcclient.h"
+#include "debughelper.h"
+
+/**
+ * @brief IpcClient::IpcClient
+ * @param serverName local socket name of the running instance
+ */
+IpcClient::IpcClient(const QString &serverName)
+    : serverName(serverName), lastId(0) {}
+
+/**
+ * @brief IpcClient::~IpcClient
+ */
+IpcClient::~IpcClient() { close(); }
+
+/**
+ * @brief IpcClient::request send a request and wait for its response.
+ * @param command
+ * @param argument
+ * @param response receives the answer of the running instance
+ * @return false when there is no running instance or it did not answer
+ * properly
+ */
+bool IpcClient::request(IpcRequest::Command command, const QString &argument,
+                        IpcResponse *response) {
+  if (!ensureConnected())
+    return false;
+
+  IpcRequest request(++lastId, command, argument);
+  socket.write(IpcProtocol::encodeRequest(request));
+  if (!socket.waitForBytesWritten(timeout)) {
+    dbg() << socket.errorString().toLatin1();
+    close();
+    return false;
+  }
+
+  QByteArray payload;
+  forever {
+    IpcProtocol::TakeResult result =
+        IpcProtocol::takeFrame(&buffer, &payload);
+    if (result == IpcProtocol::FRAME_INVALID ||
+        (result == IpcProtocol::FRAME_COMPLETE &&
+         !IpcProtocol::decodeResponse(payload, response))) {
+      dbg() << "Invalid response from running instance";
+      close();
+      return false;
+    }
+    // frames not answering this request are skipped
+    if (result == IpcProtocol::FRAME_COMPLETE && response->id == request.id)
+      return true;
+    if (result == IpcProtocol::FRAME_INCOMPLETE) {
+      // SHOW and COPY may wait for gpg and pinentry on the other side
+      if (!socket.waitForReadyRead(replyTimeout)) {
+        dbg() << socket.errorString().toLatin1();
+        close();
+        return false;
+      }
+      buffer += socket.readAll();
+    }
+  }
+}
+
+/**
+ * @brief IpcClient::close drop the connection, the next request reconnects.
+ */
+void IpcClient::close() {
+  buffer.clear();
+  if (socket.state() == QLocalSocket::UnconnectedState)
+    return;
+  socket.disconnectFromServer();
+  if (socket.state() != QLocalSocket::UnconnectedState)
+    socket.waitForDisconnected(timeout);
+}
+
+/**
+ * @brief IpcClient::ensureConnected (re)connect when needed.
+ * @return
+ */
+bool IpcClient::ensureConnected() {
+  if (socket.state() == QLocalSocket::ConnectedState)
+    return true;
+  socket.abort();
+  buffer.clear();
+  socket.connectToServer(serverName);
+  if (!socket.waitForConnected(timeout))
+    return false;
+  if (!IpcProtocol::isPeerTrusted(socket)) {
+    dbg() << "The server runs as another user, not talking to it";
+    socket.abort();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef IPCCLIENT_H_
+#define IPCCLIENT_H_
+
+#include "ipcprotocol.h"
+#include <QLocalSocket>
+
+/*!
+    \class IpcClient
+    \brief Blocking client for the local socket protocol of a running QtPass.
+
+    The connection is opened on the first request and reused for the
+    following ones until IpcClient::close or destruction. Meant for
+    commandline use and helpers such as launchers, the GUI itself only ever
+    acts as server.
+ */
+class IpcClient {
+public:
+  explicit IpcClient(const QString &serverName = IpcProtocol::serverName());
+  ~IpcClient();
+
+  bool request(IpcRequest::Command command, const QString &argument,
+               IpcResponse *response);
+  void close();
+
+private:
+  QString serverName;
+  quint32 lastId;
+  QLocalSocket socket;
+  QByteArray buffer;
+
+  bool ensureConnected();
+
+  static const int timeout = 1000;
+  static const int replyTimeout = 120000;
+};
+
+#endif // IPCCLIENT_H_
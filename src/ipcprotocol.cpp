@@ -0,0 +1,183 @@
+#include "ipcprotocol.h"
+#include "debughelper.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+const quint16 IpcProtocol::version = 1;
+const quint32 IpcProtocol::maxFrameSize = 1024 * 1024;
+
+/**
+ * @brief IpcProtocol::serverName the local socket name, unique per user.
+ *
+ * On unix it is a path in XDG_RUNTIME_DIR, or in a folder of our own in the
+ * temporary folder, that only the user can enter. On Windows the pipe is
+ * restricted to the user by QLocalServer::UserAccessOption.
+ * @return
+ */
+QString IpcProtocol::serverName() {
+  QString name = qgetenv("USER");
+  if (name.isEmpty())
+    name = qgetenv("USERNAME");
+  name += "QtPass";
+#ifdef Q_OS_UNIX
+  QString runtime = qgetenv("XDG_RUNTIME_DIR");
+  if (runtime.isEmpty()) {
+    runtime = QDir::temp().filePath(QString("qtpass-%1").arg(getuid()));
+    QDir().mkpath(runtime);
+    QFile::setPermissions(runtime, QFile::ReadOwner | QFile::WriteOwner |
+                                       QFile::ExeOwner);
+  }
+  QFileInfo directory(runtime);
+  // somebody else's folder, or one others can write to, is not used
+  if (directory.isDir() && directory.ownerId() == getuid() &&
+      !(directory.permissions() & (QFile::WriteGroup | QFile::WriteOther)))
+    return QDir(runtime).filePath(name);
+  dbg() << "Not using" << runtime << "for the socket, it is not private";
+#endif
+  return name;
+}
+
+/**
+ * @brief IpcProtocol::isPeerTrusted whether the other end of a connected
+ * socket runs as the same user as we do.
+ * @param socket
+ * @return false when it runs as someone else or that can not be told
+ */
+bool IpcProtocol::isPeerTrusted(const QLocalSocket &socket) {
+#if defined(Q_OS_LINUX)
+  struct ucred credentials;
+  socklen_t length = sizeof(credentials);
+  if (getsockopt(static_cast<int>(socket.socketDescriptor()), SOL_SOCKET,
+                 SO_PEERCRED, &credentials, &length) != 0)
+    return false;
+  return credentials.uid == getuid();
+#elif defined(Q_OS_UNIX)
+  uid_t uid;
+  gid_t gid;
+  if (getpeereid(static_cast<int>(socket.socketDescriptor()), &uid, &gid) !=
+      0)
+    return false;
+  return uid == getuid();
+#else
+  // the pipe only accepts the user, see QLocalServer::UserAccessOption
+  Q_UNUSED(socket)
+  return true;
+#endif
+}
+
+/**
+ * @brief frame prefix payload with its length.
+ * @param payload
+ * @return
+ */
+static QByteArray frame(const QByteArray &payload) {
+  QByteArray data(sizeof(quint32), '\0');
+  qToBigEndian<quint32>(payload.size(),
+                        reinterpret_cast<uchar *>(data.data()));
+  return data + payload;
+}
+
+/**
+ * @brief IpcProtocol::encodeRequest serialise a request into a frame.
+ * @param request
+ * @return
+ */
+QByteArray IpcProtocol::encodeRequest(const IpcRequest &request) {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << version << request.id << static_cast<quint8>(request.command)
+      << request.argument;
+  return frame(payload);
+}
+
+/**
+ * @brief IpcProtocol::encodeResponse serialise a response into a frame.
+ * @param response
+ * @return
+ */
+QByteArray IpcProtocol::encodeResponse(const IpcResponse &response) {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << version << response.id << static_cast<quint8>(response.status)
+      << response.values;
+  return frame(payload);
+}
+
+/**
+ * @brief IpcProtocol::decodeRequest parse a request payload.
+ * @param payload frame contents without the length prefix
+ * @param request receives the request, the id is filled in whenever possible
+ * so errors can still be answered
+ * @return IpcResponse::OK or the status to answer the client with
+ */
+IpcResponse::Status IpcProtocol::decodeRequest(const QByteArray &payload,
+                                               IpcRequest *request) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_5_0);
+  quint16 peerVersion = 0;
+  quint8 command = 0;
+  in >> peerVersion >> request->id;
+  if (in.status() != QDataStream::Ok)
+    return IpcResponse::BAD_REQUEST;
+  if (peerVersion != version)
+    return IpcResponse::UNSUPPORTED_VERSION;
+  in >> command >> request->argument;
+  if (in.status() != QDataStream::Ok || command >= IpcRequest::COMMAND_COUNT)
+    return IpcResponse::BAD_REQUEST;
+  request->command = static_cast<IpcRequest::Command>(command);
+  return IpcResponse::OK;
+}
+
+/**
+ * @brief IpcProtocol::decodeResponse parse a response payload.
+ * @param payload frame contents without the length prefix
+ * @param response
+ * @return false on malformed data or a version mismatch
+ */
+bool IpcProtocol::decodeResponse(const QByteArray &payload,
+                                 IpcResponse *response) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_5_0);
+  quint16 peerVersion = 0;
+  quint8 status = 0;
+  in >> peerVersion >> response->id >> status >> response->values;
+  if (in.status() != QDataStream::Ok || peerVersion != version ||
+      status > IpcResponse::UNSUPPORTED_VERSION)
+    return false;
+  response->status = static_cast<IpcResponse::Status>(status);
+  return true;
+}
+
+/**
+ * @brief IpcProtocol::takeFrame cut the first complete frame out of buffer,
+ * data arriving in pieces is simply left in the buffer until complete.
+ * @param buffer bytes received so far
+ * @param payload receives the payload of the frame
+ * @return FRAME_COMPLETE when a payload was taken, FRAME_INCOMPLETE when more
+ * data is needed, FRAME_INVALID when the announced length is unacceptable
+ */
+IpcProtocol::TakeResult IpcProtocol::takeFrame(QByteArray *buffer,
+                                               QByteArray *payload) {
+  if (buffer->size() < static_cast<int>(sizeof(quint32)))
+    return FRAME_INCOMPLETE;
+  quint32 length = qFromBigEndian<quint32>(
+      reinterpret_cast<const uchar *>(buffer->constData()));
+  if (length > maxFrameSize)
+    return FRAME_INVALID;
+  int total = sizeof(quint32) + length;
+  if (buffer->size() < total)
+    return FRAME_INCOMPLETE;
+  *payload = buffer->mid(sizeof(quint32), length);
+  buffer->remove(0, total);
+  return FRAME_COMPLETE;
+}
@@ -0,0 +1,115 @@
+#ifndef IPCPROTOCOL_H_
+#define IPCPROTOCOL_H_
+
+#include <QByteArray>
+#include <QLocalSocket>
+#include <QString>
+#include <QStringList>
+
+/*!
+    \struct IpcRequest
+    \brief A request sent over the local socket to a running QtPass instance.
+ */
+struct IpcRequest {
+  /**
+   * @brief IpcRequest::Command what the client asks for.
+   *
+   * QUERY fills in the search box (the classic `qtpass words` behaviour),
+   * SEARCH returns matching entries, SHOW returns the decrypted entry and
+   * COPY puts its password on the clipboard of the running instance.
+   */
+  enum Command { QUERY = 0, SEARCH, SHOW, COPY, COMMAND_COUNT };
+
+  IpcRequest() : id(0), command(QUERY) {}
+  IpcRequest(quint32 id, Command command, const QString &argument)
+      : id(id), command(command), argument(argument) {}
+
+  /**
+   * @brief IpcRequest::id chosen by the client, echoed in the response.
+   */
+  quint32 id;
+  /**
+   * @brief IpcRequest::command
+   */
+  Command command;
+  /**
+   * @brief IpcRequest::argument search words or entry name.
+   */
+  QString argument;
+};
+
+/*!
+    \struct IpcResponse
+    \brief The answer to an IpcRequest.
+ */
+struct IpcResponse {
+  /**
+   * @brief IpcResponse::Status outcome of the request.
+   */
+  enum Status {
+    OK = 0,
+    NOT_FOUND,
+    AMBIGUOUS,
+    FAILED,
+    BAD_REQUEST,
+    UNSUPPORTED_VERSION
+  };
+
+  IpcResponse() : id(0), status(OK) {}
+  IpcResponse(quint32 id, Status status,
+              const QStringList &values = QStringList())
+      : id(id), status(status), values(values) {}
+
+  /**
+   * @brief IpcResponse::id of the request this answers.
+   */
+  quint32 id;
+  /**
+   * @brief IpcResponse::status
+   */
+  Status status;
+  /**
+   * @brief IpcResponse::values entries for SEARCH and AMBIGUOUS, decrypted
+   * content for SHOW, error output for FAILED.
+   */
+  QStringList values;
+};
+
+/*!
+    \class IpcProtocol
+    \brief Framing and (de)serialisation of the local socket protocol.
+
+    Every message is a frame: a big-endian quint32 payload length followed by
+    the payload. The payload is a QDataStream starting with the protocol
+    version, so both sides can detect an incompatible peer.
+
+    Decrypted passwords go over the socket, so it lives in a directory only
+    the user can enter and both ends check that the other side runs as the
+    same user.
+ */
+class IpcProtocol {
+public:
+  /**
+   * @brief IpcProtocol::TakeResult outcome of IpcProtocol::takeFrame.
+   */
+  enum TakeResult { FRAME_INCOMPLETE = 0, FRAME_COMPLETE, FRAME_INVALID };
+
+  const static quint16 version;
+  const static quint32 maxFrameSize;
+
+  static QString serverName();
+  static bool isPeerTrusted(const QLocalSocket &socket);
+
+  static QByteArray encodeRequest(const IpcRequest &request);
+  static QByteArray encodeResponse(const IpcResponse &response);
+  static IpcResponse::Status decodeRequest(const QByteArray &payload,
+                                           IpcRequest *request);
+  static bool decodeResponse(const QByteArray &payload,
+                             IpcResponse *response);
+  static TakeResult takeFrame(QByteArray *buffer, QByteArray *payload);
+
+private:
+  explicit IpcProtocol();
+};
+
+#endif // IPCPROTOCOL_H_
@@ -0,0 +1,135 @@
+#include "keyindex.h"
+#include <QRegExp>
+#include <algorithm>
+
+/**
+ * @brief KeyIndex::KeyIndex an empty index.
+ */
+KeyIndex::KeyIndex() {}
+
+/**
+ * @brief KeyIndex::KeyIndex index keys by long and short key id and
+ * fingerprint of the key and its subkeys, and by e-mail address.
+ * @param keys as returned by GpgKeyring::parseKeys
+ * @param uids all user ids of every key, in the same order
+ */
+KeyIndex::KeyIndex(const QList<UserInfo> &keys, const QList<QStringList> &uids)
+    : uids(uids) {
+  QRegExp email("<([^>]+)>");
+  table.reserve(keys.size());
+  for (int i = 0; i < keys.size(); ++i) {
+    const UserInfo &user = keys.at(i);
+    table.append(user);
+    quint64 keyId = table.keyId(i);
+    keyIdIndex.insert(keyId, i);
+    shortIdIndex.insert(static_cast<quint32>(keyId), i);
+    if (!user.fingerprint.isEmpty())
+      fingerprintIndex.insert(user.fingerprint.toUpper(), i);
+    // gpg also finds a key through any of its subkeys
+    foreach (const QString &subkey, user.subkey_ids) {
+      quint64 subkeyId = KeyTable::parseKeyId(subkey);
+      keyIdIndex.insert(subkeyId, i);
+      shortIdIndex.insert(static_cast<quint32>(subkeyId), i);
+    }
+    foreach (const QString &subkey, user.subkey_fingerprints)
+      fingerprintIndex.insert(subkey.toUpper(), i);
+    if (i >= this->uids.size())
+      continue;
+    foreach (const QString &uid, this->uids.at(i)) {
+      if (email.indexIn(uid) != -1)
+        emailIndex.insert(email.cap(1).toLower(), i);
+    }
+  }
+}
+
+/**
+ * @brief KeyIndex::keys all indexed keys in keyring order.
+ * @return
+ */
+const KeyTable &KeyIndex::keys() const { return table; }
+
+/**
+ * @brief KeyIndex::find keys matching a key specification the way gpg would:
+ * a key id, fingerprint, <email>, =exact user id or part of a user id.
+ * @param keystring as found in .gpg-id for example
+ * @return
+ */
+QList<UserInfo> KeyIndex::find(const QString &keystring) const {
+  QString spec = keystring.trimmed();
+  if (spec.isEmpty())
+    return QList<UserInfo>();
+
+  QString hex = spec;
+  if (hex.startsWith("0x", Qt::CaseInsensitive))
+    hex.remove(0, 2);
+  if (hex.endsWith('!'))
+    hex.chop(1);
+  if (QRegExp("[0-9A-Fa-f]{8}").exactMatch(hex))
+    return keysAt(shortIdIndex.values(KeyTable::parseKeyId(hex)));
+  if (QRegExp("[0-9A-Fa-f]{16}").exactMatch(hex))
+    return keysAt(keyIdIndex.values(KeyTable::parseKeyId(hex)));
+  if (QRegExp("[0-9A-Fa-f]{40}").exactMatch(hex))
+    return keysAt(fingerprintIndex.values(hex.toUpper()));
+
+  if (spec.startsWith('<') && spec.endsWith('>'))
+    return keysAt(emailIndex.values(spec.mid(1, spec.size() - 2).toLower()));
+
+  QList<int> positions;
+  bool exact = spec.startsWith('=');
+  if (exact || spec.startsWith('*') || spec.startsWith('@'))
+    spec.remove(0, 1);
+  for (int i = 0; i < uids.size(); ++i) {
+    foreach (const QString &uid, uids.at(i)) {
+      if (exact ? uid == spec : uid.contains(spec, Qt::CaseInsensitive)) {
+        positions << i;
+        break;
+      }
+    }
+  }
+  return keysAt(positions);
+}
+
+/**
+ * @brief KeyIndex::resolve look up a whole set of recipients at once.
+ * @param recipients as found in .gpg-id
+ * @return one RecipientInfo per recipient, in the same order
+ */
+QList<RecipientInfo> KeyIndex::resolve(const QStringList &recipients) const {
+  QList<RecipientInfo> resolved;
+  foreach (const QString &recipient, recipients) {
+    RecipientInfo info;
+    info.recipient = recipient;
+    info.keys = find(recipient);
+    if (info.keys.isEmpty()) {
+      info.status = RecipientInfo::NOT_FOUND;
+    } else if (info.keys.size() > 1) {
+      info.status = RecipientInfo::AMBIGUOUS;
+    } else {
+      // invalid, revoked or expired keys can not be encrypted to
+      char validity = info.keys.first().validity;
+      info.status = (validity == 'i' || validity == 'r' || validity == 'e')
+                        ? RecipientInfo::UNUSABLE
+                        : RecipientInfo::FOUND;
+    }
+    resolved << info;
+  }
+  return resolved;
+}
+
+/**
+ * @brief KeyIndex::keysAt the keys at the given positions, in keyring order
+ * without duplicates.
+ * @param positions
+ * @return
+ */
+QList<UserInfo> KeyIndex::keysAt(QList<int> positions) const {
+  std::sort(positions.begin(), positions.end());
+  QList<UserInfo> found;
+  int last = -1;
+  foreach (int position, positions) {
+    if (position != last)
+      found << table.at(position);
+    last = position;
+  }
+  return found;
+}
@@ -0,0 +1,36 @@
+#ifndef KEYINDEX_H_
+#define KEYINDEX_H_
+
+#include "datahelpers.h"
+#include "keytable.h"
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+/*!
+    \class KeyIndex
+    \brief Parsed public keys indexed for resolving key specifications.
+
+    Holds the keys of one gpg listing in a KeyTable, cheap to copy.
+ */
+class KeyIndex {
+public:
+  KeyIndex();
+  KeyIndex(const QList<UserInfo> &keys, const QList<QStringList> &uids);
+
+  const KeyTable &keys() const;
+  QList<UserInfo> find(const QString &keystring) const;
+  QList<RecipientInfo> resolve(const QStringList &recipients) const;
+
+private:
+  KeyTable table;
+  QList<QStringList> uids;
+  QMultiHash<quint64, int> keyIdIndex;
+  QMultiHash<quint32, int> shortIdIndex;
+  QMultiHash<QString, int> fingerprintIndex;
+  QMultiHash<QString, int> emailIndex;
+
+  QList<UserInfo> keysAt(QList<int> positions) const;
+};
+
+#endif // KEYINDEX_H_
@@ -0,0 +1,235 @@
+#include "keytable.h"
+
+/**
+ * @brief KeyTable::KeyTable an empty table.
+ */
+KeyTable::KeyTable() {}
+
+/**
+ * @brief KeyTable::reserve make room for size keys.
+ * @param size
+ */
+void KeyTable::reserve(int size) {
+  strings.reserve(size);
+  keyIds.reserve(size);
+  createdDates.reserve(size);
+  expiryDates.reserve(size);
+  subkeyIdLists.reserve(size);
+  subkeyFingerprintLists.reserve(size);
+  validities.reserve(size);
+  flags.reserve(size);
+}
+
+/**
+ * @brief KeyTable::append add a key at the end.
+ * @param user
+ */
+void KeyTable::append(const UserInfo &user) {
+  Strings row;
+  row.nameStart = pool.size();
+  row.nameLength = user.name.size();
+  pool += user.name;
+  row.keyIdStart = pool.size();
+  row.keyIdLength = user.key_id.size();
+  pool += user.key_id;
+  row.fingerprintStart = pool.size();
+  row.fingerprintLength = user.fingerprint.size();
+  pool += user.fingerprint;
+  strings.append(row);
+
+  keyIds.append(parseKeyId(user.key_id));
+  createdDates.append(user.created.isValid() ? user.created.toTime_t() : 0);
+  expiryDates.append(user.expiry.isValid() ? user.expiry.toTime_t() : 0);
+  subkeyIdLists.append(user.subkey_ids);
+  subkeyFingerprintLists.append(user.subkey_fingerprints);
+  validities.append(user.validity);
+  flags.append(static_cast<char>((user.have_secret ? HAVE_SECRET : 0) |
+                                 (user.enabled ? ENABLED : 0)));
+}
+
+/**
+ * @brief KeyTable::size number of keys.
+ * @return
+ */
+int KeyTable::size() const { return keyIds.size(); }
+
+/**
+ * @brief KeyTable::isEmpty
+ * @return
+ */
+bool KeyTable::isEmpty() const { return keyIds.isEmpty(); }
+
+/**
+ * @brief KeyTable::name full name, the first user id.
+ * @param row
+ * @return
+ */
+QStringRef KeyTable::name(int row) const {
+  const Strings &at = strings.at(row);
+  return QStringRef(&pool, at.nameStart, at.nameLength);
+}
+
+/**
+ * @brief KeyTable::keyIdText key id as listed by gpg, for keys missing from
+ * the keyring the recipient as written in .gpg-id.
+ * @param row
+ * @return
+ */
+QStringRef KeyTable::keyIdText(int row) const {
+  const Strings &at = strings.at(row);
+  return QStringRef(&pool, at.keyIdStart, at.keyIdLength);
+}
+
+/**
+ * @brief KeyTable::fingerprint of the primary key.
+ * @param row
+ * @return
+ */
+QStringRef KeyTable::fingerprint(int row) const {
+  const Strings &at = strings.at(row);
+  return QStringRef(&pool, at.fingerprintStart, at.fingerprintLength);
+}
+
+/**
+ * @brief KeyTable::keyId numeric long key id, 0 if it is not hexadecimal.
+ * @param row
+ * @return
+ */
+quint64 KeyTable::keyId(int row) const { return keyIds.at(row); }
+
+/**
+ * @brief KeyTable::validity GnuPG representation of validity.
+ * @param row
+ * @return
+ */
+char KeyTable::validity(int row) const { return validities.at(row); }
+
+/**
+ * @brief KeyTable::created seconds since the epoch, 0 when unknown.
+ * @param row
+ * @return
+ */
+qint64 KeyTable::created(int row) const { return createdDates.at(row); }
+
+/**
+ * @brief KeyTable::expiry seconds since the epoch, 0 when it never expires.
+ * @param row
+ * @return
+ */
+qint64 KeyTable::expiry(int row) const { return expiryDates.at(row); }
+
+/**
+ * @brief KeyTable::subkeyIds hexadecimal ids of the subkeys.
+ * @param row
+ * @return
+ */
+QStringList KeyTable::subkeyIds(int row) const {
+  return subkeyIdLists.at(row);
+}
+
+/**
+ * @brief KeyTable::subkeyFingerprints of the subkeys, same order as
+ * KeyTable::subkeyIds.
+ * @param row
+ * @return
+ */
+QStringList KeyTable::subkeyFingerprints(int row) const {
+  return subkeyFingerprintLists.at(row);
+}
+
+/**
+ * @brief KeyTable::haveSecret secret key is available.
+ * @param row
+ * @return
+ */
+bool KeyTable::haveSecret(int row) const { return flags.at(row) & HAVE_SECRET; }
+
+/**
+ * @brief KeyTable::isEnabled selected as recipient.
+ * @param row
+ * @return
+ */
+bool KeyTable::isEnabled(int row) const { return flags.at(row) & ENABLED; }
+
+/**
+ * @brief KeyTable::fullyValid when validity is f or u.
+ * @param row
+ * @return
+ * @sa UserInfo::fullyValid
+ */
+bool KeyTable::fullyValid(int row) const {
+  return validity(row) == 'f' || validity(row) == 'u';
+}
+
+/**
+ * @brief KeyTable::isValid when fully or marginally valid.
+ * @param row
+ * @return
+ * @sa UserInfo::isValid
+ */
+bool KeyTable::isValid(int row) const {
+  return fullyValid(row) || validity(row) == 'm';
+}
+
+/**
+ * @brief KeyTable::setHaveSecret
+ * @param row
+ * @param haveSecret
+ */
+void KeyTable::setHaveSecret(int row, bool haveSecret) {
+  setFlag(row, HAVE_SECRET, haveSecret);
+}
+
+/**
+ * @brief KeyTable::setEnabled
+ * @param row
+ * @param enabled
+ */
+void KeyTable::setEnabled(int row, bool enabled) {
+  setFlag(row, ENABLED, enabled);
+}
+
+/**
+ * @brief KeyTable::at a row as UserInfo, for the few places that need one,
+ * unknown dates stay invalid like in the UserInfo that was appended.
+ * @param row
+ * @return
+ */
+UserInfo KeyTable::at(int row) const {
+  UserInfo user;
+  user.name = name(row).toString();
+  user.key_id = keyIdText(row).toString();
+  user.fingerprint = fingerprint(row).toString();
+  user.validity = validity(row);
+  user.have_secret = haveSecret(row);
+  user.enabled = isEnabled(row);
+  user.subkey_ids = subkeyIds(row);
+  user.subkey_fingerprints = subkeyFingerprints(row);
+  if (created(row) != 0)
+    user.created.setTime_t(created(row));
+  if (expiry(row) != 0)
+    user.expiry.setTime_t(expiry(row));
+  return user;
+}
+
+/**
+ * @brief KeyTable::parseKeyId hexadecimal key id to number.
+ * @param keyId
+ * @return 0 when keyId is not a hexadecimal number
+ */
+quint64 KeyTable::parseKeyId(const QString &keyId) {
+  bool ok = false;
+  quint64 id = keyId.toULongLong(&ok, 16);
+  return ok ? id : 0;
+}
+
+/**
+ * @brief KeyTable::setFlag
+ * @param row
+ * @param flag
+ * @param on
+ */
+void KeyTable::setFlag(int row, Flag flag, bool on) {
+  char value = flags.at(row);
+  flags[row] = static_cast<char>(on ? (value | flag) : (value & ~flag));
+}
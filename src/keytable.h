@@ -0,0 +1,84 @@
+#ifndef KEYTABLE_H_
+#define KEYTABLE_H_
+
+#include "datahelpers.h"
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QStringRef>
+#include <QVector>
+
+/*!
+    \class KeyTable
+    \brief Column wise storage of gpg keys.
+
+    Names, ids and fingerprints live in one string pool, key ids are also
+    kept as numbers, dates as seconds since the epoch and the booleans as
+    packed flags. Subkeys are rarely needed and kept as lists. Every column
+    is implicitly shared, so copies are cheap and changing the enabled flag
+    of a copy only detaches the flags.
+ */
+class KeyTable {
+public:
+  KeyTable();
+
+  void reserve(int size);
+  void append(const UserInfo &user);
+
+  int size() const;
+  bool isEmpty() const;
+
+  QStringRef name(int row) const;
+  QStringRef keyIdText(int row) const;
+  QStringRef fingerprint(int row) const;
+  quint64 keyId(int row) const;
+  char validity(int row) const;
+  qint64 created(int row) const;
+  qint64 expiry(int row) const;
+  QStringList subkeyIds(int row) const;
+  QStringList subkeyFingerprints(int row) const;
+  bool haveSecret(int row) const;
+  bool isEnabled(int row) const;
+  bool fullyValid(int row) const;
+  bool isValid(int row) const;
+
+  void setHaveSecret(int row, bool haveSecret);
+  void setEnabled(int row, bool enabled);
+
+  UserInfo at(int row) const;
+
+  static quint64 parseKeyId(const QString &keyId);
+
+private:
+  /**
+   * @brief The Flag enum bits in KeyTable::flags.
+   */
+  enum Flag { HAVE_SECRET = 0x1, ENABLED = 0x2 };
+
+  /*!
+      \struct Strings
+      \brief Where the strings of a row are in the pool.
+   */
+  struct Strings {
+    int nameStart;
+    int nameLength;
+    int keyIdStart;
+    int keyIdLength;
+    int fingerprintStart;
+    int fingerprintLength;
+  };
+
+  QString pool;
+  QVector<Strings> strings;
+  QVector<quint64> keyIds;
+  QVector<qint64> createdDates;
+  QVector<qint64> expiryDates;
+  QVector<QStringList> subkeyIdLists;
+  QVector<QStringList> subkeyFingerprintLists;
+  QByteArray validities;
+  QByteArray flags;
+
+  void setFlag(int row, Flag flag, bool on);
+};
+
+#endif // KEYTABLE_H_
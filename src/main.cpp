@@ -1,5 +1,11 @@
+#include "executorstats.h"
+#include "headlessquery.h"
 #include "mainwindow.h"
+#include "startuptrace.h"
+#include "tracer.h"
 #include <QApplication>
+#include <QGuiApplication>
+#include <QTextStream>
 #include <QTranslator>
 
 /*! \mainpage QtPass
@@ -26,6 +32,26 @@
  * On most *nix systems all you need is:
  *
  * `qmake && make && make install`
+ *
+ * \section usage_sec Usage
+ *
+ * `qtpass [search words]` opens the GUI (or an already running instance) and
+ * searches for the given words.
+ *
+ * `qtpass --show <entry>` and `qtpass --clip <entry>` decrypt a single entry
+ * without starting the GUI, printing it or copying its password to the
+ * clipboard.
+ *
+ * `qtpass --startup-trace` prints how long each phase of starting the GUI
+ * takes to stderr.
+ *
+ * `qtpass --trace=<file>` records what QtPass is doing, e.g. how long
+ * decrypting an entry waits, runs and takes to display, and writes it to the
+ * file in the Chrome trace format when quitting.
+ *
+ * `qtpass --stats` prints, when quitting, how many times gpg, git and pass
+ * ran, how long they waited in the queue, took to start and ran, and with
+ * which exit codes.
  */
 
 /**
@@ -36,22 +62,29 @@
  */
 int main(int argc, char *argv[]) {
   qputenv("QT_AUTO_SCREEN_SCALE_FACTOR", "1");
-  QString text = "";
-  for (int i = 1; i < argc; ++i) {
-    if (i > 1)
-      text += " ";
-    text += argv[i];
-  }
+  QString text;
+  HeadlessQuery::Mode mode = HeadlessQuery::parseArguments(argc, argv, &text);
 
   if (text.indexOf("-psn_") == 0) {
     text.clear();
   }
 
+  QCoreApplication::setOrganizationName("IJHack");
+  QCoreApplication::setOrganizationDomain("ijhack.org");
+  QCoreApplication::setApplicationName("QtPass");
+  QCoreApplication::setApplicationVersion(VERSION);
+
+  // scripted lookups, no need for widgets or a running instance
+  if (mode == HeadlessQuery::SHOW) {
+    QCoreApplication app(argc, argv);
+    return HeadlessQuery(mode, text).exec();
+  } else if (mode == HeadlessQuery::CLIP) {
+    QGuiApplication app(argc, argv);
+    return HeadlessQuery(mode, text).exec();
+  }
+
 #if SINGLE_APP
-  QString name = qgetenv("USER");
-  if (name.isEmpty())
-    name = qgetenv("USERNAME");
-  SingleApplication app(argc, argv, name + "QtPass");
+  SingleApplication app(argc, argv, IpcProtocol::serverName());
   if (app.isRunning()) {
     if (text.length() > 0)
       app.sendMessage(text);
@@ -60,11 +93,7 @@ int main(int argc, char *argv[]) {
 #else
   QApplication app(argc, argv);
 #endif
-
-  QCoreApplication::setOrganizationName("IJHack");
-  QCoreApplication::setOrganizationDomain("ijhack.org");
-  QCoreApplication::setApplicationName("QtPass");
-  QCoreApplication::setApplicationVersion(VERSION);
+  StartupTrace::mark("application");
 
   // Setup and load translator for localization
   QTranslator translator;
@@ -77,15 +106,23 @@ int main(int argc, char *argv[]) {
   app.installTranslator(&translator);
   app.setLayoutDirection(QObject::tr("LTR") == "RTL" ? Qt::RightToLeft
                                                      : Qt::LeftToRight);
+  StartupTrace::mark("translations");
   MainWindow w;
 
   QObject::connect(&app, SIGNAL(aboutToQuit()), &w, SLOT(clearClipboard()));
+  // Quit in the tray menu skips closeEvent, where pushing is flushed
+  QObject::connect(&app, SIGNAL(aboutToQuit()), &w, SLOT(flushSync()));
 
   app.setActiveWindow(&w);
   app.setWindowIcon(QIcon(":artwork/icon.png"));
   w.setApp(&app);
   w.setText(text);
   w.show();
+  StartupTrace::mark("window shown");
 
-  return app.exec();
+  int result = app.exec();
+  Tracer::write();
+  if (ExecutorStats::isDumpEnabled())
+    QTextStream(stderr) << ExecutorStats::report();
+  return result;
 }
@@ -7,6 +7,7 @@
 #include <QLabel>
 #include <QMessageBox>
 #include <QQueue>
+#include <QSet>
 #include <QShortcut>
 #include <QTextCodec>
 #include <QTimer>
@@ -18,14 +19,20 @@
 #undef DELETE
 #endif
 #include "configdialog.h"
+#include "filecontent.h"
 #include "keygendialog.h"
 #include "passworddialog.h"
 #include "qpushbuttonwithclipboard.h"
 #include "qtpasssettings.h"
 #include "settingsconstants.h"
+#include "startuptrace.h"
+#include "tracer.h"
 #include "ui_mainwindow.h"
 #include "usersdialog.h"
 #include "util.h"
+#if SINGLE_APP
+#include "queryhandler.h"
+#endif
 
 /**
  * @brief MainWindow::MainWindow handles all of the main functionality and also
@@ -34,7 +41,7 @@
  */
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow), fusedav(this), keygen(NULL),
-      tray(NULL) {
+      tray(NULL), deferredScheduled(false) {
 #ifdef __APPLE__
   // extra treatment for mac os
   // see http://doc.qt.io/qt-5/qkeysequence.html#qt_set_sequence_auto_mnemonic
@@ -43,18 +50,9 @@ MainWindow::MainWindow(QWidget *parent)
   // register shortcut ctrl/cmd + Q to close the main window
   new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_Q), this, SLOT(close()));
 
-  //    TODO(bezet): this should be reconnected dynamically when pass changes
-  connectPassSignalHandlers(QtPassSettings::getRealPass());
-  connectPassSignalHandlers(QtPassSettings::getImitatePass());
-
-  //    only for ipass
-  connect(QtPassSettings::getImitatePass(), SIGNAL(startReencryptPath()), this,
-          SLOT(startReencryptPath()));
-  connect(QtPassSettings::getImitatePass(), SIGNAL(endReencryptPath()), this,
-          SLOT(endReencryptPath()));
-
   ui->setupUi(this);
   enableUiElements(true);
+  StartupTrace::mark("widgets");
   ui->statusBar->showMessage(tr("Welcome to QtPass %1").arg(VERSION), 2000);
   freshStart = true;
   startupPhase = true;
@@ -63,11 +61,17 @@ MainWindow::MainWindow(QWidget *parent)
   clearClipboardTimer.setSingleShot(true);
   connect(&clearClipboardTimer, SIGNAL(timeout()), this,
           SLOT(clearClipboard()));
+  connect(&sync, &SyncScheduler::pushed, this, &MainWindow::processFinished);
+  connect(&sync, &SyncScheduler::failed, this, &MainWindow::syncFailed);
+  connect(&sync, &SyncScheduler::countsChanged, this,
+          &MainWindow::syncCountsChanged);
   pwdConfig.selected = passwordConfiguration::ALLCHARS;
   if (!checkConfig()) {
     // no working config
     QApplication::quit();
   }
+  // in case the search box is not painted, e.g. when starting minimized
+  QTimer::singleShot(deferredFallback, this, SLOT(startDeferred()));
   clippedText = "";
   QtPass = NULL;
   QTimer::singleShot(10, this, SLOT(focusInput()));
@@ -84,7 +88,6 @@ MainWindow::MainWindow(QWidget *parent)
   connect(actionAddPassword, SIGNAL(triggered()), this,
           SLOT(on_addButton_clicked()));
   connect(actionAddFolder, SIGNAL(triggered()), this, SLOT(addFolder()));
-  qsrand(static_cast<uint>(QTime::currentTime().msec()));
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
   ui->lineEdit->setClearButtonEnabled(true);
@@ -135,33 +138,57 @@ void MainWindow::changeEvent(QEvent *event) {
 /**
  * @brief MainWindow::connectPassSignalHandlers this method connects Pass
  *                                              signals to approprite MainWindow
- *                                              slots
+ *                                              slots, backends are created
+ *                                              when first used so this is
+ *                                              done whenever the backend may
+ *                                              have changed
  *
  * @param pass        pointer to pass instance
  */
 void MainWindow::connectPassSignalHandlers(Pass *pass) {
+  const Qt::ConnectionType type = Qt::UniqueConnection;
 
   //    TODO(bezet): this is never emitted(should be), also naming(see
   //    critical())
-  connect(pass, &Pass::error, this, &MainWindow::processError);
+  connect(pass, &Pass::error, this, &MainWindow::processError, type);
   connect(pass, &Pass::startingExecuteWrapper, this,
-          &MainWindow::executeWrapperStarted);
-  connect(pass, &Pass::critical, this, &MainWindow::critical);
-  connect(pass, &Pass::statusMsg, this, &MainWindow::showStatusMessage);
-  connect(pass, &Pass::processErrorExit, this, &MainWindow::processErrorExit);
-
-  connect(pass, &Pass::finishedGitInit, this, &MainWindow::passStoreChanged);
-  connect(pass, &Pass::finishedGitPull, this, &MainWindow::processFinished);
-  connect(pass, &Pass::finishedGitPush, this, &MainWindow::processFinished);
-  connect(pass, &Pass::finishedShow, this, &MainWindow::passShowHandler);
-  connect(pass, &Pass::finishedInsert, this, &MainWindow::finishedInsert);
-  connect(pass, &Pass::finishedRemove, this, &MainWindow::passStoreChanged);
-  connect(pass, &Pass::finishedInit, this, &MainWindow::passStoreChanged);
-  connect(pass, &Pass::finishedMove, this, &MainWindow::passStoreChanged);
-  connect(pass, &Pass::finishedCopy, this, &MainWindow::passStoreChanged);
+          &MainWindow::executeWrapperStarted, type);
+  connect(pass, &Pass::critical, this, &MainWindow::critical, type);
+  connect(pass, &Pass::statusMsg, this, &MainWindow::showStatusMessage, type);
+  connect(pass, &Pass::processErrorExit, this, &MainWindow::processErrorExit,
+          type);
+
+  connect(pass, &Pass::finishedGitInit, this, &MainWindow::passStoreChanged,
+          type);
+  connect(pass, &Pass::finishedGitPull, this, &MainWindow::processFinished,
+          type);
+  connect(pass, &Pass::finishedGitPull, &sync, &SyncScheduler::updateCounts,
+          type);
+  connect(pass, &Pass::finishedGitPush, this, &MainWindow::processFinished,
+          type);
+  connect(pass, &Pass::finishedShow, this, &MainWindow::passShowHandler, type);
+  connect(pass, &Pass::finishedInsert, this, &MainWindow::finishedInsert,
+          type);
+  connect(pass, &Pass::finishedRemove, this, &MainWindow::passStoreChanged,
+          type);
+  connect(pass, &Pass::finishedInit, this, &MainWindow::passStoreChanged,
+          type);
+  connect(pass, &Pass::finishedMove, this, &MainWindow::passStoreChanged,
+          type);
+  connect(pass, &Pass::finishedCopy, this, &MainWindow::passStoreChanged,
+          type);
 
   connect(pass, &Pass::finishedGenerateGPGKeys, this,
-          &MainWindow::keyGenerationComplete);
+          &MainWindow::keyGenerationComplete, type);
+
+  //    only for ipass
+  ImitatePass *imitatePass = qobject_cast<ImitatePass *>(pass);
+  if (imitatePass != Q_NULLPTR) {
+    connect(imitatePass, &ImitatePass::startReencryptPath, this,
+            &MainWindow::startReencryptPath, type);
+    connect(imitatePass, &ImitatePass::endReencryptPath, this,
+            &MainWindow::endReencryptPath, type);
+  }
 }
 
 /**
@@ -256,26 +283,17 @@ bool MainWindow::checkConfig() {
     if (QtPassSettings::isMaximized(isMaximized())) {
       showMaximized();
     }
+    StartupTrace::mark("window geometry");
   }
 
   QString passStore = QtPassSettings::getPassStore(Util::findPasswordStore());
   QtPassSettings::setPassStore(passStore);
 
-  QString passExecutable =
-      QtPassSettings::getPassExecutable(Util::findBinaryInPath("pass"));
-  QtPassSettings::setPassExecutable(passExecutable);
-
-  QString gitExecutable =
-      QtPassSettings::getGitExecutable(Util::findBinaryInPath("git"));
-  QtPassSettings::setGitExecutable(gitExecutable);
-
-  QString gpgExecutable =
-      QtPassSettings::getGpgExecutable(Util::findBinaryInPath("gpg2"));
-  QtPassSettings::setGpgExecutable(gpgExecutable);
-
-  QString pwgenExecutable =
-      QtPassSettings::getPwgenExecutable(Util::findBinaryInPath("pwgen"));
-  QtPassSettings::setPwgenExecutable(pwgenExecutable);
+  // at startup what was found before is good enough until the window is up
+  detectExecutables(startupPhase);
+  if (startupPhase)
+    defer(this, SLOT(detectExecutables()));
+  StartupTrace::mark("executables");
 
   pwdConfig.length = QtPassSettings::getPasswordLength();
   pwdConfig.selected = static_cast<passwordConfiguration::characterSet>(
@@ -290,10 +308,14 @@ bool MainWindow::checkConfig() {
   }
 
   if (QtPassSettings::isUseTrayIcon() && tray == NULL) {
-    initTrayIcon();
     if (freshStart && QtPassSettings::isStartMinimized()) {
+      initTrayIcon();
       // since we are still in constructor, can't directly hide
       QTimer::singleShot(10, this, SLOT(hide()));
+    } else if (startupPhase) {
+      defer(this, SLOT(initTrayIcon()));
+    } else {
+      initTrayIcon();
     }
   } else if (!QtPassSettings::isUseTrayIcon() && tray != NULL) {
     destroyTrayIcon();
@@ -336,8 +358,10 @@ bool MainWindow::checkConfig() {
   // TODO(annejan): this needs to be before we try to access the store,
   // but it would be better to do it after the Window is shown,
   // as the long delay it can cause is irritating otherwise.
-  if (QtPassSettings::isUseWebDav())
+  if (QtPassSettings::isUseWebDav()) {
     mountWebDav();
+    StartupTrace::mark("webdav");
+  }
 
   model.setNameFilters(QStringList() << "*.gpg");
   model.setNameFilterDisables(false);
@@ -366,7 +390,10 @@ bool MainWindow::checkConfig() {
   connect(ui->textBrowser, SIGNAL(customContextMenuRequested(const QPoint &)),
           this, SLOT(showBrowserContextMenu(const QPoint &)));
 
+  StartupTrace::mark("store model");
+
   updateProfileBox();
+  connectPassSignalHandlers(QtPassSettings::getPass());
   QtPassSettings::getPass()->updateEnv();
   clearPanelTimer.setInterval(1000 *
                               QtPassSettings::getAutoclearPanelSeconds());
@@ -385,10 +412,81 @@ bool MainWindow::checkConfig() {
                                      QSizePolicy::Minimum);
   }
 
+  // GnuPG home or executable may have changed, at startup this waits until
+  // the search box is there
+  if (startupPhase) {
+    defer(&keyring, SLOT(refresh()));
+    defer(&sync, SLOT(start()));
+  } else {
+    keyring.refresh();
+    sync.start();
+  }
+
+  StartupTrace::mark("config checked");
   startupPhase = false;
   return true;
 }
 
+/**
+ * @brief MainWindow::detectExecutables search PATH for the executables that
+ * are not configured, searching PATH stats every entry so the results are
+ * cached.
+ * @param allowStale    use cached results even when PATH changed since
+ */
+void MainWindow::detectExecutables(bool allowStale) {
+  if (QtPassSettings::getPassExecutable().isEmpty())
+    QtPassSettings::setPassExecutable(
+        Util::findBinaryInPath("pass", allowStale));
+  if (QtPassSettings::getGitExecutable().isEmpty())
+    QtPassSettings::setGitExecutable(Util::findBinaryInPath("git", allowStale));
+  if (QtPassSettings::getGpgExecutable().isEmpty())
+    QtPassSettings::setGpgExecutable(
+        Util::findBinaryInPath("gpg2", allowStale));
+  if (QtPassSettings::getPwgenExecutable().isEmpty())
+    QtPassSettings::setPwgenExecutable(
+        Util::findBinaryInPath("pwgen", allowStale));
+}
+
+/**
+ * @brief MainWindow::defer call a slot once the window is painted, for work
+ * that does not need to be done before searching is possible.
+ * @param receiver
+ * @param member    slot as given by SLOT()
+ */
+void MainWindow::defer(QObject *receiver, const char *member) {
+  deferred.enqueue(qMakePair(receiver, member));
+}
+
+/**
+ * @brief MainWindow::startDeferred start running the deferred slots, one per
+ * event loop iteration so the window stays responsive.
+ */
+void MainWindow::startDeferred() {
+  if (deferredScheduled)
+    return;
+  deferredScheduled = true;
+  StartupTrace::mark("search box painted");
+  QTimer::singleShot(0, this, SLOT(runDeferred()));
+}
+
+/**
+ * @brief MainWindow::runDeferred call the next deferred slot.
+ */
+void MainWindow::runDeferred() {
+  if (deferred.isEmpty())
+    return;
+  QPair<QObject *, const char *> next = deferred.dequeue();
+  // skip the code SLOT() prepends to the signature
+  QByteArray member(next.second + 1);
+  member.truncate(member.indexOf('('));
+  QMetaObject::invokeMethod(next.first, member.constData());
+  StartupTrace::mark(QString("deferred %1::%2")
+                         .arg(next.first->metaObject()->className())
+                         .arg(QString(member)));
+  if (!deferred.isEmpty())
+    QTimer::singleShot(0, this, SLOT(runDeferred()));
+}
+
 /**
  * @brief MainWindow::config pops up the configuration screen and handles all
  * inter-window communication
@@ -436,6 +534,7 @@ void MainWindow::config() {
   d->templateAllFields(QtPassSettings::isTemplateAllFields());
   d->autoPull(QtPassSettings::isAutoPull());
   d->autoPush(QtPassSettings::isAutoPush());
+  d->syncInterval(QtPassSettings::getSyncInterval());
   d->alwaysOnTop(QtPassSettings::isAlwaysOnTop());
   if (startupPhase)
     d->wizard(); // does shit
@@ -477,6 +576,7 @@ void MainWindow::config() {
       QtPassSettings::setTemplateAllFields(d->templateAllFields());
       QtPassSettings::setAutoPush(d->autoPush());
       QtPassSettings::setAutoPull(d->autoPull());
+      QtPassSettings::setSyncInterval(d->syncInterval());
       QtPassSettings::setAlwaysOnTop(d->alwaysOnTop());
 
       QtPassSettings::setVersion(VERSION);
@@ -495,11 +595,14 @@ void MainWindow::config() {
       }
 
       updateProfileBox();
+      keyring.refresh();
+      sync.start();
       ui->treeView->setRootIndex(proxyModel.mapFromSource(
           model.setRootPath(QtPassSettings::getPassStore())));
 
       if (freshStart && Util::checkConfig())
         config();
+      connectPassSignalHandlers(QtPassSettings::getPass());
       QtPassSettings::getPass()->updateEnv();
       clearPanelTimer.setInterval(1000 *
                                   QtPassSettings::getAutoclearPanelSeconds());
@@ -545,7 +648,7 @@ void MainWindow::on_updateButton_clicked(bool block) {
 void MainWindow::on_pushButton_clicked() {
   if (QtPassSettings::isUseGit()) {
     ui->statusBar->showMessage(tr("Updating password-store"), 2000);
-    QtPassSettings::getPass()->GitPush();
+    sync.push();
   }
 }
 
@@ -573,6 +676,7 @@ QString MainWindow::getFile(const QModelIndex &index, bool forPass) {
  * @param index
  */
 void MainWindow::on_treeView_clicked(const QModelIndex &index) {
+  Tracer::instant("entry clicked");
   bool cleared = ui->treeView->currentIndex().flags() == Qt::NoItemFlags;
   currentDir =
       Util::getDir(ui->treeView->currentIndex(), false, model, proxyModel);
@@ -638,15 +742,24 @@ void MainWindow::keyGenerationComplete(const QString &p_output,
     keygen = 0;
     // TODO(annejan) some sanity checking ?
   }
+  keyring.refresh();
   processFinished(p_output, p_errout);
 }
 
-void MainWindow::passShowHandler(const QString &p_output) {
+void MainWindow::passShowHandler(const QString &file,
+                                 const QString &p_output) {
+  Tracer::Span span("MainWindow::passShowHandler");
+  // decryptions run side by side, one of an entry clicked before may be late
+  if (file != ui->passwordName->text()) {
+    enableUiElements(true);
+    return;
+  }
   QString output = p_output;
   {
-    QStringList tokens = p_output.split("\n");
-    QString password = tokens.at(0);
-    tokens.erase(tokens.begin());
+    FileContent fileContent =
+        FileContent::parse(p_output, QtPassSettings::getPassTemplate(),
+                           QtPassSettings::isTemplateAllFields());
+    QString password = fileContent.getPassword();
 
     if (QtPassSettings::getClipBoardType() != Enums::CLIPBOARD_NEVER &&
         !p_output.isEmpty()) {
@@ -659,7 +772,7 @@ void MainWindow::passShowHandler(const QString &p_output) {
       if (QtPassSettings::isHidePassword() &&
           !QtPassSettings::isUseTemplate()) {
         output = "***" + tr("Password hidden") + "***";
-        output += tokens.join("\n");
+        output += fileContent.getContentWithoutPassword();
       }
       if (QtPassSettings::isHideContent())
         output = "***" + tr("Content hidden") + "***";
@@ -667,33 +780,16 @@ void MainWindow::passShowHandler(const QString &p_output) {
 
     clearTemplateWidgets();
     if (QtPassSettings::isUseTemplate() && !QtPassSettings::isHideContent()) {
-      QStringList remainingTokens;
-      for (int j = 0; j < tokens.length(); ++j) {
-        QString token = tokens.at(j);
-        if (token.contains(':')) {
-          int colon = token.indexOf(':');
-          QString field = token.left(colon);
-          if (QtPassSettings::isTemplateAllFields() ||
-              QtPassSettings::getPassTemplate().contains(field)) {
-            QString value = token.right(token.length() - colon - 1);
-            if (!QtPassSettings::getPassTemplate().contains(field) &&
-                value.startsWith("//")) {
-              remainingTokens.append(token);
-              continue; // colon is probably from a url
-            }
-            addToGridLayout(j + 1, field, value);
-          }
-        } else {
-          remainingTokens.append(token);
-        }
-      }
+      foreach (const NamedValue &namedValue, fileContent.getNamedValues())
+        addToGridLayout(namedValue.position, namedValue.name,
+                        namedValue.value);
       if (ui->gridLayout->count() == 0)
         ui->verticalLayoutPassword->setSpacing(0);
       else
         ui->verticalLayoutPassword->setSpacing(6);
-      output = remainingTokens.join("\n");
+      output = fileContent.getRemainingData();
     } else if (!QtPassSettings::isHideContent()) {
-      output = tokens.join("\n");
+      output = fileContent.getContentWithoutPassword();
     }
     if (!QtPassSettings::isHideContent() && !password.isEmpty()) {
       // now set the password. If we set it earlier, the layout will be
@@ -716,7 +812,42 @@ void MainWindow::passStoreChanged(const QString &p_out, const QString &p_err) {
 
 void MainWindow::doGitPush() {
   if (QtPassSettings::isAutoPush())
-    on_pushButton_clicked();
+    sync.schedulePush();
+  else
+    sync.updateCounts();
+}
+
+/**
+ * @brief MainWindow::syncCountsChanged show how far the store is ahead of and
+ * behind its remote
+ * @param ahead
+ * @param behind
+ */
+void MainWindow::syncCountsChanged(int ahead, int behind) {
+  ui->pushButton->setToolTip(
+      ahead > 0 ? tr("git push (%n commit(s) ahead)", "", ahead)
+                : tr("git push"));
+  ui->updateButton->setToolTip(
+      behind > 0 ? tr("git pull (%n commit(s) behind)", "", behind)
+                 : tr("git pull"));
+  if (ahead > 0 || behind > 0)
+    ui->statusBar->showMessage(
+        tr("%1 ahead, %2 behind remote").arg(ahead).arg(behind), 2000);
+}
+
+/**
+ * @brief MainWindow::syncFailed a fetch or push failed, it ran in the
+ * background so the output and the ui of what the user does are left alone
+ * @param exitCode
+ * @param errout
+ */
+void MainWindow::syncFailed(int exitCode, const QString &errout) {
+  dbgGit() << "sync failed" << exitCode << errout;
+  QString reason = errout.trimmed().section('\n', 0, 0);
+  ui->statusBar->showMessage(
+      reason.isEmpty() ? tr("Syncing with the remote failed")
+                       : tr("Syncing with the remote failed: %1").arg(reason),
+      5000);
 }
 
 void MainWindow::finishedInsert(const QString &p_output,
@@ -766,6 +897,21 @@ void MainWindow::processErrorExit(int exitCode, const QString &p_error) {
   enableUiElements(true);
 }
 
+/**
+ * @brief MainWindow::flushSync push what is waiting to be pushed before
+ * quitting, called from closeEvent while the window still shows the status,
+ * and on aboutToQuit for Quit in the tray menu, which closes no window.
+ */
+void MainWindow::flushSync() {
+  if (!sync.hasPending())
+    return;
+  ui->statusBar->showMessage(tr("Pushing changes before quitting"));
+  ui->statusBar->repaint();
+  if (!sync.flush())
+    dbg() << "Quitting before pushing finished";
+  ui->statusBar->clearMessage();
+}
+
 /**
  * @brief MainWindow::clearClipboard remove clipboard contents.
  */
@@ -886,10 +1032,7 @@ void MainWindow::on_configButton_clicked() { config(); }
 void MainWindow::on_lineEdit_textChanged(const QString &arg1) {
   ui->treeView->expandAll();
   ui->statusBar->showMessage(tr("Looking for: %1").arg(arg1), 1000);
-  QString query = arg1;
-  query.replace(QRegExp(" "), ".*");
-  QRegExp regExp(query, Qt::CaseInsensitive);
-  proxyModel.setFilterRegExp(regExp);
+  proxyModel.setFilterRegExp(Util::searchRegExp(arg1));
   ui->treeView->setRootIndex(proxyModel.mapFromSource(
       model.setRootPath(QtPassSettings::getPassStore())));
   selectFirstFile();
@@ -946,9 +1089,9 @@ void MainWindow::setPassword(QString file, bool isNew) {
   PasswordDialog d(pwdConfig, this);
   connect(QtPassSettings::getPass(), &Pass::finishedShow, &d,
           &PasswordDialog::setPass);
+  d.setFile(file);
   //    TODO(bezet): add error handling
   QtPassSettings::getPass()->Show(file);
-  d.setFile(file);
   d.usePwgen(QtPassSettings::isUsePwgen());
   d.setTemplate(QtPassSettings::getPassTemplate());
   d.useTemplate(QtPassSettings::isUseTemplate());
@@ -993,6 +1136,20 @@ void MainWindow::on_addButton_clicked() {
  * sure.
  */
 void MainWindow::on_deleteButton_clicked() {
+  QModelIndexList selected = ui->treeView->selectionModel()->selectedRows();
+  if (selected.size() > 1) {
+    QStringList paths;
+    foreach (const QModelIndex &index, selected)
+      paths << model.filePath(proxyModel.mapToSource(index));
+    if (QMessageBox::question(
+            this, tr("Delete selection?"),
+            tr("Are you sure you want to delete %n selected entries?", "",
+               paths.size()),
+            QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+      QtPassSettings::getPass()->RemoveAll(paths);
+    return;
+  }
+
   QFileInfo fileOrFolder =
       model.fileInfo(proxyModel.mapToSource(ui->treeView->currentIndex()));
   QString file = "";
@@ -1040,47 +1197,37 @@ void MainWindow::userDialog(QString dir) {
  * gets lists and opens UserDialog.
  */
 void MainWindow::on_usersButton_clicked() {
-  QList<UserInfo> users = QtPassSettings::getPass()->listKeys();
+  KeyTable users = keyring.keys();
   if (users.size() == 0) {
     QMessageBox::critical(this, tr("Can not get key list"),
                           tr("Unable to get list of available gpg keys"));
     return;
   }
-  QList<UserInfo> secret_keys = QtPassSettings::getPass()->listKeys("", true);
-  foreach (const UserInfo &sec, secret_keys) {
-    for (QList<UserInfo>::iterator it = users.begin(); it != users.end(); ++it)
-      if (sec.key_id == it->key_id)
-        it->have_secret = true;
-  }
-  QList<UserInfo> selected_users;
   QString dir =
       currentDir.isEmpty()
           ? Util::getDir(ui->treeView->currentIndex(), false, model, proxyModel)
           : currentDir;
-  int count = 0;
-  QString recipients = QtPassSettings::getPass()->getRecipientString(
-      dir.isEmpty() ? "" : dir, " ", &count);
-  if (!recipients.isEmpty())
-    selected_users = QtPassSettings::getPass()->listKeys(recipients);
-  foreach (const UserInfo &sel, selected_users) {
-    for (QList<UserInfo>::iterator it = users.begin(); it != users.end(); ++it)
-      if (sel.key_id == it->key_id)
-        it->enabled = true;
-  }
-  if (count > selected_users.size()) {
-    // Some keys seem missing from keyring, add them separately
-    QStringList recipients =
-        QtPassSettings::getPass()->getRecipientList(dir.isEmpty() ? "" : dir);
-    foreach (const QString recipient, recipients) {
-      if (QtPassSettings::getPass()->listKeys(recipient).size() < 1) {
-        UserInfo i;
-        i.enabled = true;
-        i.key_id = recipient;
-        i.name = " ?? " + tr("Key not found in keyring");
-        users.append(i);
-      }
+  QStringList recipientList =
+      QtPassSettings::getPass()->getRecipientList(dir.isEmpty() ? "" : dir);
+  QList<RecipientInfo> recipients =
+      QtPassSettings::getPass()->resolveRecipients(recipientList,
+                                                   &keyring.index());
+  QSet<quint64> selected;
+  foreach (const RecipientInfo &recipient, recipients) {
+    if (recipient.status == RecipientInfo::NOT_FOUND) {
+      // Key missing from keyring, add it separately
+      UserInfo i;
+      i.enabled = true;
+      i.key_id = recipient.recipient;
+      i.name = " ?? " + tr("Key not found in keyring");
+      users.append(i);
     }
+    foreach (const UserInfo &sel, recipient.keys)
+      selected << KeyTable::parseKeyId(sel.key_id);
   }
+  for (int row = 0; row < users.size(); ++row)
+    if (users.keyId(row) != 0 && selected.contains(users.keyId(row)))
+      users.setEnabled(row, true);
   UsersDialog d(this);
   d.setUsers(&users);
   if (!d.exec()) {
@@ -1100,6 +1247,14 @@ void MainWindow::setApp(SingleApplication *app) {
 #if SINGLE_APP
   connect(app, SIGNAL(messageAvailable(QString)), this,
           SLOT(messageAvailable(QString)));
+
+  QueryHandler *queryHandler = new QueryHandler(this);
+  connect(app, &SingleApplication::requestAvailable, queryHandler,
+          &QueryHandler::handleRequest);
+  connect(queryHandler, &QueryHandler::responseReady, app,
+          &SingleApplication::sendResponse);
+  connect(queryHandler, &QueryHandler::copyRequested, this,
+          &MainWindow::copyTextToClipboard);
 #endif
 }
 
@@ -1131,7 +1286,7 @@ void MainWindow::setText(QString text) { ui->lineEdit->setText(text); }
  * @return QStringList keys
  */
 QStringList MainWindow::getSecretKeys() {
-  QList<UserInfo> keys = QtPassSettings::getPass()->listKeys("", true);
+  QList<UserInfo> keys = keyring.secretKeys();
   QStringList names;
 
   if (keys.size() == 0)
@@ -1242,6 +1397,7 @@ void MainWindow::closeEvent(QCloseEvent *event) {
     event->ignore();
   } else {
     clearClipboard();
+    flushSync();
     QtPassSettings::setGeometry(saveGeometry());
     QtPassSettings::setSavestate(saveState());
     QtPassSettings::setMaximized(isMaximized());
@@ -1263,6 +1419,9 @@ void MainWindow::closeEvent(QCloseEvent *event) {
  * @return
  */
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
+  if (obj == ui->lineEdit && event->type() == QEvent::Paint &&
+      !deferredScheduled)
+    startDeferred();
   if (obj == ui->lineEdit && event->type() == QEvent::KeyPress) {
     QKeyEvent *key = static_cast<QKeyEvent *>(event);
     if (key->key() == Qt::Key_Down) {
@@ -3,10 +3,12 @@
 
 #include "datahelpers.h"
 #include "enums.h"
+#include "gpgkeyring.h"
 #include "imitatepass.h"
 #include "pass.h"
 #include "realpass.h"
 #include "storemodel.h"
+#include "syncscheduler.h"
 #include "trayicon.h"
 #include <QFileSystemModel>
 #include <QMainWindow>
@@ -78,6 +80,7 @@ private slots:
   void processFinished(const QString &, const QString &);
   void processError(QProcess::ProcessError);
   void clearClipboard();
+  void flushSync();
   void clearPanel(bool notify = true);
   void on_lineEdit_textChanged(const QString &arg1);
   void on_lineEdit_returnPressed();
@@ -99,9 +102,15 @@ private slots:
   void startReencryptPath();
   void endReencryptPath();
   void critical(QString, QString);
-  void passShowHandler(const QString &);
+  void passShowHandler(const QString &file, const QString &);
   void passStoreChanged(const QString &, const QString &);
   void doGitPush();
+  void syncCountsChanged(int ahead, int behind);
+  void syncFailed(int exitCode, const QString &errout);
+  void detectExecutables(bool allowStale = false);
+  void startDeferred();
+  void runDeferred();
+  void initTrayIcon();
 
   void processErrorExit(int exitCode, const QString &);
 
@@ -127,6 +136,10 @@ private:
   QString currentDir;
   bool startupPhase;
   TrayIcon *tray;
+  GpgKeyring keyring;
+  SyncScheduler sync;
+  QQueue<QPair<QObject *, const char *>> deferred;
+  bool deferredScheduled;
 
   void updateText();
   void enableUiElements(bool state);
@@ -137,7 +150,6 @@ private:
 
   void mountWebDav();
   void updateProfileBox();
-  void initTrayIcon();
   void destroyTrayIcon();
   void clearTemplateWidgets();
   void reencryptPath(QString dir);
@@ -146,6 +158,9 @@ private:
   void DisplayInTextBrowser(QString toShow, QString prefix = QString(),
                             QString postfix = QString());
   void connectPassSignalHandlers(Pass *pass);
+  void defer(QObject *receiver, const char *member);
+
+  static const int deferredFallback = 1000;
 };
 
 #endif // MAINWINDOW_H_
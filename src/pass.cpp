@@ -1,6 +1,8 @@
 #include "pass.h"
 #include "debughelper.h"
+#include "gpgkeyring.h"
 #include "qtpasssettings.h"
+#include "tracer.h"
 #include "util.h"
 #include <QTextCodec>
 #include <map>
@@ -33,7 +35,7 @@ void Pass::executeWrapper(PROCESS id, const QString &app,
 void Pass::executeWrapper(PROCESS id, const QString &app,
                           const QStringList &args, QString input,
                           bool readStdout, bool readStderr) {
-  dbg() << app << args;
+  dbgPass() << app << args;
   exec.execute(id, QtPassSettings::getPassStore(), app, args, input, readStdout,
                readStderr);
 }
@@ -55,6 +57,13 @@ void Pass::init() {
   }
 }
 
+/**
+ * @brief Pass::scheduler where git runs when the backend schedules its
+ * commands itself, so background work can wait its turn
+ * @return Q_NULLPTR when the backend does not
+ */
+TransactionScheduler *Pass::scheduler() { return Q_NULLPTR; }
+
 /**
  * @brief Pass::Generate use either pwgen or internal password
  * generator
@@ -90,11 +99,10 @@ QString Pass::Generate_b(int length, const QString &charset) {
     }
   } else {
     if (charset.length() > 0) {
-      for (int i = 0; i < length; ++i) {
-        int index = Util::rand() % charset.length();
-        QChar nextChar = charset.at(index);
-        passwd.append(nextChar);
-      }
+      passwd = generator.generate(length, charset);
+      if (passwd.isEmpty() && length > 0)
+        emit critical(tr("Can't generate password"),
+                      tr("No random data could be read from the system."));
     } else {
       emit critical(
           tr("No characters chosen"),
@@ -133,28 +141,75 @@ QList<UserInfo> Pass::listKeys(QString keystring, bool secret) {
   if (exec.executeBlocking(QtPassSettings::getGpgExecutable(), args, &p_out) !=
       0)
     return users;
-  QStringList keys = p_out.split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
-  UserInfo current_user;
-  foreach (QString key, keys) {
-    QStringList props = key.split(':');
-    if (props.size() < 10)
-      continue;
-    if (props[0] == (secret ? "sec" : "pub")) {
-      if (!current_user.key_id.isEmpty())
-        users.append(current_user);
-      current_user = UserInfo();
-      current_user.key_id = props[4];
-      current_user.name = props[9].toUtf8();
-      current_user.validity = props[1][0].toLatin1();
-      current_user.created.setTime_t(props[5].toUInt());
-      current_user.expiry.setTime_t(props[6].toUInt());
-    } else if (current_user.name.isEmpty() && props[0] == "uid") {
-      current_user.name = props[9];
-    }
+  return GpgKeyring::parseKeys(p_out, secret);
+}
+
+/**
+ * @brief Pass::resolveRecipients look up all recipients in one go instead of
+ * asking gpg for every single one.
+ * @param recipients as found in .gpg-id
+ * @param keys already parsed keyring, when not given gpg lists the keyring
+ * once
+ * @return per recipient status and matching keys, in the same order
+ */
+QList<RecipientInfo> Pass::resolveRecipients(const QStringList &recipients,
+                                             const KeyIndex *keys) {
+  if (keys != Q_NULLPTR)
+    return keys->resolve(recipients);
+  QString p_out;
+  QList<QStringList> uids;
+  QList<UserInfo> users;
+  if (!recipients.isEmpty() &&
+      exec.executeBlocking(QtPassSettings::getGpgExecutable(),
+                           {"--no-tty", "--with-colons", "--with-fingerprint",
+                            "--list-keys"},
+                           &p_out) == 0)
+    users = GpgKeyring::parseKeys(p_out, false, &uids);
+  return KeyIndex(users, uids).resolve(recipients);
+}
+
+/**
+ * @brief Pass::RemoveAll remove several files and folders, one at a time
+ * unless the backend can do better
+ * @param paths absolute paths of files and folders in the store
+ */
+void Pass::RemoveAll(const QStringList &paths) {
+  QDir store(QtPassSettings::getPassStore());
+  foreach (const QString &path, paths) {
+    bool isDir = QFileInfo(path).isDir();
+    QString file = store.relativeFilePath(path);
+    if (!isDir)
+      file.replace(QRegExp("\\.gpg$"), "");
+    Remove(file, isDir);
+  }
+}
+
+/**
+ * @brief Pass::MoveAll move several files and folders into a folder, one at
+ * a time unless the backend can do better
+ * @param srcs      absolute paths of files and folders in the store
+ * @param destDir   absolute path of the folder to move them to
+ */
+void Pass::MoveAll(const QStringList &srcs, const QString &destDir) {
+  foreach (const QString &src, srcs) {
+    QFileInfo srcInfo(src);
+    Move(src, srcInfo.isDir() ? QDir(destDir).filePath(srcInfo.fileName())
+                              : destDir);
+  }
+}
+
+/**
+ * @brief Pass::CopyAll copy several files and folders into a folder, one at
+ * a time unless the backend can do better
+ * @param srcs      absolute paths of files and folders in the store
+ * @param destDir   absolute path of the folder to copy them to
+ */
+void Pass::CopyAll(const QStringList &srcs, const QString &destDir) {
+  foreach (const QString &src, srcs) {
+    QFileInfo srcInfo(src);
+    Copy(src, srcInfo.isDir() ? QDir(destDir).filePath(srcInfo.fileName())
+                              : destDir);
   }
-  if (!current_user.key_id.isEmpty())
-    users.append(current_user);
-  return users;
 }
 
 /**
@@ -169,11 +224,18 @@ QList<UserInfo> Pass::listKeys(QString keystring, bool secret) {
  */
 void Pass::finished(int id, int exitCode, const QString &out,
                     const QString &err) {
-  //  TODO(bezet): remove !
-  dbg() << id << exitCode << out << err;
+  Tracer::Span span("Pass::finished");
+  // out is not logged, it holds decrypted passwords
+  dbgPass() << "finished" << id << exitCode << err;
 
   PROCESS pid = static_cast<PROCESS>(id);
+  // backends that finish decryptions in order keep the files in showing
+  QString shown;
+  if (pid == PASS_SHOW && !showing.isEmpty())
+    shown = showing.dequeue();
   if (exitCode != 0) {
+    if (!shown.isNull())
+      emit failedShow(shown, exitCode, err);
     emit processErrorExit(exitCode, err);
     return;
   }
@@ -188,7 +250,8 @@ void Pass::finished(int id, int exitCode, const QString &out,
     emit finishedGitPush(out, err);
     break;
   case PASS_SHOW:
-    emit finishedShow(out);
+    if (!shown.isNull())
+      emit finishedShow(shown, out);
     break;
   case PASS_INSERT:
     emit finishedInsert(out, err);
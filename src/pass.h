@@ -4,6 +4,8 @@
 #include "datahelpers.h"
 #include "enums.h"
 #include "executor.h"
+#include "keyindex.h"
+#include "passwordgenerator.h"
 #include <QDebug>
 #include <QDir>
 #include <QList>
@@ -11,6 +13,8 @@
 #include <QQueue>
 #include <QString>
 
+class TransactionScheduler;
+
 /*!
     \class Pass
     \brief Acts as an abstraction for pass or pass imitation
@@ -19,10 +23,12 @@ class Pass : public QObject {
   Q_OBJECT
 
   bool wrapperRunning;
-  QStringList env;
+  PasswordGenerator generator;
 
 protected:
+  QStringList env;
   Executor exec;
+  QQueue<QString> showing;
 
   typedef Enums::PROCESS PROCESS;
 
@@ -42,11 +48,17 @@ public:
                     const bool force = false) = 0;
   virtual void Copy(const QString srcDir, const QString dest,
                     const bool force = false) = 0;
-  virtual void Init(QString path, const QList<UserInfo> &users) = 0;
+  virtual void Init(QString path, const KeyTable &users) = 0;
+  virtual void RemoveAll(const QStringList &paths);
+  virtual void MoveAll(const QStringList &srcs, const QString &destDir);
+  virtual void CopyAll(const QStringList &srcs, const QString &destDir);
   virtual QString Generate_b(int length, const QString &charset);
+  virtual TransactionScheduler *scheduler();
 
   void GenerateGPGKeys(QString batch);
   QList<UserInfo> listKeys(QString keystring = "", bool secret = false);
+  QList<RecipientInfo> resolveRecipients(const QStringList &recipients,
+                                         const KeyIndex *keys = Q_NULLPTR);
   void updateEnv();
   static QStringList getRecipientList(QString for_file);
   //  TODO(bezet): getRecipientString is useless, refactor
@@ -77,7 +89,8 @@ signals:
   void finishedGitInit(const QString &, const QString &);
   void finishedGitPull(const QString &, const QString &);
   void finishedGitPush(const QString &, const QString &);
-  void finishedShow(const QString &);
+  void finishedShow(const QString &file, const QString &output);
+  void failedShow(const QString &file, int exitCode, const QString &err);
   void finishedInsert(const QString &, const QString &);
   void finishedRemove(const QString &, const QString &);
   void finishedInit(const QString &, const QString &);
@@ -146,6 +146,7 @@ void PasswordDialog::setTemplate(QString rawFields) {
  * @param file
  */
 void PasswordDialog::setFile(QString file) {
+  passFile = file;
   this->setWindowTitle(this->windowTitle() + " " + file);
 }
 
@@ -189,7 +190,15 @@ void PasswordDialog::usePwgen(bool usePwgen) {
   ui->label_characterset->setDisabled(usePwgen);
 }
 
-void PasswordDialog::setPass(const QString &output) {
+/**
+ * @brief PasswordDialog::setPass fill in the decrypted file being edited,
+ * other decryptions that finish meanwhile are ignored.
+ * @param file
+ * @param output
+ */
+void PasswordDialog::setPass(const QString &file, const QString &output) {
+  if (file != passFile)
+    return;
   setPassword(output);
   //    TODO(bezet): enable ui
 }
@@ -53,7 +53,7 @@ public:
   void usePwgen(bool usePwgen);
 
 public slots:
-  void setPass(const QString &output);
+  void setPass(const QString &file, const QString &output);
 
 private slots:
   void on_checkBoxShow_stateChanged(int arg1);
@@ -63,6 +63,7 @@ private:
   Ui::PasswordDialog *ui;
   const passwordConfiguration &m_passConfig;
   QString passTemplate;
+  QString passFile;
   QStringList fields;
   bool templating;
   bool allFields;
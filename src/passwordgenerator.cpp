@@ -0,0 +1,168 @@
+#include "passwordgenerator.h"
+#include "debughelper.h"
+#include <QFile>
+#include <cstring>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <bcrypt.h>
+#elif defined(Q_OS_LINUX)
+#include <cerrno>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <stdlib.h>
+#endif
+
+/**
+ * @brief PasswordGenerator::PasswordGenerator nothing is read from the
+ * system until it is needed.
+ */
+PasswordGenerator::PasswordGenerator() : used(0) {}
+
+/**
+ * @brief PasswordGenerator::~PasswordGenerator does not leave unused random
+ * bytes in freed memory.
+ */
+PasswordGenerator::~PasswordGenerator() {
+  if (!pool.isEmpty())
+    memset(pool.data(), 0, static_cast<size_t>(pool.size()));
+}
+
+/**
+ * @brief PasswordGenerator::generate a password.
+ * @param length
+ * @param charset   characters to choose from, every one equally likely
+ * @return empty when the charset is empty or no random bytes could be read
+ */
+QString PasswordGenerator::generate(int length, const QString &charset) {
+  QStringList passwords = generate(1, length, charset);
+  return passwords.isEmpty() ? QString() : passwords.first();
+}
+
+/**
+ * @brief PasswordGenerator::generate many passwords at once, e.g. to
+ * provision accounts in bulk.
+ * @param count
+ * @param length
+ * @param charset   characters to choose from, every one equally likely
+ * @return empty when the charset is empty or no random bytes could be read
+ */
+QStringList PasswordGenerator::generate(int count, int length,
+                                        const QString &charset) {
+  QStringList passwords;
+  if (charset.isEmpty() || length <= 0)
+    return passwords;
+  quint32 bound = static_cast<quint32>(charset.length());
+  const QChar *characters = charset.constData();
+  passwords.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    QString password(length, QChar());
+    QChar *out = password.data();
+    for (int j = 0; j < length; ++j) {
+      quint32 index;
+      if (!uniform(bound, &index))
+        return QStringList();
+      out[j] = characters[index];
+    }
+    passwords.append(password);
+  }
+  return passwords;
+}
+
+/**
+ * @brief PasswordGenerator::uniform a random number below bound, without the
+ * bias of taking a random number modulo bound.
+ *
+ * Values from the top of the range that would make some results more likely
+ * are drawn again. One byte is used per draw for bounds up to 256, which
+ * covers every charset QtPass offers, four bytes otherwise.
+ * @param bound     larger than 0
+ * @param value     receives the number
+ * @return false when no random bytes could be read
+ */
+bool PasswordGenerator::uniform(quint32 bound, quint32 *value) {
+  if (bound <= 256) {
+    // the largest multiple of bound that fits in a byte
+    quint32 limit = 256 - 256 % bound;
+    uchar byte;
+    do {
+      if (!take(&byte, 1))
+        return false;
+    } while (byte >= limit);
+    *value = byte % bound;
+    return true;
+  }
+  // 2^32 % bound, computed in 32 bits
+  quint32 threshold = (0u - bound) % bound;
+  quint32 random;
+  do {
+    if (!take(reinterpret_cast<uchar *>(&random), sizeof(random)))
+      return false;
+  } while (random < threshold);
+  *value = random % bound;
+  return true;
+}
+
+/**
+ * @brief PasswordGenerator::take the next random bytes from the pool.
+ * @param data
+ * @param size  at most poolSize
+ * @return false when the pool could not be refilled
+ */
+bool PasswordGenerator::take(uchar *data, int size) {
+  if (pool.size() - used < size && !refill())
+    return false;
+  uchar *bytes = reinterpret_cast<uchar *>(pool.data()) + used;
+  memcpy(data, bytes, static_cast<size_t>(size));
+  // bytes that were handed out are not kept around
+  memset(bytes, 0, static_cast<size_t>(size));
+  used += size;
+  return true;
+}
+
+/**
+ * @brief PasswordGenerator::refill read a new block from the system.
+ */
+bool PasswordGenerator::refill() {
+  pool.resize(poolSize);
+  used = 0;
+  if (fill(reinterpret_cast<uchar *>(pool.data()), pool.size()))
+    return true;
+  dbg() << "could not read random bytes from the system";
+  used = pool.size();
+  return false;
+}
+
+/**
+ * @brief PasswordGenerator::fill random bytes from the operating system.
+ * @param data
+ * @param size
+ */
+bool PasswordGenerator::fill(uchar *data, int size) {
+#if defined(Q_OS_WIN)
+  return !FAILED(BCryptGenRandom(NULL, static_cast<PUCHAR>(data),
+                                 static_cast<ULONG>(size),
+                                 BCRYPT_USE_SYSTEM_PREFERRED_RNG));
+#elif defined(Q_OS_LINUX)
+#ifdef SYS_getrandom
+  int done = 0;
+  while (done < size) {
+    long n = syscall(SYS_getrandom, data + done,
+                     static_cast<size_t>(size - done), 0);
+    if (n > 0)
+      done += static_cast<int>(n);
+    else if (n < 0 && errno != EINTR)
+      break;
+  }
+  if (done == size)
+    return true;
+#endif
+  // kernels before 3.17 have no getrandom
+  QFile urandom("/dev/urandom");
+  return urandom.open(QIODevice::ReadOnly | QIODevice::Unbuffered) &&
+         urandom.read(reinterpret_cast<char *>(data), size) == size;
+#else
+  arc4random_buf(data, static_cast<size_t>(size));
+  return true;
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef PASSWORDGENERATOR_H_
+#define PASSWORDGENERATOR_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/*!
+    \class PasswordGenerator
+    \brief Generates passwords from the random source of the operating
+    system.
+
+    Random bytes are read in blocks, from getrandom() on Linux,
+    arc4random_buf() on macOS and the BSDs and BCryptGenRandom() on Windows,
+    and every character is picked with rejection sampling so all characters
+    of the charset are equally likely. Generating many passwords with one
+    generator only asks the system for more bytes once a block is used up.
+ */
+class PasswordGenerator {
+public:
+  PasswordGenerator();
+  ~PasswordGenerator();
+
+  QString generate(int length, const QString &charset);
+  QStringList generate(int count, int length, const QString &charset);
+  bool uniform(quint32 bound, quint32 *value);
+
+private:
+  QByteArray pool;
+  int used;
+
+  bool take(uchar *data, int size);
+  bool refill();
+  static bool fill(uchar *data, int size);
+
+  static const int poolSize = 4096;
+};
+
+#endif // PASSWORDGENERATOR_H_
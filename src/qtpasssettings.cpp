@@ -15,8 +15,22 @@ QHash<QString, int> QtPassSettings::intSettings;
 QHash<QString, bool> QtPassSettings::boolSettings;
 
 Pass *QtPassSettings::pass;
-RealPass QtPassSettings::realPass;
-ImitatePass QtPassSettings::imitatePass;
+QScopedPointer<RealPass> QtPassSettings::realPass;
+QScopedPointer<ImitatePass> QtPassSettings::imitatePass;
+
+/**
+ * @brief instantiate create a backend the first time it is used, so only the
+ * backend that is configured spawns an executor and copies the environment.
+ * @param backend
+ * @return
+ */
+template <class T> static T *instantiate(QScopedPointer<T> &backend) {
+  if (backend.isNull()) {
+    backend.reset(new T());
+    backend->init();
+  }
+  return backend.data();
+}
 
 QString QtPassSettings::getVersion(const QString &defaultValue) {
   return getStringValue(SettingsConstants::version, defaultValue);
@@ -125,9 +139,9 @@ bool QtPassSettings::isUsePass(const bool &defaultValue) {
 
 void QtPassSettings::setUsePass(const bool &usePass) {
   if (usePass) {
-    QtPassSettings::pass = &QtPassSettings::realPass;
+    QtPassSettings::pass = getRealPass();
   } else {
-    QtPassSettings::pass = &QtPassSettings::imitatePass;
+    QtPassSettings::pass = getImitatePass();
   }
   setBoolValue(SettingsConstants::usePass, usePass);
 }
@@ -430,6 +444,14 @@ void QtPassSettings::setAutoPush(const bool &autoPush) {
   setBoolValue(SettingsConstants::autoPush, autoPush);
 }
 
+int QtPassSettings::getSyncInterval(const int &defaultValue) {
+  return getIntValue(SettingsConstants::syncInterval, defaultValue);
+}
+
+void QtPassSettings::setSyncInterval(const int &syncInterval) {
+  setIntValue(SettingsConstants::syncInterval, syncInterval);
+}
+
 QString QtPassSettings::getPassTemplate(const QString &defaultValue) {
   return getStringValue(SettingsConstants::passTemplate, defaultValue);
 }
@@ -479,6 +501,27 @@ void QtPassSettings::setProfiles(const QHash<QString, QString> &profiles) {
   endSettingsGroup();
 }
 
+QHash<QString, QString> QtPassSettings::getBinaryCache() {
+  beginBinariesGroup();
+  QStringList childrenKeys = getChildKeysFromCurrentGroup();
+  QHash<QString, QString> binaries;
+  foreach (QString key, childrenKeys) {
+    binaries.insert(key, getSetting(key).toString());
+  }
+  endSettingsGroup();
+  return binaries;
+}
+
+void QtPassSettings::setBinaryCache(const QHash<QString, QString> &binaries) {
+  getSettings().remove(SettingsConstants::groupBinaries);
+  beginBinariesGroup();
+  QHash<QString, QString>::const_iterator i = binaries.begin();
+  for (; i != binaries.end(); ++i) {
+    setSetting(i.key(), i.value());
+  }
+  endSettingsGroup();
+}
+
 QSettings &QtPassSettings::getSettings() {
   if (!QtPassSettings::initialized) {
     QString portable_ini = QCoreApplication::applicationDirPath() +
@@ -611,6 +654,10 @@ void QtPassSettings::beginProfilesGroup() {
   getSettings().beginGroup(SettingsConstants::groupProfiles);
 }
 
+void QtPassSettings::beginBinariesGroup() {
+  getSettings().beginGroup(SettingsConstants::groupBinaries);
+}
+
 QVariant QtPassSettings::getSetting(const QString &key,
                                     const QVariant &defaultValue) {
   return getSettings().value(key, defaultValue);
@@ -623,15 +670,16 @@ void QtPassSettings::setSetting(const QString &key, const QVariant &value) {
 Pass *QtPassSettings::getPass() {
   if (!pass) {
     if (isUsePass()) {
-      QtPassSettings::pass = &QtPassSettings::realPass;
+      QtPassSettings::pass = getRealPass();
     } else {
-      QtPassSettings::pass = &QtPassSettings::imitatePass;
+      QtPassSettings::pass = getImitatePass();
     }
-    pass->init();
   }
   return pass;
 }
 
-ImitatePass *QtPassSettings::getImitatePass() { return &imitatePass; }
+ImitatePass *QtPassSettings::getImitatePass() {
+  return instantiate(imitatePass);
+}
 
-RealPass *QtPassSettings::getRealPass() { return &realPass; }
+RealPass *QtPassSettings::getRealPass() { return instantiate(realPass); }
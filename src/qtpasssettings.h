@@ -173,6 +173,9 @@ public:
   static bool isAutoPush(const bool &defaultValue = QVariant().toBool());
   static void setAutoPush(const bool &autoPush);
 
+  static int getSyncInterval(const int &defaultValue = QVariant().toInt());
+  static void setSyncInterval(const int &syncInterval);
+
   static QString
   getPassTemplate(const QString &defaultValue = QVariant().toString());
   static void setPassTemplate(const QString &passTemplate);
@@ -187,6 +190,9 @@ public:
   static QHash<QString, QString> getProfiles();
   static void setProfiles(const QHash<QString, QString> &profiles);
 
+  static QHash<QString, QString> getBinaryCache();
+  static void setBinaryCache(const QHash<QString, QString> &binaries);
+
   static Pass *getPass();
   static RealPass *getRealPass();
   static ImitatePass *getImitatePass();
@@ -211,8 +217,8 @@ private:
   static QHash<QString, bool> boolSettings;
 
   static Pass *pass;
-  static RealPass realPass;
-  static ImitatePass imitatePass;
+  static QScopedPointer<RealPass> realPass;
+  static QScopedPointer<ImitatePass> imitatePass;
 
   // functions
   static QSettings &getSettings();
@@ -240,6 +246,7 @@ private:
 
   static void beginMainwindowGroup();
   static void beginProfilesGroup();
+  static void beginBinariesGroup();
 
   static QVariant getSetting(const QString &key,
                              const QVariant &defaultValue = QVariant());
@@ -0,0 +1,134 @@
+#include "queryhandler.h"
+#include "imitatepass.h"
+#include "qtpasssettings.h"
+#include "realpass.h"
+
+/**
+ * @brief QueryHandler::QueryHandler
+ * @param parent
+ */
+QueryHandler::QueryHandler(QObject *parent)
+    : QObject(parent), passIsReal(false) {}
+
+/**
+ * @brief QueryHandler::~QueryHandler needed for the QScopedPointer<Pass>
+ */
+QueryHandler::~QueryHandler() {}
+
+/**
+ * @brief QueryHandler::handleRequest answer SEARCH right away, SHOW and COPY
+ * once the entry has been decrypted.
+ * @param connection
+ * @param request
+ */
+void QueryHandler::handleRequest(quint32 connection,
+                                 const IpcRequest &request) {
+  QStringList entries = index.find(request.argument);
+  if (request.command == IpcRequest::SEARCH) {
+    emit responseReady(
+        connection,
+        IpcResponse(request.id, entries.isEmpty() ? IpcResponse::NOT_FOUND
+                                                  : IpcResponse::OK,
+                    entries));
+    return;
+  }
+  if (request.command != IpcRequest::SHOW &&
+      request.command != IpcRequest::COPY) {
+    emit responseReady(connection,
+                       IpcResponse(request.id, IpcResponse::BAD_REQUEST));
+    return;
+  }
+  if (request.argument.isEmpty() || entries.isEmpty()) {
+    emit responseReady(connection,
+                       IpcResponse(request.id, IpcResponse::NOT_FOUND));
+    return;
+  }
+  if (entries.size() > 1) {
+    emit responseReady(
+        connection, IpcResponse(request.id, IpcResponse::AMBIGUOUS, entries));
+    return;
+  }
+  Pass *backend = getPass();
+  PendingRequest item = {connection, request, entries.first()};
+  pending.append(item);
+  backend->Show(entries.first());
+}
+
+/**
+ * @brief QueryHandler::passShowHandler decryption of an entry finished, it
+ * answers the oldest request pending for it.
+ * @param file      the entry
+ * @param output
+ */
+void QueryHandler::passShowHandler(const QString &file,
+                                   const QString &output) {
+  PendingRequest item;
+  if (!takePending(file, &item))
+    return;
+  if (item.request.command == IpcRequest::COPY) {
+    emit copyRequested(output.split("\n").at(0));
+    emit responseReady(item.connection,
+                       IpcResponse(item.request.id, IpcResponse::OK));
+  } else {
+    emit responseReady(item.connection,
+                       IpcResponse(item.request.id, IpcResponse::OK,
+                                   QStringList() << output));
+  }
+}
+
+/**
+ * @brief QueryHandler::failedShow decryption of an entry failed, it fails
+ * the oldest request pending for it.
+ * @param file      the entry
+ * @param exitCode
+ * @param err
+ */
+void QueryHandler::failedShow(const QString &file, int exitCode,
+                              const QString &err) {
+  Q_UNUSED(exitCode);
+  PendingRequest item;
+  if (!takePending(file, &item))
+    return;
+  emit responseReady(item.connection,
+                     IpcResponse(item.request.id, IpcResponse::FAILED,
+                                 QStringList() << err));
+}
+
+/**
+ * @brief QueryHandler::takePending remove the oldest request pending for an
+ * entry.
+ * @param entry
+ * @param item      set to the request
+ * @return false when no request waits for the entry
+ */
+bool QueryHandler::takePending(const QString &entry, PendingRequest *item) {
+  for (int i = 0; i < pending.size(); ++i) {
+    if (pending.at(i).entry == entry) {
+      *item = pending.takeAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief QueryHandler::getPass our own backend, (re)created when the
+ * configured kind of backend changed and nothing is pending on the old one.
+ * @return
+ */
+Pass *QueryHandler::getPass() {
+  bool usePass = QtPassSettings::isUsePass();
+  if (pass.isNull() || (passIsReal != usePass && pending.isEmpty())) {
+    if (usePass)
+      pass.reset(new RealPass());
+    else
+      pass.reset(new ImitatePass());
+    passIsReal = usePass;
+    connect(pass.data(), &Pass::finishedShow, this,
+            &QueryHandler::passShowHandler);
+    connect(pass.data(), &Pass::failedShow, this, &QueryHandler::failedShow);
+    pass->init();
+  }
+  pass->updateEnv();
+  return pass.data();
+}
@@ -0,0 +1,67 @@
+#ifndef QUERYHANDLER_H_
+#define QUERYHANDLER_H_
+
+#include "ipcprotocol.h"
+#include "storeindex.h"
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+
+class Pass;
+
+/*!
+    \class QueryHandler
+    \brief Answers requests other processes send to the running instance.
+
+    Lookups are served from a StoreIndex. Decryption runs on a Pass backend
+    of its own, so remote requests never show up in (or interfere with) the
+    main window.
+ */
+class QueryHandler : public QObject {
+  Q_OBJECT
+
+public:
+  explicit QueryHandler(QObject *parent = 0);
+  ~QueryHandler();
+
+public slots:
+  void handleRequest(quint32 connection, const IpcRequest &request);
+
+signals:
+  /**
+   * @brief responseReady the answer for a request is known
+   * @param connection as passed to QueryHandler::handleRequest
+   * @param response
+   */
+  void responseReady(quint32 connection, const IpcResponse &response);
+  /**
+   * @brief copyRequested a client asked to copy a password to the clipboard
+   * @param text
+   */
+  void copyRequested(const QString &text);
+
+private slots:
+  void passShowHandler(const QString &file, const QString &output);
+  void failedShow(const QString &file, int exitCode, const QString &err);
+
+private:
+  /*!
+      \struct PendingRequest
+      \brief A request waiting for its decryption to finish.
+   */
+  struct PendingRequest {
+    quint32 connection;
+    IpcRequest request;
+    QString entry;
+  };
+
+  StoreIndex index;
+  QScopedPointer<Pass> pass;
+  bool passIsReal;
+  QList<PendingRequest> pending;
+
+  Pass *getPass();
+  bool takePending(const QString &entry, PendingRequest *item);
+};
+
+#endif // QUERYHANDLER_H_
@@ -38,6 +38,9 @@ void RealPass::GitPush() { executePass(GIT_PUSH, {"git", "push"}); }
  *          otherwise returns QProcess::NormalExit
  */
 void RealPass::Show(QString file) {
+  // the executor runs one pass at a time, results come in this order
+  if (!QtPassSettings::getPassExecutable().isEmpty())
+    showing.enqueue(file);
   executePass(PASS_SHOW, {"show", file}, "", true);
 }
 
@@ -65,16 +68,16 @@ void RealPass::Remove(QString file, bool isDir) {
  * @param path  Absolute path to new password-store
  * @param users list of users with ability to decrypt new password-store
  */
-void RealPass::Init(QString path, const QList<UserInfo> &users) {
+void RealPass::Init(QString path, const KeyTable &users) {
   // remove the passStore directory otherwise,
   // pass would create a passStore/passStore/dir
   // but you want passStore/dir
   QString dirWithoutPassdir =
       path.remove(0, QtPassSettings::getPassStore().size());
   QStringList args = {"init", "--path=" + dirWithoutPassdir};
-  foreach (const UserInfo &user, users) {
-    if (user.enabled)
-      args.append(user.key_id);
+  for (int row = 0; row < users.size(); ++row) {
+    if (users.isEnabled(row))
+      args.append(users.keyIdText(row).toString());
   }
   executePass(PASS_INIT, args);
 }
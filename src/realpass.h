@@ -24,7 +24,7 @@ public:
   virtual void Insert(QString file, QString value,
                       bool overwrite = false) Q_DECL_OVERRIDE;
   virtual void Remove(QString file, bool isDir = false) Q_DECL_OVERRIDE;
-  virtual void Init(QString path, const QList<UserInfo> &users) Q_DECL_OVERRIDE;
+  virtual void Init(QString path, const KeyTable &users) Q_DECL_OVERRIDE;
 
   // Pass interface
 public:
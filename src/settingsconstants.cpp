@@ -33,6 +33,7 @@ const QString SettingsConstants::webDavUser = "webDavUser";
 const QString SettingsConstants::webDavPassword = "webDavPassword";
 const QString SettingsConstants::profile = "profile";
 const QString SettingsConstants::groupProfiles = "profiles";
+const QString SettingsConstants::groupBinaries = "binaries";
 const QString SettingsConstants::useGit = "useGit";
 const QString SettingsConstants::useClipboard = "useClipboard";
 const QString SettingsConstants::usePwgen = "usePwgen";
@@ -50,6 +51,7 @@ const QString SettingsConstants::startMinimized = "startMinimized";
 const QString SettingsConstants::alwaysOnTop = "alwaysOnTop";
 const QString SettingsConstants::autoPull = "autoPull";
 const QString SettingsConstants::autoPush = "autoPush";
+const QString SettingsConstants::syncInterval = "syncInterval";
 const QString SettingsConstants::passTemplate = "passTemplate";
 const QString SettingsConstants::useTemplate = "useTemplate";
 const QString SettingsConstants::templateAllFields = "templateAllFields";
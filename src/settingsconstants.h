@@ -40,6 +40,7 @@ public:
   const static QString webDavPassword;
   const static QString profile;
   const static QString groupProfiles;
+  const static QString groupBinaries;
   const static QString useGit;
   const static QString useClipboard;
   const static QString usePwgen;
@@ -56,6 +57,7 @@ public:
   const static QString alwaysOnTop;
   const static QString autoPull;
   const static QString autoPush;
+  const static QString syncInterval;
   const static QString passTemplate;
   const static QString useTemplate;
   const static QString templateAllFields;
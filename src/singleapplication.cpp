@@ -1,6 +1,6 @@
 #include "singleapplication.h"
 #include "debughelper.h"
-#include <QLocalSocket>
+#include "ipcclient.h"
 
 /**
  * @brief SingleApplication::SingleApplication this replaces the QApplication
@@ -11,7 +11,8 @@
  */
 SingleApplication::SingleApplication(int &argc, char *argv[],
                                      const QString uniqueKey)
-    : QApplication(argc, argv), _uniqueKey(uniqueKey) {
+    : QApplication(argc, argv), _uniqueKey(uniqueKey), lastConnection(0),
+      processingScheduled(false) {
   sharedMemory.setKey(_uniqueKey);
   if (sharedMemory.attach()) {
     _isRunning = true;
@@ -25,28 +26,135 @@ SingleApplication::SingleApplication(int &argc, char *argv[],
     // create local server and listen to incomming messages from other
     // instances.
     localServer.reset(new QLocalServer(this));
+    localServer->setMaxPendingConnections(maxConnections);
     connect(localServer.data(), SIGNAL(newConnection()), this,
             SLOT(receiveMessage()));
-    localServer->listen(_uniqueKey);
+    localServer->setSocketOptions(QLocalServer::UserAccessOption);
+    // no instance is running, so a socket left behind by a crash is stale
+    QLocalServer::removeServer(_uniqueKey);
+    if (!localServer->listen(_uniqueKey))
+      dbg() << "Unable to listen on" << _uniqueKey
+            << localServer->errorString();
+    idleTimer.setInterval(stalledTimeout);
+    connect(&idleTimer, SIGNAL(timeout()), this, SLOT(dropIdleConnections()));
   }
 }
 
 // public slots.
 
 /**
- * @brief SingleApplication::receiveMessage we have received (a command line)
- * message.
+ * @brief SingleApplication::receiveMessage a client connected, its requests
+ * are read as they arrive for as long as it stays connected.
  */
 void SingleApplication::receiveMessage() {
-  QLocalSocket *localSocket = localServer->nextPendingConnection();
-  if (!localSocket->waitForReadyRead(timeout)) {
-    dbg() << localSocket->errorString().toLatin1();
+  while (localServer->hasPendingConnections()) {
+    QLocalSocket *localSocket = localServer->nextPendingConnection();
+    if (!IpcProtocol::isPeerTrusted(*localSocket)) {
+      dbg() << "Client runs as another user, refusing connection";
+      localSocket->abort();
+      localSocket->deleteLater();
+      continue;
+    }
+    if (connections.size() >= maxConnections) {
+      dbg() << "Too many clients, refusing connection";
+      localSocket->abort();
+      localSocket->deleteLater();
+      continue;
+    }
+    // the socket stops reading once this much waits, so a client writing
+    // while its requests are paused fills its own pipe instead of our memory
+    localSocket->setReadBufferSize(maxBufferedBytes);
+    Connection connection;
+    connection.id = ++lastConnection;
+    connection.pending = 0;
+    connection.lastActivity.start();
+    connections.insert(localSocket, connection);
+    sockets.insert(connection.id, localSocket);
+    connect(localSocket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+    connect(localSocket, SIGNAL(disconnected()), this,
+            SLOT(connectionClosed()));
+  }
+  if (!connections.isEmpty() && !idleTimer.isActive())
+    idleTimer.start();
+}
+
+/**
+ * @brief SingleApplication::sendResponse answer a request received through
+ * SingleApplication::requestAvailable. Responses for clients that are gone
+ * are dropped.
+ * @param connection
+ * @param response
+ */
+void SingleApplication::sendResponse(quint32 connection,
+                                     const IpcResponse &response) {
+  QLocalSocket *localSocket = sockets.value(connection);
+  if (localSocket == Q_NULLPTR) {
+    dbg() << "Dropping response for closed connection" << connection;
+    return;
+  }
+  Connection &client = connections[localSocket];
+  if (--client.pending < maxPendingRequests &&
+      (!client.buffer.isEmpty() || localSocket->bytesAvailable() > 0))
+    scheduleProcessing();
+  respond(localSocket, response);
+}
+
+// private slots.
+
+/**
+ * @brief SingleApplication::readRequests collect incoming data, a client may
+ * send several requests at once.
+ */
+void SingleApplication::readRequests() {
+  QLocalSocket *localSocket = qobject_cast<QLocalSocket *>(sender());
+  if (localSocket == Q_NULLPTR || !connections.contains(localSocket))
     return;
+  connections[localSocket].lastActivity.restart();
+  processConnection(localSocket);
+}
+
+/**
+ * @brief SingleApplication::processConnections continue with requests left
+ * over by an earlier pass.
+ */
+void SingleApplication::processConnections() {
+  processingScheduled = false;
+  foreach (QLocalSocket *localSocket, connections.keys())
+    processConnection(localSocket);
+}
+
+/**
+ * @brief SingleApplication::connectionClosed forget about a client.
+ */
+void SingleApplication::connectionClosed() {
+  QLocalSocket *localSocket = qobject_cast<QLocalSocket *>(sender());
+  if (localSocket == Q_NULLPTR)
+    return;
+  sockets.remove(connections.take(localSocket).id);
+  localSocket->deleteLater();
+  if (connections.isEmpty())
+    idleTimer.stop();
+}
+
+/**
+ * @brief SingleApplication::dropIdleConnections disconnect clients stuck
+ * halfway through a frame and clients that have been quiet for long.
+ */
+void SingleApplication::dropIdleConnections() {
+  foreach (QLocalSocket *localSocket, connections.keys()) {
+    // aborting a client removes it right away
+    if (!connections.contains(localSocket))
+      continue;
+    const Connection &connection = connections[localSocket];
+    if (connection.pending > 0)
+      continue;
+    qint64 quiet = connection.lastActivity.elapsed();
+    if ((!connection.buffer.isEmpty() && quiet > stalledTimeout) ||
+        quiet > idleTimeout) {
+      dbg() << "Dropping idle client" << connection.id;
+      localSocket->abort();
+    }
   }
-  QByteArray byteArray = localSocket->readAll();
-  QString message = QString::fromUtf8(byteArray.constData());
-  emit messageAvailable(message);
-  localSocket->disconnectFromServer();
 }
 
 // public functions.
@@ -66,17 +174,98 @@ bool SingleApplication::isRunning() { return _isRunning; }
 bool SingleApplication::sendMessage(const QString &message) {
   if (!_isRunning)
     return false;
-  QLocalSocket localSocket(this);
-  localSocket.connectToServer(_uniqueKey, QIODevice::WriteOnly);
-  if (!localSocket.waitForConnected(timeout)) {
-    dbg() << localSocket.errorString().toLatin1();
-    return false;
+  IpcResponse response;
+  return IpcClient(_uniqueKey).request(IpcRequest::QUERY, message,
+                                       &response) &&
+         response.status == IpcResponse::OK;
+}
+
+// private functions.
+
+/**
+ * @brief SingleApplication::processConnection handle the complete frames of
+ * a client, a limited number per pass and as long as not too many of its
+ * requests are in flight. Data is only read from the socket while requests
+ * are taken, whatever is left is picked up later.
+ * @param localSocket
+ */
+void SingleApplication::processConnection(QLocalSocket *localSocket) {
+  QByteArray payload;
+  for (int handled = 0; handled < maxFramesPerPass; ++handled) {
+    // handling a request can end up closing the connection
+    if (!connections.contains(localSocket))
+      return;
+    Connection &connection = connections[localSocket];
+    if (connection.pending >= maxPendingRequests)
+      return;
+    // at most one frame of the largest size and its header is buffered
+    int room = maxBufferedBytes - connection.buffer.size();
+    if (room > 0 && localSocket->bytesAvailable() > 0)
+      connection.buffer += localSocket->read(room);
+    switch (IpcProtocol::takeFrame(&connection.buffer, &payload)) {
+    case IpcProtocol::FRAME_INCOMPLETE:
+      return;
+    case IpcProtocol::FRAME_COMPLETE:
+      handleRequest(localSocket, connection.id, payload);
+      break;
+    case IpcProtocol::FRAME_INVALID:
+      dbg() << "Invalid frame, dropping client";
+      localSocket->abort();
+      return;
+    }
   }
-  localSocket.write(message.toUtf8());
-  if (!localSocket.waitForBytesWritten(timeout)) {
-    dbg() << localSocket.errorString().toLatin1();
-    return false;
+  scheduleProcessing();
+}
+
+/**
+ * @brief SingleApplication::scheduleProcessing run processConnections once
+ * the event loop had its turn.
+ */
+void SingleApplication::scheduleProcessing() {
+  if (processingScheduled)
+    return;
+  processingScheduled = true;
+  QMetaObject::invokeMethod(this, "processConnections", Qt::QueuedConnection);
+}
+
+/**
+ * @brief SingleApplication::handleRequest decode a request, answer QUERY
+ * right away and hand everything else to whoever listens to
+ * SingleApplication::requestAvailable.
+ * @param localSocket
+ * @param connection
+ * @param payload
+ */
+void SingleApplication::handleRequest(QLocalSocket *localSocket,
+                                      quint32 connection,
+                                      const QByteArray &payload) {
+  IpcRequest request;
+  IpcResponse::Status status = IpcProtocol::decodeRequest(payload, &request);
+  if (status != IpcResponse::OK) {
+    respond(localSocket, IpcResponse(request.id, status));
+  } else if (request.command == IpcRequest::QUERY) {
+    emit messageAvailable(request.argument);
+    respond(localSocket, IpcResponse(request.id, IpcResponse::OK));
+  } else {
+    ++connections[localSocket].pending;
+    emit requestAvailable(connection, request);
+  }
+}
+
+/**
+ * @brief SingleApplication::respond write a response frame, the connection
+ * stays open for further requests.
+ * @param localSocket
+ * @param response
+ */
+void SingleApplication::respond(QLocalSocket *localSocket,
+                                const IpcResponse &response) {
+  if (localSocket->bytesToWrite() > maxUnsentBytes) {
+    dbg() << "Client does not read its responses, dropping it";
+    localSocket->abort();
+    return;
   }
-  localSocket.disconnectFromServer();
-  return true;
+  localSocket->write(IpcProtocol::encodeResponse(response));
+  if (connections.contains(localSocket))
+    connections[localSocket].lastActivity.restart();
 }
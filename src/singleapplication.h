@@ -1,15 +1,28 @@
 #ifndef SINGLEAPPLICATION_H_
 #define SINGLEAPPLICATION_H_
 
+#include "ipcprotocol.h"
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QLocalServer>
+#include <QLocalSocket>
 #include <QSharedMemory>
+#include <QTimer>
 
 /*!
     \class SingleApplication
     \brief The SingleApplication class is used for commandline intergration.
 
-    This class needs a bit of work or possibly replacement.
+    Besides making sure only one QtPass runs it serves the IpcProtocol on a
+    local socket, so other processes can query the running instance. Clients
+    may keep their connection open and pipeline requests, responses carry the
+    request id and can come back in any order.
+
+    Everything is driven by socket signals. The number of clients, the
+    requests in flight per client and the work done per event loop pass are
+    capped, idle or stalled clients are dropped, so no client can hold up the
+    GUI.
  */
 class SingleApplication : public QApplication {
   Q_OBJECT
@@ -20,6 +33,13 @@ public:
 
 public slots:
   void receiveMessage();
+  void sendResponse(quint32 connection, const IpcResponse &response);
+
+private slots:
+  void readRequests();
+  void processConnections();
+  void connectionClosed();
+  void dropIdleConnections();
 
 signals:
   /**
@@ -27,14 +47,62 @@ signals:
    * @param message args sent to qtpass executable
    */
   void messageAvailable(QString message);
+  /**
+   * @brief requestAvailable a client sent a request that needs an answer,
+   * reply through SingleApplication::sendResponse.
+   * @param connection identifies the client connection
+   * @param request
+   */
+  void requestAvailable(quint32 connection, const IpcRequest &request);
 
 private:
+  /*!
+      \struct Connection
+      \brief Book keeping for a connected client.
+   */
+  struct Connection {
+    /**
+     * @brief id handed out with SingleApplication::requestAvailable
+     */
+    quint32 id;
+    /**
+     * @brief buffer received bytes not yet handled
+     */
+    QByteArray buffer;
+    /**
+     * @brief pending requests handed out and not yet answered
+     */
+    int pending;
+    /**
+     * @brief lastActivity time since data was last received or sent
+     */
+    QElapsedTimer lastActivity;
+  };
+
   bool _isRunning;
   QString _uniqueKey;
   QSharedMemory sharedMemory;
   QScopedPointer<QLocalServer> localServer;
+  QHash<QLocalSocket *, Connection> connections;
+  QHash<quint32, QLocalSocket *> sockets;
+  quint32 lastConnection;
+  QTimer idleTimer;
+  bool processingScheduled;
+
+  void processConnection(QLocalSocket *localSocket);
+  void scheduleProcessing();
+  void handleRequest(QLocalSocket *localSocket, quint32 connection,
+                     const QByteArray &payload);
+  void respond(QLocalSocket *localSocket, const IpcResponse &response);
 
-  static const int timeout = 1000;
+  static const int maxConnections = 16;
+  static const int maxPendingRequests = 32;
+  static const int maxFramesPerPass = 8;
+  static const int stalledTimeout = 5000;
+  static const int idleTimeout = 300000;
+  static const int maxUnsentBytes = 4 * 1024 * 1024;
+  // IpcProtocol::maxFrameSize and the length in front of it
+  static const int maxBufferedBytes = 1024 * 1024 + sizeof(quint32);
 };
 
 #endif // SINGLEAPPLICATION_H_
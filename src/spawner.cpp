@@ -0,0 +1,417 @@
+#include "spawner.h"
+#include "debughelper.h"
+#include <QElapsedTimer>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// posix_spawn_file_actions_addchdir_np came with glibc 2.29
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 29)
+#define SPAWN_CHDIR 1
+#endif
+#endif
+#endif
+
+/**
+ * @brief Spawner::Spawner
+ * @param parent
+ */
+Spawner::Spawner(QObject *parent)
+    : QObject(parent), written(0), pid(0), pidFd(-1) {
+  exitPoll.setInterval(exitPollInterval);
+  connect(&exitPoll, &QTimer::timeout, this, &Spawner::reap);
+}
+
+/**
+ * @brief Spawner::~Spawner stops a process that is still running, so a hanging
+ * gpg does not keep QtPass from quitting, and reaps it
+ */
+Spawner::~Spawner() {
+#ifdef Q_OS_LINUX
+  if (pid > 0)
+    terminate();
+  close(&input);
+  close(&output);
+  close(&errout);
+  if (pidFd >= 0)
+    ::close(pidFd);
+  closePipes(&spare);
+#endif
+}
+
+/**
+ * @brief Spawner::isAvailable whether start() can work on this platform
+ */
+bool Spawner::isAvailable() {
+#ifdef Q_OS_LINUX
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Spawner::setEnvironment environment of the processes started
+ * afterwards, the one of QtPass when empty
+ * @param env   "NAME=value" entries
+ */
+void Spawner::setEnvironment(const QStringList &env) {
+  environment.clear();
+  envp.clear();
+  if (env.isEmpty())
+    return;
+  environment.reserve(env.size());
+  foreach (const QString &variable, env)
+    environment.append(variable.toLocal8Bit());
+  // the entries are not touched again, so their data stays where it is
+  for (int i = 0; i < environment.size(); ++i)
+    envp.append(environment[i].data());
+  envp.append(Q_NULLPTR);
+}
+
+/**
+ * @brief Spawner::isRunning whether a process was started and did not exit
+ */
+bool Spawner::isRunning() const { return pid > 0; }
+
+/**
+ * @brief Spawner::start start a process, started() is emitted before this
+ * returns true and finished() once it exited
+ * @param app       absolute path of the executable
+ * @param args
+ * @param workDir   working directory, the current one when empty
+ * @param input     written to stdin of the process
+ * @return false when the process could not be started this way
+ */
+bool Spawner::start(const QString &app, const QStringList &args,
+                    const QString &workDir, const QByteArray &input) {
+#ifdef Q_OS_LINUX
+#ifndef SPAWN_CHDIR
+  if (!workDir.isEmpty())
+    return false;
+#endif
+  if (pid > 0 || (!spare.open && !openPipes(&spare)))
+    return false;
+  Pipes pipes = spare;
+  spare.open = false;
+
+  QByteArray program = QFile::encodeName(app);
+  QVector<QByteArray> arguments;
+  arguments.reserve(args.size());
+  foreach (const QString &arg, args)
+    arguments.append(arg.toLocal8Bit());
+  QVector<char *> argv;
+  argv.append(program.data());
+  for (int i = 0; i < arguments.size(); ++i)
+    argv.append(arguments[i].data());
+  argv.append(Q_NULLPTR);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  // the pipes are close-on-exec, only the duplicates are inherited
+  posix_spawn_file_actions_adddup2(&actions, pipes.in[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, pipes.out[1], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, pipes.err[1], STDERR_FILENO);
+#ifdef SPAWN_CHDIR
+  QByteArray directory = QFile::encodeName(workDir);
+  if (!workDir.isEmpty())
+    posix_spawn_file_actions_addchdir_np(&actions, directory.constData());
+#endif
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  // nothing blocked and SIGPIPE handled by default, whatever QtPass does
+  sigset_t signals;
+  sigemptyset(&signals);
+  posix_spawnattr_setsigmask(&attributes, &signals);
+  sigaddset(&signals, SIGPIPE);
+  posix_spawnattr_setsigdefault(&attributes, &signals);
+  short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+  flags |= POSIX_SPAWN_USEVFORK;
+#endif
+  posix_spawnattr_setflags(&attributes, flags);
+
+  pid_t child;
+  int error = posix_spawn(&child, program.constData(), &actions, &attributes,
+                          argv.data(), envp.isEmpty() ? environ : envp.data());
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  ::close(pipes.in[0]);
+  ::close(pipes.out[1]);
+  ::close(pipes.err[1]);
+  if (error != 0) {
+    dbgExecutor() << "posix_spawn" << app << "failed:" << strerror(error);
+    ::close(pipes.in[1]);
+    ::close(pipes.out[0]);
+    ::close(pipes.err[0]);
+    return false;
+  }
+  pid = child;
+
+  output.data.clear();
+  errout.data.clear();
+  watch(&output, pipes.out[0], QSocketNotifier::Read, SLOT(readOutput()));
+  watch(&errout, pipes.err[0], QSocketNotifier::Read, SLOT(readErrout()));
+  this->input.data = input;
+  written = 0;
+  if (input.isEmpty()) {
+    ::close(pipes.in[1]);
+  } else {
+    watch(&this->input, pipes.in[1], QSocketNotifier::Write,
+          SLOT(writeInput()));
+    writeInput();
+  }
+
+#ifdef SYS_pidfd_open
+  pidFd = static_cast<int>(syscall(SYS_pidfd_open, child, 0));
+#endif
+  if (pidFd >= 0) {
+    exitNotifier.reset(new QSocketNotifier(pidFd, QSocketNotifier::Read));
+    connect(exitNotifier.data(), SIGNAL(activated(int)), this, SLOT(reap()));
+  } else {
+    // kernels before 5.3 have no pidfd
+    exitPoll.start();
+  }
+  emit started();
+  return true;
+#else
+  Q_UNUSED(app)
+  Q_UNUSED(args)
+  Q_UNUSED(workDir)
+  Q_UNUSED(input)
+  return false;
+#endif
+}
+
+/**
+ * @brief Spawner::readOutput collect what the process wrote to stdout
+ */
+void Spawner::readOutput() { read(&output); }
+
+/**
+ * @brief Spawner::readErrout collect what the process wrote to stderr
+ */
+void Spawner::readErrout() { read(&errout); }
+
+/**
+ * @brief Spawner::writeInput write as much of the input as the pipe takes,
+ * closing it when all is written
+ */
+void Spawner::writeInput() {
+#ifdef Q_OS_LINUX
+  // like QProcess, a process that quits early is not allowed to take QtPass
+  // with it, SIGPIPE is blocked while writing and discarded when raised
+  sigset_t pipeSignal, previous;
+  sigemptyset(&pipeSignal);
+  sigaddset(&pipeSignal, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+  bool broken = false;
+  while (input.fd >= 0 && written < input.data.size()) {
+    ssize_t n = ::write(input.fd, input.data.constData() + written,
+                        static_cast<size_t>(input.data.size() - written));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && errno == EAGAIN)
+      break;
+    if (n < 0) {
+      broken = errno == EPIPE;
+      dbgExecutor() << "Not all data written to process:" << pid;
+      close(&input);
+      break;
+    }
+    written += static_cast<int>(n);
+  }
+  if (broken && !sigismember(&previous, SIGPIPE)) {
+    struct timespec none = {0, 0};
+    while (sigtimedwait(&pipeSignal, Q_NULLPTR, &none) < 0 && errno == EINTR)
+      ;
+  }
+  pthread_sigmask(SIG_SETMASK, &previous, Q_NULLPTR);
+  if (written >= input.data.size())
+    close(&input);
+#endif
+}
+
+/**
+ * @brief Spawner::terminate stop the running process and reap it, SIGKILL
+ * follows SIGTERM when it does not exit in time
+ */
+void Spawner::terminate() {
+#ifdef Q_OS_LINUX
+  pid_t child = static_cast<pid_t>(pid);
+  ::kill(child, SIGTERM);
+  QElapsedTimer elapsed;
+  elapsed.start();
+  int status;
+  pid_t result;
+  for (;;) {
+    result = waitpid(child, &status, WNOHANG);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result != 0 || elapsed.elapsed() >= terminateTimeout)
+      break;
+    usleep(10000);
+  }
+  if (result == 0) {
+    ::kill(child, SIGKILL);
+    while (waitpid(child, &status, 0) < 0 && errno == EINTR)
+      ;
+  }
+  pid = 0;
+#endif
+}
+
+/**
+ * @brief Spawner::reap collect the exit status once the process exited and
+ * report it with what is left in the pipes
+ */
+void Spawner::reap() {
+#ifdef Q_OS_LINUX
+  if (pid <= 0)
+    return;
+  int status = 0;
+  pid_t result;
+  do
+    result = waitpid(static_cast<pid_t>(pid), &status, WNOHANG);
+  while (result < 0 && errno == EINTR);
+  if (result == 0)
+    return;
+  pid = 0;
+  exitPoll.stop();
+  exitNotifier.reset();
+  if (pidFd >= 0) {
+    ::close(pidFd);
+    pidFd = -1;
+  }
+  // a child of the process, like gpg-agent, may keep the pipes open, so only
+  // what is there already is read
+  read(&output);
+  read(&errout);
+  close(&input);
+  close(&output);
+  close(&errout);
+  openPipes(&spare);
+
+  // a slot may start the next process right away, which reuses the buffers
+  QByteArray out, err;
+  out.swap(output.data);
+  err.swap(errout.data);
+  bool crashed = result < 0 || !WIFEXITED(status);
+  emit finished(crashed ? -1 : WEXITSTATUS(status), crashed, out, err);
+#endif
+}
+
+/**
+ * @brief Spawner::openPipes create close-on-exec pipes, the ends kept by
+ * QtPass do not block
+ * @param pipes
+ * @return false when the process is out of file descriptors
+ */
+bool Spawner::openPipes(Pipes *pipes) {
+#ifdef Q_OS_LINUX
+  if (pipe2(pipes->in, O_CLOEXEC) != 0)
+    return false;
+  if (pipe2(pipes->out, O_CLOEXEC) != 0) {
+    ::close(pipes->in[0]);
+    ::close(pipes->in[1]);
+    return false;
+  }
+  if (pipe2(pipes->err, O_CLOEXEC) != 0) {
+    ::close(pipes->in[0]);
+    ::close(pipes->in[1]);
+    ::close(pipes->out[0]);
+    ::close(pipes->out[1]);
+    return false;
+  }
+  fcntl(pipes->in[1], F_SETFL, O_NONBLOCK);
+  fcntl(pipes->out[0], F_SETFL, O_NONBLOCK);
+  fcntl(pipes->err[0], F_SETFL, O_NONBLOCK);
+  pipes->open = true;
+  return true;
+#else
+  Q_UNUSED(pipes)
+  return false;
+#endif
+}
+
+/**
+ * @brief Spawner::closePipes close pipes that were not used
+ * @param pipes
+ */
+void Spawner::closePipes(Pipes *pipes) {
+#ifdef Q_OS_LINUX
+  if (!pipes->open)
+    return;
+  int *ends[] = {pipes->in, pipes->out, pipes->err};
+  for (int *end : ends) {
+    ::close(end[0]);
+    ::close(end[1]);
+  }
+  pipes->open = false;
+#else
+  Q_UNUSED(pipes)
+#endif
+}
+
+/**
+ * @brief Spawner::watch get notified when a pipe can be used
+ * @param channel
+ * @param fd
+ * @param type
+ * @param slot
+ */
+void Spawner::watch(Channel *channel, int fd, QSocketNotifier::Type type,
+                    const char *slot) {
+  channel->fd = fd;
+  channel->notifier.reset(new QSocketNotifier(fd, type));
+  connect(channel->notifier.data(), SIGNAL(activated(int)), this, slot);
+}
+
+/**
+ * @brief Spawner::read append what can be read without blocking, closing the
+ * pipe at its end
+ * @param channel
+ */
+void Spawner::read(Channel *channel) {
+#ifdef Q_OS_LINUX
+  char chunk[4096];
+  while (channel->fd >= 0) {
+    ssize_t n = ::read(channel->fd, chunk, sizeof(chunk));
+    if (n > 0) {
+      channel->data.append(chunk, static_cast<int>(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && errno == EAGAIN)
+      return;
+    close(channel);
+  }
+#else
+  Q_UNUSED(channel)
+#endif
+}
+
+/**
+ * @brief Spawner::close stop watching a pipe and close it
+ * @param channel
+ */
+void Spawner::close(Channel *channel) {
+  channel->notifier.reset();
+#ifdef Q_OS_LINUX
+  if (channel->fd >= 0)
+    ::close(channel->fd);
+#endif
+  channel->fd = -1;
+}
@@ -0,0 +1,105 @@
+#ifndef SPAWNER_H_
+#define SPAWNER_H_
+
+#include <QByteArray>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+/*!
+    \class Spawner
+    \brief Starts a process with posix_spawn, a faster alternative to
+    QProcess for the many short gpg and git calls of bulk operations.
+
+    The environment is converted to the array handed to the child once, when
+    it is set, and the pipes for the next process are opened as soon as the
+    previous one finished. Only available on Linux, start() returns false
+    elsewhere and when the process can not be started this way, the caller
+    then uses QProcess instead.
+ */
+class Spawner : public QObject {
+  Q_OBJECT
+
+public:
+  explicit Spawner(QObject *parent = 0);
+  ~Spawner();
+
+  static bool isAvailable();
+
+  void setEnvironment(const QStringList &env);
+  bool start(const QString &app, const QStringList &args,
+             const QString &workDir, const QByteArray &input);
+  bool isRunning() const;
+
+signals:
+  /**
+   * @brief started     the process is running
+   */
+  void started();
+  /**
+   * @brief finished    the process exited
+   *
+   * @param exitCode    exit code, -1 when it crashed
+   * @param crashed     whether it was killed by a signal
+   * @param output      stdout of the process
+   * @param errout      stderr of the process
+   */
+  void finished(int exitCode, bool crashed, const QByteArray &output,
+                const QByteArray &errout);
+
+private slots:
+  void readOutput();
+  void readErrout();
+  void writeInput();
+  void reap();
+
+private:
+  /*!
+      \struct Channel
+      \brief Parent end of a pipe to the process.
+   */
+  struct Channel {
+    int fd = -1;
+    QByteArray data;
+    QScopedPointer<QSocketNotifier> notifier;
+  };
+
+  /*!
+      \struct Pipes
+      \brief Pipes for stdin, stdout and stderr, read end first.
+   */
+  struct Pipes {
+    bool open = false;
+    int in[2];
+    int out[2];
+    int err[2];
+  };
+
+  QVector<QByteArray> environment;
+  QVector<char *> envp;
+  Pipes spare;
+  Channel input;
+  Channel output;
+  Channel errout;
+  int written;
+  qint64 pid;
+  int pidFd;
+  QScopedPointer<QSocketNotifier> exitNotifier;
+  QTimer exitPoll;
+
+  void terminate();
+  bool openPipes(Pipes *pipes);
+  void closePipes(Pipes *pipes);
+  void watch(Channel *channel, int fd, QSocketNotifier::Type type,
+             const char *slot);
+  void read(Channel *channel);
+  void close(Channel *channel);
+
+  static const int exitPollInterval = 5;
+  static const int terminateTimeout = 1000;
+};
+
+#endif // SPAWNER_H_
@@ -38,10 +38,24 @@ SOURCES   += main.cpp \
              qtpasssettings.cpp \
              settingsconstants.cpp \
              pass.cpp \
+             passwordgenerator.cpp \
              realpass.cpp \
              imitatepass.cpp \
              executor.cpp \
-             simpletransaction.cpp
+             executorstats.cpp \
+             spawner.cpp \
+             transactionscheduler.cpp \
+             headlessquery.cpp \
+             gpgkeyring.cpp \
+             keyindex.cpp \
+             keytable.cpp \
+             colonreader.cpp \
+             usersmodel.cpp \
+             syncscheduler.cpp \
+             startuptrace.cpp \
+             tracer.cpp \
+             debughelper.cpp \
+             filecontent.cpp
 
 HEADERS   += mainwindow.h \
              configdialog.h \
@@ -58,12 +72,25 @@ HEADERS   += mainwindow.h \
              enums.h \
              settingsconstants.h \
              pass.h \
+             passwordgenerator.h \
              realpass.h \
              imitatepass.h \
              datahelpers.h \
              debughelper.h \
              executor.h \
-             simpletransaction.h
+             executorstats.h \
+             spawner.h \
+             transactionscheduler.h \
+             headlessquery.h \
+             gpgkeyring.h \
+             keyindex.h \
+             keytable.h \
+             colonreader.h \
+             usersmodel.h \
+             syncscheduler.h \
+             startuptrace.h \
+             tracer.h \
+             filecontent.h
 
 FORMS     += mainwindow.ui \
              configdialog.ui \
@@ -76,12 +103,29 @@ clang|gcc:QMAKE_CXXFLAGS_WARN_ON += -Wno-unknown-pragmas
 nosingleapp {
     QMAKE_CXXFLAGS += -DSINGLE_APP=0
 } else {
-    SOURCES += singleapplication.cpp
-    HEADERS += singleapplication.h
+    SOURCES += singleapplication.cpp \
+               ipcprotocol.cpp \
+               ipcclient.cpp \
+               queryhandler.cpp \
+               storeindex.cpp
+    HEADERS += singleapplication.h \
+               ipcprotocol.h \
+               ipcclient.h \
+               queryhandler.h \
+               storeindex.h
     QT      += network
     QMAKE_CXXFLAGS += -DSINGLE_APP=1
 }
 
+libgit2 {
+    SOURCES += gitworker.cpp
+    HEADERS += gitworker.h
+    LIBS    += -lgit2
+    QMAKE_CXXFLAGS += -DLIBGIT2=1
+} else {
+    QMAKE_CXXFLAGS += -DLIBGIT2=0
+}
+
 DEFINES += "VERSION=\"\\\"$$VERSION\\\"\""
 
 
@@ -0,0 +1,35 @@
+#include "startuptrace.h"
+#include <QTextStream>
+
+bool StartupTrace::enabled = false;
+QElapsedTimer StartupTrace::timer;
+qint64 StartupTrace::last = 0;
+
+/**
+ * @brief StartupTrace::enable start timing, called first thing in main().
+ */
+void StartupTrace::enable() {
+  enabled = true;
+  timer.start();
+  last = 0;
+}
+
+/**
+ * @brief StartupTrace::isEnabled whether --startup-trace was given.
+ */
+bool StartupTrace::isEnabled() { return enabled; }
+
+/**
+ * @brief StartupTrace::mark report that a phase of starting up is done.
+ * @param phase
+ */
+void StartupTrace::mark(const QString &phase) {
+  if (!enabled)
+    return;
+  qint64 now = timer.elapsed();
+  QTextStream(stderr) << QString("startup %1 ms (+%2 ms) %3\n")
+                             .arg(now, 6)
+                             .arg(now - last, 5)
+                             .arg(phase);
+  last = now;
+}
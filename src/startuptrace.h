@@ -0,0 +1,27 @@
+#ifndef STARTUPTRACE_H_
+#define STARTUPTRACE_H_
+
+#include <QElapsedTimer>
+#include <QString>
+
+/*!
+    \class StartupTrace
+    \brief Reports how long the phases of starting QtPass take.
+
+    Enabled with `qtpass --startup-trace`, every mark() then prints the time
+    since the process started and since the previous mark to stderr. When it
+    is not enabled mark() does nothing.
+ */
+class StartupTrace {
+public:
+  static void enable();
+  static bool isEnabled();
+  static void mark(const QString &phase);
+
+private:
+  static bool enabled;
+  static QElapsedTimer timer;
+  static qint64 last;
+};
+
+#endif // STARTUPTRACE_H_
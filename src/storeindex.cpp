@@ -0,0 +1,88 @@
+#include "storeindex.h"
+#include "qtpasssettings.h"
+#include "util.h"
+#include <QDir>
+#include <QDirIterator>
+
+/**
+ * @brief StoreIndex::StoreIndex
+ * @param parent
+ */
+StoreIndex::StoreIndex(QObject *parent) : QObject(parent), dirty(true) {
+  connect(&watcher, SIGNAL(directoryChanged(QString)), this,
+          SLOT(invalidate()));
+}
+
+/**
+ * @brief StoreIndex::find same semantics as Util::findPasswordEntries, but
+ * served from memory.
+ * @param query entry name or search words
+ * @return sorted entry names relative to the store without '.gpg'
+ */
+QStringList StoreIndex::find(const QString &query) {
+  if (dirty || store != QtPassSettings::getPassStore())
+    rebuild();
+
+  QString exact = QDir::cleanPath(query);
+  if (!query.isEmpty() && entrySet.contains(exact))
+    return QStringList() << exact;
+
+  QHash<QString, QStringList>::const_iterator cached = results.find(query);
+  if (cached != results.end())
+    return cached.value();
+
+  QStringList matches;
+  QRegExp regExp = Util::searchRegExp(query);
+  foreach (const QString &entry, entries) {
+    if (entry.contains(regExp))
+      matches << entry;
+  }
+  if (results.size() >= maxCachedResults)
+    results.clear();
+  results.insert(query, matches);
+  return matches;
+}
+
+/**
+ * @brief StoreIndex::invalidate something changed in the store, rescan on the
+ * next lookup.
+ */
+void StoreIndex::invalidate() { dirty = true; }
+
+/**
+ * @brief StoreIndex::rebuild scan the store and watch all of its folders.
+ */
+void StoreIndex::rebuild() {
+  store = QtPassSettings::getPassStore();
+  dirty = false;
+  entries.clear();
+  entrySet.clear();
+  results.clear();
+  if (!watcher.directories().isEmpty())
+    watcher.removePaths(watcher.directories());
+
+  QDir storeDir(store);
+  if (!storeDir.exists())
+    return;
+
+  QStringList folders;
+  folders << storeDir.absolutePath();
+  QDirIterator dirs(store, QDir::Dirs | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+  while (dirs.hasNext()) {
+    QString folder = dirs.next();
+    if (!storeDir.relativeFilePath(folder).startsWith(".git"))
+      folders << folder;
+  }
+  watcher.addPaths(folders);
+
+  QDirIterator gpgFiles(store, QStringList() << "*.gpg", QDir::Files,
+                        QDirIterator::Subdirectories);
+  while (gpgFiles.hasNext()) {
+    QString entry = storeDir.relativeFilePath(gpgFiles.next());
+    entry.chop(4);
+    entries << entry;
+  }
+  entries.sort();
+  entrySet = entries.toSet();
+}
@@ -0,0 +1,41 @@
+#ifndef STOREINDEX_H_
+#define STOREINDEX_H_
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+/*!
+    \class StoreIndex
+    \brief In-memory list of the entries in the password-store.
+
+    The store is scanned once and then kept up to date by watching its
+    folders, so repeated lookups never touch the disk.
+ */
+class StoreIndex : public QObject {
+  Q_OBJECT
+
+public:
+  explicit StoreIndex(QObject *parent = 0);
+
+  QStringList find(const QString &query);
+
+private slots:
+  void invalidate();
+
+private:
+  QFileSystemWatcher watcher;
+  QString store;
+  bool dirty;
+  QStringList entries;
+  QSet<QString> entrySet;
+  QHash<QString, QStringList> results;
+
+  void rebuild();
+
+  static const int maxCachedResults = 256;
+};
+
+#endif // STOREINDEX_H_
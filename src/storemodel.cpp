@@ -21,6 +21,25 @@ operator>>(QDataStream &in,
   return in;
 }
 
+/**
+ * @brief decodeDragAndDropInfo all entries dragged along
+ * @param data
+ * @return empty when the data does not come from the store view
+ */
+static QList<dragAndDropInfoPasswordStore>
+decodeDragAndDropInfo(const QMimeData *data) {
+  QList<dragAndDropInfoPasswordStore> infos;
+  QByteArray encodedData =
+      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
+  QDataStream stream(&encodedData, QIODevice::ReadOnly);
+  while (!stream.atEnd()) {
+    dragAndDropInfoPasswordStore info;
+    stream >> info;
+    infos << info;
+  }
+  return infos;
+}
+
 /**
  * @brief StoreModel::StoreModel
  * SubClass of QSortFilterProxyModel via
@@ -136,18 +155,18 @@ QStringList StoreModel::mimeTypes() const {
 }
 
 QMimeData *StoreModel::mimeData(const QModelIndexList &indexes) const {
-  dragAndDropInfoPasswordStore info;
-
   QByteArray encodedData;
-  // only use the first, otherwise we should enable multiselection
-  QModelIndex index = indexes.at(0);
-  if (index.isValid()) {
+  QDataStream stream(&encodedData, QIODevice::WriteOnly);
+  foreach (const QModelIndex &index, indexes) {
+    // one entry per row, not per column
+    if (!index.isValid() || index.column() != 0)
+      continue;
     QModelIndex useIndex = mapToSource(index);
 
+    dragAndDropInfoPasswordStore info;
     info.isDir = fs->fileInfo(useIndex).isDir();
     info.isFile = fs->fileInfo(useIndex).isFile();
     info.path = fs->fileInfo(useIndex).absoluteFilePath();
-    QDataStream stream(&encodedData, QIODevice::WriteOnly);
     stream << info;
   }
 
@@ -164,19 +183,29 @@ bool StoreModel::canDropMimeData(const QMimeData *data, Qt::DropAction action,
 
   QModelIndex useIndex =
       this->index(parent.row(), parent.column(), parent.parent());
-  QByteArray encodedData =
-      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
-  QDataStream stream(&encodedData, QIODevice::ReadOnly);
-  dragAndDropInfoPasswordStore info;
-  stream >> info;
   if (data->hasFormat("application/vnd+qtpass.dragAndDropInfoPasswordStore") ==
       false)
     return false;
+  QList<dragAndDropInfoPasswordStore> infos = decodeDragAndDropInfo(data);
+  if (infos.isEmpty())
+    return false;
 
   if (column > 0) {
     return false;
   }
 
+  QFileInfo destInfo = fs->fileInfo(mapToSource(useIndex));
+  // a folder can not end up inside itself
+  foreach (const dragAndDropInfoPasswordStore &info, infos) {
+    if (info.isDir && Util::isInside(destInfo.absoluteFilePath(), info.path))
+      return false;
+  }
+
+  // several entries can only be dropped into a folder
+  if (infos.size() > 1)
+    return destInfo.isDir();
+  const dragAndDropInfoPasswordStore &info = infos.first();
+
   // you can drop a folder on a folder
   if (fs->fileInfo(mapToSource(useIndex)).isDir() && info.isDir) {
     return true;
@@ -201,19 +230,29 @@ bool StoreModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
   if (action == Qt::IgnoreAction) {
     return true;
   }
-  QByteArray encodedData =
-      data->data("application/vnd+qtpass.dragAndDropInfoPasswordStore");
-
-  QDataStream stream(&encodedData, QIODevice::ReadOnly);
-  dragAndDropInfoPasswordStore info;
-  stream >> info;
+  QList<dragAndDropInfoPasswordStore> infos = decodeDragAndDropInfo(data);
   QModelIndex destIndex =
       this->index(parent.row(), parent.column(), parent.parent());
   QFileInfo destFileinfo = fs->fileInfo(mapToSource(destIndex));
-  QFileInfo srcFileInfo = QFileInfo(info.path);
   QDir qdir;
-  QString cleanedSrc = qdir.cleanPath(srcFileInfo.absoluteFilePath());
   QString cleanedDest = qdir.cleanPath(destFileinfo.absoluteFilePath());
+
+  if (infos.size() > 1) {
+    // all of them at once, so there is a single commit
+    QStringList cleanedSrcs;
+    foreach (const dragAndDropInfoPasswordStore &info, infos)
+      cleanedSrcs << qdir.cleanPath(QFileInfo(info.path).absoluteFilePath());
+    if (action == Qt::MoveAction) {
+      QtPassSettings::getPass()->MoveAll(cleanedSrcs, cleanedDest);
+    } else if (action == Qt::CopyAction) {
+      QtPassSettings::getPass()->CopyAll(cleanedSrcs, cleanedDest);
+    }
+    return true;
+  }
+
+  const dragAndDropInfoPasswordStore &info = infos.first();
+  QFileInfo srcFileInfo = QFileInfo(info.path);
+  QString cleanedSrc = qdir.cleanPath(srcFileInfo.absoluteFilePath());
   if (info.isDir) {
     QDir srcDir = QDir(info.path);
     // dropped dir onto dir
@@ -0,0 +1,242 @@
+#include "syncscheduler.h"
+#include "debughelper.h"
+#include "qtpasssettings.h"
+#include <QElapsedTimer>
+#include <QEventLoop>
+
+/**
+ * @brief SyncScheduler::SyncScheduler
+ * @param parent
+ */
+SyncScheduler::SyncScheduler(QObject *parent)
+    : QObject(parent), steps(Q_NULLPTR), failures(0), aheadCount(0),
+      behindCount(0), fetching(false), pushing(false), pushAgain(false) {
+  timer.setSingleShot(true);
+  connect(&timer, &QTimer::timeout, this, &SyncScheduler::fetch);
+  pushTimer.setSingleShot(true);
+  pushTimer.setInterval(pushDelay);
+  connect(&pushTimer, &QTimer::timeout, this, &SyncScheduler::push);
+  useScheduler(&own);
+}
+
+/**
+ * @brief SyncScheduler::ahead commits in the store that are not pushed yet.
+ */
+int SyncScheduler::ahead() const { return aheadCount; }
+
+/**
+ * @brief SyncScheduler::behind fetched commits that are not pulled yet.
+ */
+int SyncScheduler::behind() const { return behindCount; }
+
+/**
+ * @brief SyncScheduler::hasPending a push is scheduled or running.
+ */
+bool SyncScheduler::hasPending() const {
+  return pushTimer.isActive() || pushing;
+}
+
+/**
+ * @brief SyncScheduler::fetchInterval milliseconds from the last fetch to the
+ * next one, 0 when none is scheduled.
+ */
+int SyncScheduler::fetchInterval() const {
+  return timer.isActive() ? timer.interval() : 0;
+}
+
+/**
+ * @brief SyncScheduler::flush start a scheduled push right away and wait for
+ * pushing to finish, used before quitting.
+ * @param timeout   milliseconds to wait at most
+ * @return whether nothing is left to push
+ */
+bool SyncScheduler::flush(int timeout) {
+  if (pushTimer.isActive()) {
+    pushTimer.stop();
+    push();
+  }
+  QElapsedTimer elapsed;
+  elapsed.start();
+  while (pushing && elapsed.elapsed() < timeout) {
+    QEventLoop loop;
+    connect(steps, &TransactionScheduler::backgroundFinished, &loop,
+            &QEventLoop::quit, Qt::QueuedConnection);
+    QTimer::singleShot(static_cast<int>(timeout - elapsed.elapsed()), &loop,
+                       &QEventLoop::quit);
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+  }
+  return !pushing;
+}
+
+/**
+ * @brief SyncScheduler::start pick up changed settings and fetch on the
+ * configured interval.
+ */
+void SyncScheduler::start() {
+  failures = 0;
+  timer.stop();
+  if (!QtPassSettings::isUseGit())
+    return;
+  QStringList env = QProcess::systemEnvironment();
+  env << "PASSWORD_STORE_DIR=" + QtPassSettings::getPassStore();
+  own.setEnvironment(env);
+  TransactionScheduler *scheduler = QtPassSettings::getPass()->scheduler();
+  useScheduler(scheduler != Q_NULLPTR ? scheduler : &own);
+  updateCounts();
+  scheduleNext();
+}
+
+/**
+ * @brief SyncScheduler::stop no more background fetches.
+ */
+void SyncScheduler::stop() { timer.stop(); }
+
+/**
+ * @brief SyncScheduler::fetch fetch from the remote now, unless a fetch is
+ * already running.
+ */
+void SyncScheduler::fetch() {
+  if (fetching || !QtPassSettings::isUseGit())
+    return;
+  fetching = true;
+  executeGit(FETCH, {"fetch", "--quiet"});
+}
+
+/**
+ * @brief SyncScheduler::push push to the remote, when a push is running
+ * already one more is done after it, however often this is called meanwhile.
+ */
+void SyncScheduler::push() {
+  if (!QtPassSettings::isUseGit())
+    return;
+  if (pushing) {
+    pushAgain = true;
+    return;
+  }
+  pushing = true;
+  executeGit(PUSH, {"push"});
+}
+
+/**
+ * @brief SyncScheduler::schedulePush push once no more pushes were asked for
+ * during a few seconds, so a burst of changes results in a single push.
+ */
+void SyncScheduler::schedulePush() {
+  if (QtPassSettings::isUseGit())
+    pushTimer.start();
+}
+
+/**
+ * @brief SyncScheduler::updateCounts compare the store with its upstream.
+ */
+void SyncScheduler::updateCounts() {
+  if (QtPassSettings::isUseGit())
+    executeGit(COUNT,
+               {"rev-list", "--left-right", "--count", "HEAD...@{upstream}"});
+}
+
+/**
+ * @brief SyncScheduler::finished handle the result of a git command.
+ * @param id
+ * @param exitCode
+ * @param output
+ * @param errout
+ */
+void SyncScheduler::finished(int id, int exitCode, const QString &output,
+                             const QString &errout) {
+  if (sender() != steps || !running.contains(id))
+    return;
+  switch (running.take(id)) {
+  case FETCH:
+    fetching = false;
+    if (exitCode == 0) {
+      failures = 0;
+      updateCounts();
+    } else {
+      ++failures;
+      emit failed(exitCode, errout);
+    }
+    scheduleNext();
+    break;
+  case PUSH:
+    pushing = false;
+    if (exitCode == 0) {
+      emit pushed(output, errout);
+      updateCounts();
+    } else {
+      emit failed(exitCode, errout);
+    }
+    if (pushAgain) {
+      pushAgain = false;
+      push();
+    }
+    break;
+  case COUNT: {
+    // no upstream configured is not worth reporting
+    QStringList counts = output.split('\t');
+    int ahead = exitCode == 0 ? counts.value(0).trimmed().toInt() : 0;
+    int behind = exitCode == 0 ? counts.value(1).trimmed().toInt() : 0;
+    if (ahead != aheadCount || behind != behindCount) {
+      aheadCount = ahead;
+      behindCount = behind;
+      emit countsChanged(aheadCount, behindCount);
+    }
+    break;
+  }
+  }
+}
+
+/**
+ * @brief SyncScheduler::useScheduler run git on another scheduler from now
+ * on, what still runs on the previous one is forgotten.
+ * @param scheduler
+ */
+void SyncScheduler::useScheduler(TransactionScheduler *scheduler) {
+  if (scheduler == steps)
+    return;
+  steps = scheduler;
+  running.clear();
+  fetching = false;
+  pushing = false;
+  pushAgain = false;
+  connect(steps, &TransactionScheduler::backgroundFinished, this,
+          &SyncScheduler::finished, Qt::UniqueConnection);
+}
+
+/**
+ * @brief SyncScheduler::executeGit run git, through pass when it is used.
+ * Like the git commands of the backend it claims the "git" resource, so
+ * it never runs alongside them.
+ * @param step
+ * @param args
+ */
+void SyncScheduler::executeGit(Step step, const QStringList &args) {
+  dbgGit() << "sync" << args;
+  TransactionScheduler::Step git;
+  git.resources << "git";
+  git.workDir = QtPassSettings::getPassStore();
+  git.background = true;
+  if (QtPassSettings::isUsePass()) {
+    git.app = QtPassSettings::getPassExecutable();
+    git.args = QStringList("git") + args;
+  } else {
+    git.app = QtPassSettings::getGitExecutable();
+    git.args = args;
+    git.git = true;
+  }
+  running.insert(steps->add(git), step);
+}
+
+/**
+ * @brief SyncScheduler::scheduleNext start the timer for the next fetch,
+ * doubling the interval for every failed fetch in a row.
+ */
+void SyncScheduler::scheduleNext() {
+  int minutes = QtPassSettings::getSyncInterval();
+  if (minutes <= 0 || !QtPassSettings::isUseGit())
+    return;
+  qint64 interval = qint64(minutes) * 60 * 1000;
+  interval <<= qMin(failures, 16);
+  timer.start(static_cast<int>(qMin<qint64>(
+      interval, qMax<qint64>(maxBackoff, qint64(minutes) * 60 * 1000))));
+}
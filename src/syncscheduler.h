@@ -0,0 +1,88 @@
+#ifndef SYNCSCHEDULER_H_
+#define SYNCSCHEDULER_H_
+
+#include "transactionscheduler.h"
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+/*!
+    \class SyncScheduler
+    \brief Keeps the password-store in sync with its git remote in the
+    background.
+
+    The remote is fetched every QtPassSettings::getSyncInterval() minutes,
+    backing off when fetching fails, and the number of commits the store is
+    ahead of and behind its upstream is kept up to date. Pushes requested
+    while one is running are coalesced into a single follow-up push, bursts
+    of changes are pushed once with schedulePush().
+
+    git runs as background steps of the backend's TransactionScheduler, so
+    it waits for the git commands of the user's operations.
+ */
+class SyncScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  explicit SyncScheduler(QObject *parent = 0);
+
+  int ahead() const;
+  int behind() const;
+  bool hasPending() const;
+  int fetchInterval() const;
+  bool flush(int timeout = 30000);
+
+public slots:
+  void start();
+  void stop();
+  void fetch();
+  void push();
+  void schedulePush();
+  void updateCounts();
+
+signals:
+  /**
+   * @brief countsChanged the store is ahead or behind its upstream by a
+   * different number of commits now.
+   */
+  void countsChanged(int ahead, int behind);
+  /**
+   * @brief pushed a push finished successfully.
+   */
+  void pushed(const QString &output, const QString &errout);
+  /**
+   * @brief failed a fetch or push failed.
+   */
+  void failed(int exitCode, const QString &errout);
+
+private slots:
+  void finished(int id, int exitCode, const QString &output,
+                const QString &errout);
+
+private:
+  /**
+   * @brief The Step enum what a git step is for.
+   */
+  enum Step { FETCH = 0, PUSH, COUNT };
+
+  TransactionScheduler own;
+  TransactionScheduler *steps;
+  QHash<int, Step> running;
+  QTimer timer;
+  QTimer pushTimer;
+  int failures;
+  int aheadCount;
+  int behindCount;
+  bool fetching;
+  bool pushing;
+  bool pushAgain;
+
+  void useScheduler(TransactionScheduler *scheduler);
+  void executeGit(Step step, const QStringList &args);
+  void scheduleNext();
+
+  static const int maxBackoff = 60 * 60 * 1000;
+  static const int pushDelay = 3000;
+};
+
+#endif // SYNCSCHEDULER_H_
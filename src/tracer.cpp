@@ -0,0 +1,102 @@
+#include "tracer.h"
+#include "debughelper.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+bool Tracer::enabled = false;
+int Tracer::lastId = 0;
+int Tracer::next = 0;
+bool Tracer::wrapped = false;
+QString Tracer::fileName;
+QVector<Tracer::Event> Tracer::events;
+QElapsedTimer Tracer::clock;
+QMutex Tracer::mutex;
+
+/**
+ * @brief Tracer::enable start recording.
+ * @param fileName  where write() puts the trace
+ * @param capacity  number of events kept, older ones are overwritten
+ */
+void Tracer::enable(const QString &fileName, int capacity) {
+  QMutexLocker locker(&mutex);
+  Tracer::fileName = fileName;
+  events.resize(qMax(capacity, 1));
+  next = 0;
+  wrapped = false;
+  clock.start();
+  enabled = true;
+}
+
+/**
+ * @brief Tracer::record add an event to the ring buffer.
+ * @param phase     Chrome trace event type
+ * @param name      has to outlive the tracer, a string literal
+ * @param id
+ * @param detail
+ */
+void Tracer::record(char phase, const char *name, int id,
+                    const QString &detail) {
+  QMutexLocker locker(&mutex);
+  Event &event = events[next];
+  event.phase = phase;
+  event.name = name;
+  event.id = id;
+  event.timestamp = clock.nsecsElapsed() / 1000;
+  event.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  event.detail = detail;
+  if (++next == events.size()) {
+    next = 0;
+    wrapped = true;
+  }
+}
+
+/**
+ * @brief Tracer::write save the recorded events as Chrome trace JSON, to be
+ * opened with chrome://tracing.
+ * @return false when tracing is not enabled or the file could not be written
+ */
+bool Tracer::write() {
+  if (!enabled)
+    return false;
+  QMutexLocker locker(&mutex);
+  QJsonArray traceEvents;
+  qint64 pid = QCoreApplication::applicationPid();
+  int count = wrapped ? events.size() : next;
+  for (int n = 0; n < count; ++n) {
+    const Event &event = events.at(wrapped ? (next + n) % events.size() : n);
+    QJsonObject object;
+    object.insert("name", QString::fromLatin1(event.name));
+    object.insert("cat", QString("qtpass"));
+    object.insert("ph", QString(QChar(event.phase)));
+    object.insert("ts", static_cast<double>(event.timestamp));
+    object.insert("pid", static_cast<double>(pid));
+    object.insert("tid", static_cast<double>(event.thread));
+    if (event.phase == 'b' || event.phase == 'e')
+      object.insert("id", event.id);
+    else if (event.phase == 'i')
+      object.insert("s", QString("p"));
+    QJsonObject args;
+    if (event.id != 0)
+      args.insert("job", event.id);
+    if (!event.detail.isEmpty())
+      args.insert("detail", event.detail);
+    if (!args.isEmpty())
+      object.insert("args", args);
+    traceEvents.append(object);
+  }
+  QJsonObject trace;
+  trace.insert("traceEvents", traceEvents);
+  trace.insert("displayTimeUnit", QString("ms"));
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    dbg() << "Could not write trace to" << fileName;
+    return false;
+  }
+  file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+  return true;
+}
@@ -0,0 +1,90 @@
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/*!
+    \class Tracer
+    \brief Records spans of work, e.g. from clicking an entry to showing its
+    password, for chrome://tracing.
+
+    Enabled with `qtpass --trace=<file>`, the last events are kept in a ring
+    buffer and written to the file as Chrome trace JSON when QtPass quits.
+    Spans that cross the event loop, like an executor job waiting in the queue
+    and running, are keyed by an id from newId(). When tracing is not enabled
+    every call returns right after checking a flag.
+ */
+class Tracer {
+public:
+  /*!
+      \class Span
+      \brief Traces the scope it lives in.
+   */
+  class Span {
+  public:
+    explicit Span(const char *name, int id = 0) : m_name(name), m_id(id) {
+      if (enabled)
+        record('B', m_name, m_id, QString());
+    }
+    ~Span() {
+      if (enabled)
+        record('E', m_name, m_id, QString());
+    }
+
+  private:
+    const char *m_name;
+    int m_id;
+  };
+
+  static void enable(const QString &fileName, int capacity = defaultCapacity);
+  static bool isEnabled() { return enabled; }
+  static bool write();
+
+  static int newId() { return enabled ? ++lastId : 0; }
+  static void begin(const char *name, int id,
+                    const QString &detail = QString()) {
+    if (enabled)
+      record('b', name, id, detail);
+  }
+  static void end(const char *name, int id) {
+    if (enabled)
+      record('e', name, id, QString());
+  }
+  static void instant(const char *name, const QString &detail = QString()) {
+    if (enabled)
+      record('i', name, 0, detail);
+  }
+
+private:
+  /*!
+      \struct Event
+      \brief One entry of the ring buffer.
+   */
+  struct Event {
+    char phase;
+    const char *name;
+    int id;
+    qint64 timestamp;
+    quintptr thread;
+    QString detail;
+  };
+
+  static bool enabled;
+  static int lastId;
+  static int next;
+  static bool wrapped;
+  static QString fileName;
+  static QVector<Event> events;
+  static QElapsedTimer clock;
+  static QMutex mutex;
+
+  static void record(char phase, const char *name, int id,
+                     const QString &detail);
+
+  static const int defaultCapacity = 65536;
+};
+
+#endif // TRACER_H_
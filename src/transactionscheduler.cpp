@@ -0,0 +1,568 @@
+#include "transactionscheduler.h"
+#include "debughelper.h"
+#include "tracer.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+using namespace Enums;
+
+/**
+ * @brief TransactionScheduler::TransactionScheduler
+ * @param parent
+ */
+TransactionScheduler::TransactionScheduler(QObject *parent)
+    : QObject(parent), depth(0), current(-1), calling(-1), nextStep(0),
+      nextTransaction(0) {}
+
+/**
+ * @brief TransactionScheduler::begin steps added until the matching end()
+ * belong to one transaction, nested calls join the outer transaction.
+ */
+void TransactionScheduler::begin() {
+  if (depth++ == 0)
+    current = open(INVALID, false);
+}
+
+/**
+ * @brief TransactionScheduler::end close the transaction opened by begin()
+ * @param result    reported with finished() once all steps are done
+ */
+void TransactionScheduler::end(PROCESS result) {
+  if (depth == 0 || --depth > 0)
+    return;
+  Transaction &transaction = transactions[current];
+  transaction.result = result;
+  transaction.sealed = true;
+  int id = current;
+  current = -1;
+  if (transaction.steps.isEmpty() && !transaction.failed) {
+    // nothing was run, e.g. the operation gave up early
+    transactions.remove(id);
+    return;
+  }
+  if (transaction.pending == 0)
+    finish(id);
+}
+
+/**
+ * @brief TransactionScheduler::add queue a step with explicit dependencies,
+ * outside of begin() and end() the step is a transaction of its own
+ * @param step
+ * @return id of the step, -1 when its transaction failed already
+ */
+int TransactionScheduler::add(const Step &step) {
+  int transaction = depth > 0 ? current : open(step.process, true);
+  if (depth == 0)
+    transactions[transaction].background = step.background;
+  return queue(transaction, step);
+}
+
+/**
+ * @brief TransactionScheduler::queue add a step to a transaction
+ * @param transaction
+ * @param step
+ * @return id of the step, -1 when the transaction failed already
+ */
+int TransactionScheduler::queue(int transaction, const Step &step) {
+  Transaction &t = transactions[transaction];
+  if (t.failed)
+    return -1;
+  int id = nextStep++;
+  Step queuedStep = step;
+  // paths name the same resource however they are written
+  for (int i = 0; i < queuedStep.resources.size(); ++i) {
+    QString &resource = queuedStep.resources[i];
+    if (resource.contains('/') || resource.contains('\\'))
+      resource = QDir::cleanPath(resource);
+  }
+  if (queuedStep.inputFrom >= 0) {
+    if (!queuedStep.dependsOn.contains(queuedStep.inputFrom))
+      queuedStep.dependsOn << queuedStep.inputFrom;
+    // only the output of a step that did not finish yet can be kept
+    if (queued.contains(queuedStep.inputFrom) ||
+        claimed.contains(queuedStep.inputFrom))
+      piped.insert(queuedStep.inputFrom, QString());
+  }
+  queued.insert(id, queuedStep);
+  stepTransaction.insert(id, transaction);
+  t.steps << id;
+  t.lastStep = id;
+  ++t.pending;
+  int trace = Tracer::newId();
+  if (trace != 0) {
+    traces.insert(id, trace);
+    Tracer::begin("waiting", trace, QFileInfo(step.app).fileName());
+  }
+  schedule();
+  return id;
+}
+
+/**
+ * @brief TransactionScheduler::then queue a step that depends on the step
+ * added last to the current transaction
+ * @param step
+ * @return id of the step
+ */
+int TransactionScheduler::then(Step step) {
+  if (depth > 0 && transactions[current].lastStep >= 0)
+    step.dependsOn << transactions[current].lastStep;
+  return add(step);
+}
+
+/**
+ * @brief TransactionScheduler::backupFile restore the content of a file, or
+ * remove it when it does not exist yet, if the transaction fails. While
+ * earlier steps may still change the file, the content is saved right
+ * before the first step of this transaction claiming it starts.
+ * @param path
+ */
+void TransactionScheduler::backupFile(const QString &path) {
+  Transaction *transaction = registering();
+  if (transaction == Q_NULLPTR)
+    return;
+  Rollback undo;
+  undo.kind = Rollback::RESTORE_FILE;
+  undo.path = path;
+  undo.saved = false;
+  undo.existed = false;
+  QMap<QString, int> claims = busy;
+  foreach (const Step &step, queued)
+    claim(&claims, step.resources);
+  // the step calling us holds the claim itself
+  if (calling >= 0 || !isClaimed(claims, QDir::cleanPath(path)))
+    save(&undo);
+  transaction->rollbacks << undo;
+}
+
+/**
+ * @brief TransactionScheduler::undoCreate remove a file or folder if the
+ * transaction fails
+ * @param path
+ */
+void TransactionScheduler::undoCreate(const QString &path) {
+  Transaction *transaction = registering();
+  if (transaction == Q_NULLPTR)
+    return;
+  Rollback undo;
+  undo.kind = Rollback::REMOVE;
+  undo.path = path;
+  transaction->rollbacks << undo;
+}
+
+/**
+ * @brief TransactionScheduler::undoRename move an entry back if the
+ * transaction fails
+ * @param from  where the entry was
+ * @param to    where it is now
+ */
+void TransactionScheduler::undoRename(const QString &from, const QString &to) {
+  Transaction *transaction = registering();
+  if (transaction == Q_NULLPTR)
+    return;
+  Rollback undo;
+  undo.kind = Rollback::RENAME;
+  undo.path = to;
+  undo.other = from;
+  transaction->rollbacks << undo;
+}
+
+/**
+ * @brief TransactionScheduler::undoCommand run a command if the transaction
+ * fails
+ * @param workDir
+ * @param app
+ * @param args
+ */
+void TransactionScheduler::undoCommand(const QString &workDir,
+                                       const QString &app,
+                                       const QStringList &args) {
+  Transaction *transaction = registering();
+  if (transaction == Q_NULLPTR || app.isEmpty())
+    return;
+  Rollback undo;
+  undo.kind = Rollback::COMMAND;
+  undo.path = workDir;
+  undo.other = app;
+  undo.args = args;
+  transaction->rollbacks << undo;
+}
+
+/**
+ * @brief TransactionScheduler::setEnvironment environment for the processes
+ * of the steps
+ * @param env
+ */
+void TransactionScheduler::setEnvironment(const QStringList &env) {
+  if (env == environment)
+    return;
+  environment = env;
+  foreach (Executor *executor, idle)
+    executor->setEnvironment(environment);
+  foreach (Executor *executor, runningOn)
+    executor->setEnvironment(environment);
+}
+
+/**
+ * @brief TransactionScheduler::isIdle whether no transaction is in progress
+ */
+bool TransactionScheduler::isIdle() const { return transactions.isEmpty(); }
+
+/**
+ * @brief TransactionScheduler::stepFinished record the result of a step and
+ * start the steps that waited for it
+ * @param id
+ * @param exitCode
+ * @param output
+ * @param errout
+ */
+void TransactionScheduler::stepFinished(int id, int exitCode,
+                                        const QString &output,
+                                        const QString &errout) {
+  Executor *executor = runningOn.take(id);
+  if (executor != Q_NULLPTR)
+    idle << executor;
+  release(&busy, claimed.take(id));
+  int transaction = stepTransaction.take(id);
+  QHash<int, Transaction>::iterator t = transactions.find(transaction);
+  if (t == transactions.end())
+    return;
+  --t->pending;
+  if (piped.contains(id))
+    piped[id] = output;
+  else
+    t->output += output;
+  t->errout = errout;
+  if (exitCode != 0 && !t->failed) {
+    dbgTransactions() << "step" << id << "failed, cancelling transaction"
+                      << transaction;
+    t->failed = true;
+    t->exitCode = exitCode;
+    cancel(transaction);
+  }
+  if (t->sealed && t->pending == 0)
+    finish(transaction);
+  schedule();
+}
+
+/**
+ * @brief TransactionScheduler::open start bookkeeping for a new transaction
+ * @param result
+ * @param sealed    whether no more steps are added to it
+ * @return id of the transaction
+ */
+int TransactionScheduler::open(PROCESS result, bool sealed) {
+  Transaction transaction;
+  transaction.result = result;
+  transaction.sealed = sealed;
+  transaction.background = false;
+  transaction.failed = false;
+  transaction.lastStep = -1;
+  transaction.pending = 0;
+  transaction.exitCode = 0;
+  int id = nextTransaction++;
+  transactions.insert(id, transaction);
+  return id;
+}
+
+/**
+ * @brief TransactionScheduler::registering the transaction rollback actions
+ * are registered for, the one of the step whose slot is being called or the
+ * one between begin() and end()
+ * @return Q_NULLPTR when there is none
+ */
+TransactionScheduler::Transaction *TransactionScheduler::registering() {
+  // a step of another transaction may be started while one is built
+  int id = calling >= 0 ? calling : depth > 0 ? current : -1;
+  QHash<int, Transaction>::iterator transaction = transactions.find(id);
+  return transaction == transactions.end() ? Q_NULLPTR : &transaction.value();
+}
+
+/**
+ * @brief TransactionScheduler::schedule start every queued step whose
+ * dependencies succeeded and whose resource is free, oldest first
+ */
+void TransactionScheduler::schedule() {
+  QList<int> ready;
+  QMap<QString, int> claiming = busy;
+  int free = maxRunning - runningOn.size();
+  for (QMap<int, Step>::const_iterator i = queued.constBegin();
+       i != queued.constEnd() && ready.size() < free; ++i) {
+    const Step &step = i.value();
+    bool waiting = false;
+    foreach (int dependency, step.dependsOn) {
+      if (queued.contains(dependency) || claimed.contains(dependency)) {
+        waiting = true;
+        break;
+      }
+    }
+    foreach (const QString &resource, step.resources) {
+      if (isClaimed(claiming, resource))
+        waiting = true;
+    }
+    // an earlier step keeps its turn on its resources even when it is still
+    // waiting for its own dependencies or for other resources
+    claim(&claiming, step.resources);
+    if (!waiting)
+      ready << i.key();
+  }
+  // a step that fails right away schedules again from within start()
+  foreach (int id, ready)
+    if (queued.contains(id))
+      start(id, queued.take(id));
+}
+
+/**
+ * @brief TransactionScheduler::start run a step on an idle executor
+ * @param id
+ * @param step
+ */
+void TransactionScheduler::start(int id, Step step) {
+  Tracer::end("waiting", traces.take(id));
+  claimed.insert(id, step.resources);
+  claim(&busy, step.resources);
+  saveBackups(stepTransaction.value(id, -1), step.resources);
+  if (step.receiver != Q_NULLPTR) {
+    call(id, step);
+    return;
+  }
+  if (step.app.isEmpty()) {
+    // report it the way a missing executable would be
+    QMetaObject::invokeMethod(
+        this, "stepFinished", Qt::QueuedConnection, Q_ARG(int, id),
+        Q_ARG(int, 127), Q_ARG(QString, QString()),
+        Q_ARG(QString, tr("No executable configured")));
+    return;
+  }
+  if (step.inputFrom >= 0) {
+    if (!piped.contains(step.inputFrom)) {
+      QMetaObject::invokeMethod(
+          this, "stepFinished", Qt::QueuedConnection, Q_ARG(int, id),
+          Q_ARG(int, 1), Q_ARG(QString, QString()),
+          Q_ARG(QString, tr("The input of the step was lost")));
+      return;
+    }
+    step.input = piped.take(step.inputFrom);
+  }
+  Executor *executor = runner();
+  runningOn.insert(id, executor);
+  if (!step.background)
+    emit starting();
+  if (step.git && step.input.isEmpty())
+    executor->executeGit(id, step.workDir, step.app, step.args,
+                         step.readStdout, step.readStderr);
+  else
+    executor->execute(id, step.workDir, step.app, step.args, step.input,
+                      step.readStdout, step.readStderr);
+}
+
+/**
+ * @brief TransactionScheduler::saveBackups save the files a transaction
+ * backed up that a step of it is about to claim, unless saved already
+ * @param transaction
+ * @param resources claimed by the step
+ */
+void TransactionScheduler::saveBackups(int transaction,
+                                       const QStringList &resources) {
+  QHash<int, Transaction>::iterator t = transactions.find(transaction);
+  if (t == transactions.end() || resources.isEmpty())
+    return;
+  QMap<QString, int> claims;
+  claim(&claims, resources);
+  for (int i = 0; i < t->rollbacks.size(); ++i) {
+    Rollback &undo = t->rollbacks[i];
+    if (undo.kind == Rollback::RESTORE_FILE && !undo.saved &&
+        isClaimed(claims, QDir::cleanPath(undo.path)))
+      save(&undo);
+  }
+}
+
+/**
+ * @brief TransactionScheduler::call call the slot of an in-process step, its
+ * result is reported like that of a process
+ * @param id
+ * @param step
+ */
+void TransactionScheduler::call(int id, const Step &step) {
+  if (!step.background)
+    emit starting();
+  bool succeeded = false;
+  // a dialog shown by the slot may let other steps be called meanwhile
+  int outer = calling;
+  calling = stepTransaction.value(id, -1);
+  if (!QMetaObject::invokeMethod(step.receiver, step.slot.constData(),
+                                 Qt::DirectConnection,
+                                 Q_RETURN_ARG(bool, succeeded),
+                                 Q_ARG(QStringList, step.args)))
+    dbgTransactions() << "could not call" << step.slot;
+  calling = outer;
+  QMetaObject::invokeMethod(this, "stepFinished", Qt::QueuedConnection,
+                            Q_ARG(int, id), Q_ARG(int, succeeded ? 0 : 1),
+                            Q_ARG(QString, QString()),
+                            Q_ARG(QString, QString()));
+}
+
+/**
+ * @brief TransactionScheduler::cancel drop the steps of a transaction that
+ * did not start yet
+ * @param transaction
+ */
+void TransactionScheduler::cancel(int transaction) {
+  Transaction &t = transactions[transaction];
+  foreach (int id, t.steps) {
+    if (queued.remove(id) > 0) {
+      Tracer::end("waiting", traces.take(id));
+      stepTransaction.remove(id);
+      --t.pending;
+    }
+  }
+}
+
+/**
+ * @brief TransactionScheduler::finish roll back a failed transaction and
+ * report its result
+ * @param transaction
+ */
+void TransactionScheduler::finish(int transaction) {
+  Transaction t = transactions.take(transaction);
+  foreach (int id, t.steps)
+    piped.remove(id);
+  if (t.failed)
+    rollback(t);
+  if (t.background) {
+    emit backgroundFinished(t.lastStep, t.exitCode, t.output, t.errout);
+    return;
+  }
+  if (t.steps.size() == 1)
+    emit singleStepFinished(t.lastStep, t.exitCode, t.output, t.errout);
+  emit finished(t.result, t.exitCode, t.output, t.errout);
+}
+
+/**
+ * @brief TransactionScheduler::rollback undo what a failed transaction did,
+ * last registered action first, commands are queued and run after the
+ * files are restored
+ * @param transaction
+ */
+void TransactionScheduler::rollback(const Transaction &transaction) {
+  for (int i = transaction.rollbacks.size() - 1; i >= 0; --i) {
+    const Rollback &undo = transaction.rollbacks.at(i);
+    switch (undo.kind) {
+    case Rollback::RESTORE_FILE:
+      if (!undo.saved) {
+        // no step of the transaction got to change it
+        dbgTransactions() << "no backup of" << undo.path;
+      } else if (undo.existed) {
+        QFile file(undo.path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+            file.write(undo.data) != undo.data.size())
+          dbgTransactions() << "could not restore" << undo.path;
+      } else {
+        QFile::remove(undo.path);
+      }
+      break;
+    case Rollback::REMOVE:
+      if (QFileInfo(undo.path).isDir())
+        QDir(undo.path).removeRecursively();
+      else
+        QFile::remove(undo.path);
+      break;
+    case Rollback::RENAME:
+      if (!QDir().rename(undo.path, undo.other))
+        dbgTransactions() << "could not move" << undo.path << "back to"
+                          << undo.other;
+      break;
+    case Rollback::COMMAND: {
+      // like any git command it waits for its turn on the index, so it is
+      // run as a background step of its own
+      Step step;
+      step.resources << "git";
+      step.workDir = undo.path;
+      step.app = undo.other;
+      step.args = undo.args;
+      step.background = true;
+      int id = open(INVALID, true);
+      transactions[id].background = true;
+      queue(id, step);
+      break;
+    }
+    }
+  }
+}
+
+/**
+ * @brief TransactionScheduler::save keep the current content of a file to
+ * restore
+ * @param undo
+ */
+void TransactionScheduler::save(Rollback *undo) {
+  QFile file(undo->path);
+  undo->existed = file.open(QIODevice::ReadOnly);
+  if (undo->existed)
+    undo->data = file.readAll();
+  undo->saved = true;
+}
+
+/**
+ * @brief TransactionScheduler::isClaimed whether a resource, a folder it is
+ * in or, for a folder, something inside it is claimed
+ * @param claims
+ * @param resource
+ */
+bool TransactionScheduler::isClaimed(const QMap<QString, int> &claims,
+                                     const QString &resource) {
+  if (claims.isEmpty())
+    return false;
+  for (QString path = resource; !path.isEmpty();
+       path.truncate(qMax(path.lastIndexOf('/'), 0))) {
+    if (claims.contains(path))
+      return true;
+  }
+  QMap<QString, int>::const_iterator inside =
+      claims.lowerBound(resource + '/');
+  return inside != claims.constEnd() && inside.key().startsWith(resource + '/');
+}
+
+/**
+ * @brief TransactionScheduler::claim add resources to claims
+ * @param claims    how often each resource is claimed
+ * @param resources
+ */
+void TransactionScheduler::claim(QMap<QString, int> *claims,
+                                 const QStringList &resources) {
+  foreach (const QString &resource, resources)
+    ++(*claims)[resource];
+}
+
+/**
+ * @brief TransactionScheduler::release drop resources from claims
+ * @param claims
+ * @param resources
+ */
+void TransactionScheduler::release(QMap<QString, int> *claims,
+                                   const QStringList &resources) {
+  foreach (const QString &resource, resources) {
+    QMap<QString, int>::iterator claim = claims->find(resource);
+    if (claim != claims->end() && --claim.value() <= 0)
+      claims->erase(claim);
+  }
+}
+
+/**
+ * @brief TransactionScheduler::runner an executor that is not running
+ * anything, created when all are busy
+ */
+Executor *TransactionScheduler::runner() {
+  if (!idle.isEmpty())
+    return idle.takeLast();
+  Executor *executor = new Executor(this);
+  // bulk operations run many short gpg and git processes
+  executor->setSpawnMode(Executor::POSIX_SPAWN);
+  if (!environment.isEmpty())
+    executor->setEnvironment(environment);
+  connect(executor, static_cast<void (Executor::*)(int, int, const QString &,
+                                                   const QString &)>(
+                        &Executor::finished),
+          this, &TransactionScheduler::stepFinished);
+  return executor;
+}
@@ -0,0 +1,238 @@
+#ifndef TRANSACTIONSCHEDULER_H_
+#define TRANSACTIONSCHEDULER_H_
+
+#include "enums.h"
+#include "executor.h"
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+/*!
+    \class TransactionScheduler
+    \brief Runs password-store operations as transactions of dependent steps.
+
+    An operation like an insert is one transaction made of steps (encrypt,
+    git add, git commit), each step lists the steps it depends on. A step
+    starts once those succeeded and no earlier step claiming the same
+    resource is still waiting or running, so independent transactions run
+    side by side while steps on the same file or on the git index keep their
+    order. A folder claimed as resource covers everything inside it. When a
+    step fails the remaining steps of its transaction are cancelled and its
+    rollback actions are run, last registered first.
+ */
+class TransactionScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  /*!
+      \struct Step
+      \brief One process to run as part of a transaction.
+   */
+  struct Step {
+    /**
+     * @brief process   what the step does, reported as result when the step
+     *                  is a transaction of its own
+     */
+    Enums::PROCESS process = Enums::INVALID;
+    /**
+     * @brief resources steps sharing a resource never run at the same time
+     *                  and start in the order they were added, paths also
+     *                  share with what is inside them, empty for none
+     */
+    QStringList resources;
+    /**
+     * @brief workDir   working directory of the process
+     */
+    QString workDir;
+    /**
+     * @brief app       executable path
+     */
+    QString app;
+    /**
+     * @brief args      arguments for executable
+     */
+    QStringList args;
+    /**
+     * @brief input     data to write to stdin of the process
+     */
+    QString input;
+    /**
+     * @brief inputFrom step of the same transaction whose stdout is written
+     *                  to stdin instead of input, it is not added to the
+     *                  output of the transaction, -1 for none
+     */
+    int inputFrom = -1;
+    /**
+     * @brief readStdout    whether to collect stdout
+     */
+    bool readStdout = true;
+    /**
+     * @brief readStderr    whether to collect stderr, it is collected on
+     *                      failure regardless
+     */
+    bool readStderr = true;
+    /**
+     * @brief git   run through Executor::executeGit, in-process when
+     *              possible
+     */
+    bool git = false;
+    /**
+     * @brief receiver  when set, its slot is called in-process instead of
+     *                  running app, rollback actions registered meanwhile
+     *                  belong to the transaction of the step
+     */
+    QObject *receiver = Q_NULLPTR;
+    /**
+     * @brief slot      name of the slot, it takes args and returns whether
+     *                  it succeeded
+     */
+    QByteArray slot;
+    /**
+     * @brief dependsOn steps of the same transaction that have to succeed
+     *                  first
+     */
+    QList<int> dependsOn;
+    /**
+     * @brief background    work the user did not ask for, like syncing, it
+     *                      is reported with backgroundFinished() and does
+     *                      not emit starting(), only for steps added outside
+     *                      of a transaction
+     */
+    bool background = false;
+  };
+
+  explicit TransactionScheduler(QObject *parent = 0);
+
+  void begin();
+  void end(Enums::PROCESS result);
+
+  int add(const Step &step);
+  int then(Step step);
+
+  void backupFile(const QString &path);
+  void undoCreate(const QString &path);
+  void undoRename(const QString &from, const QString &to);
+  void undoCommand(const QString &workDir, const QString &app,
+                   const QStringList &args);
+
+  void setEnvironment(const QStringList &env);
+  bool isIdle() const;
+
+signals:
+  /**
+   * @brief finished    a transaction is over
+   *
+   * @param id          result of the transaction as given to end()
+   * @param exitCode    0 on success, exit code of the failed step otherwise
+   * @param output      stdout of all steps, in the order they finished
+   * @param errout      stderr of the failed or the last step
+   */
+  void finished(int id, int exitCode, const QString &output,
+                const QString &errout);
+  /**
+   * @brief backgroundFinished  a background step is over
+   *
+   * @param id          id of the step as returned by add()
+   * @param exitCode    exit code of the step
+   * @param output      stdout of the step
+   * @param errout      stderr of the step
+   */
+  void backgroundFinished(int id, int exitCode, const QString &output,
+                          const QString &errout);
+  /**
+   * @brief singleStepFinished  a transaction of one step that is not a
+   *                            background step is over, emitted right before
+   *                            finished() to tell which one it was
+   *
+   * @param id          id of the step as returned by add()
+   * @param exitCode    exit code of the step
+   * @param output      stdout of the step
+   * @param errout      stderr of the step
+   */
+  void singleStepFinished(int id, int exitCode, const QString &output,
+                          const QString &errout);
+  /**
+   * @brief starting    a step that is not a background step is started
+   */
+  void starting();
+
+private slots:
+  void stepFinished(int id, int exitCode, const QString &output,
+                    const QString &errout);
+
+private:
+  /*!
+      \struct Rollback
+      \brief Undoes an effect of a transaction that failed.
+   */
+  struct Rollback {
+    enum Kind { RESTORE_FILE, REMOVE, RENAME, COMMAND };
+    Kind kind;
+    QString path;
+    QString other;
+    bool saved;
+    bool existed;
+    QByteArray data;
+    QStringList args;
+  };
+
+  /*!
+      \struct Transaction
+      \brief Progress of a transaction.
+   */
+  struct Transaction {
+    Enums::PROCESS result;
+    bool sealed;
+    bool background;
+    bool failed;
+    int lastStep;
+    int pending;
+    int exitCode;
+    QString output;
+    QString errout;
+    QList<int> steps;
+    QList<Rollback> rollbacks;
+  };
+
+  QMap<int, Step> queued;
+  QHash<int, int> stepTransaction;
+  QHash<int, Transaction> transactions;
+  QHash<int, Executor *> runningOn;
+  QHash<int, QStringList> claimed;
+  QHash<int, QString> piped;
+  QHash<int, int> traces;
+  QMap<QString, int> busy;
+  QList<Executor *> idle;
+  QStringList environment;
+  int depth;
+  int current;
+  int calling;
+  int nextStep;
+  int nextTransaction;
+
+  int open(Enums::PROCESS result, bool sealed);
+  int queue(int transaction, const Step &step);
+  Transaction *registering();
+  void schedule();
+  void start(int id, Step step);
+  void call(int id, const Step &step);
+  void saveBackups(int transaction, const QStringList &resources);
+  void cancel(int transaction);
+  void finish(int transaction);
+  void rollback(const Transaction &transaction);
+  Executor *runner();
+
+  static void save(Rollback *undo);
+  static bool isClaimed(const QMap<QString, int> &claims,
+                        const QString &resource);
+  static void claim(QMap<QString, int> *claims, const QStringList &resources);
+  static void release(QMap<QString, int> *claims,
+                      const QStringList &resources);
+
+  static const int maxRunning = 4;
+};
+
+#endif // TRANSACTIONSCHEDULER_H_
@@ -2,18 +2,16 @@
 #define USERSDIALOG_H_
 
 #include "datahelpers.h"
+#include "usersmodel.h"
 #include <QCloseEvent>
 #include <QDateTime>
 #include <QDialog>
 #include <QList>
-#include <QStandardItemModel>
 
 namespace Ui {
 class UsersDialog;
 }
 
-class QListWidgetItem;
-
 /*!
     \class UsersDialog
     \brief Handles listing and editing of GPG users.
@@ -26,21 +24,21 @@ class UsersDialog : public QDialog {
 public:
   explicit UsersDialog(QWidget *parent = 0);
   ~UsersDialog();
-  void setUsers(QList<UserInfo> *);
+  void setUsers(KeyTable *);
 
 protected:
   void closeEvent(QCloseEvent *event);
   void keyPressEvent(QKeyEvent *event);
 
 private slots:
-  void itemChange(QListWidgetItem *item);
   void on_lineEdit_textChanged(const QString &filter);
   void on_checkBox_clicked();
 
 private:
   Ui::UsersDialog *ui;
-  QList<UserInfo> *userList;
-  void populateList(const QString &filter);
+  UsersModel model;
+  UsersFilterModel proxyModel;
+  void updateFilter();
 };
 
 #endif // USERSDIALOG_H_
@@ -0,0 +1,207 @@
+#include "usersmodel.h"
+#include <QColor>
+#include <QDateTime>
+
+/**
+ * @brief UsersModel::UsersModel
+ * @param parent
+ */
+UsersModel::UsersModel(QObject *parent)
+    : QAbstractListModel(parent), userList(NULL) {
+  secretFont.setFamily(secretFont.defaultFamily());
+  secretFont.setBold(true);
+}
+
+/**
+ * @brief UsersModel::setUsers show these users, the table has to outlive the
+ * model or be unset with NULL.
+ * @param users
+ */
+void UsersModel::setUsers(KeyTable *users) {
+  beginResetModel();
+  userList = users;
+  displayText.clear();
+  expired.clear();
+  if (userList) {
+    QDateTime now = QDateTime::currentDateTime();
+    QString created = " " + tr("created") + " ";
+    QString expires = " " + tr("expires") + " ";
+    QDateTime date;
+    displayText.reserve(userList->size());
+    expired.reserve(userList->size());
+    for (int row = 0; row < userList->size(); ++row) {
+      QString userText = userList->name(row).toString();
+      userText += '\n';
+      userText += userList->keyIdText(row);
+      if (userList->created(row) > 0) {
+        date.setTime_t(userList->created(row));
+        userText += created + date.toString(Qt::SystemLocaleShortDate);
+      }
+      bool isExpired = false;
+      if (userList->expiry(row) > 0) {
+        date.setTime_t(userList->expiry(row));
+        userText += expires + date.toString(Qt::SystemLocaleShortDate);
+        isExpired = date.daysTo(now) > 0;
+      }
+      displayText << userText;
+      expired << isExpired;
+    }
+  }
+  endResetModel();
+}
+
+/**
+ * @brief UsersModel::name the name of a user, without copying it.
+ * @param row
+ * @return
+ */
+QStringRef UsersModel::name(int row) const { return userList->name(row); }
+
+/**
+ * @brief UsersModel::isUsable valid and not expired.
+ * @param row
+ * @return
+ */
+bool UsersModel::isUsable(int row) const {
+  return userList->isValid(row) && !expired.at(row);
+}
+
+/**
+ * @brief UsersModel::rowCount
+ * @param parent
+ * @return
+ */
+int UsersModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid() || !userList)
+    return 0;
+  return userList->size();
+}
+
+/**
+ * @brief UsersModel::data text, check state and colours of a user.
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant UsersModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || !userList || index.row() >= userList->size())
+    return QVariant();
+  int row = index.row();
+  bool isExpired = expired.at(row);
+  switch (role) {
+  case Qt::DisplayRole:
+    return displayText.at(row);
+  case Qt::CheckStateRole:
+    return userList->isEnabled(row) ? Qt::Checked : Qt::Unchecked;
+  case Qt::FontRole:
+    if (userList->haveSecret(row))
+      return secretFont;
+    break;
+  case Qt::ForegroundRole:
+    if (userList->haveSecret(row))
+      return QColor(Qt::blue);
+    if (!userList->isValid(row))
+      return QColor(Qt::white);
+    if (isExpired)
+      return QColor(164, 0, 0);
+    if (!userList->fullyValid(row))
+      return QColor(Qt::white);
+    break;
+  case Qt::BackgroundRole:
+    if (userList->haveSecret(row))
+      break;
+    if (!userList->isValid(row))
+      return QColor(164, 0, 0);
+    if (!isExpired && !userList->fullyValid(row))
+      return QColor(164, 80, 0);
+    break;
+  default:
+    break;
+  }
+  return QVariant();
+}
+
+/**
+ * @brief UsersModel::setData (un)checking a user selects it as recipient.
+ * @param index
+ * @param value
+ * @param role
+ * @return
+ */
+bool UsersModel::setData(const QModelIndex &index, const QVariant &value,
+                         int role) {
+  if (role != Qt::CheckStateRole || !index.isValid() || !userList ||
+      index.row() >= userList->size())
+    return false;
+  userList->setEnabled(index.row(), value.toInt() == Qt::Checked);
+  emit dataChanged(index, index);
+  return true;
+}
+
+/**
+ * @brief UsersModel::flags users can be checked.
+ * @param index
+ * @return
+ */
+Qt::ItemFlags UsersModel::flags(const QModelIndex &index) const {
+  if (!index.isValid())
+    return Qt::NoItemFlags;
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable;
+}
+
+/**
+ * @brief UsersFilterModel::UsersFilterModel
+ * @param parent
+ */
+UsersFilterModel::UsersFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent), users(NULL), useWildcard(false),
+      showAll(false) {
+  wildcard.setPatternSyntax(QRegExp::Wildcard);
+  wildcard.setCaseSensitivity(Qt::CaseInsensitive);
+}
+
+/**
+ * @brief UsersFilterModel::setUsersModel filter and show this model.
+ * @param model
+ */
+void UsersFilterModel::setUsersModel(UsersModel *model) {
+  users = model;
+  setSourceModel(model);
+}
+
+/**
+ * @brief UsersFilterModel::setFilter only show users matching filter.
+ * @param filter part of the name, * and ? work as wildcards
+ * @param showAll also show invalid and expired keys
+ */
+void UsersFilterModel::setFilter(const QString &filter, bool showAll) {
+  if (filter == this->filter && showAll == this->showAll)
+    return;
+  this->filter = filter;
+  this->showAll = showAll;
+  useWildcard = filter.contains('*') || filter.contains('?') ||
+                filter.contains('[');
+  if (useWildcard)
+    wildcard.setPattern("*" + filter + "*");
+  invalidateFilter();
+}
+
+/**
+ * @brief UsersFilterModel::filterAcceptsRow plain text is a substring match,
+ * no allocations per row.
+ * @param sourceRow
+ * @param sourceParent
+ * @return
+ */
+bool UsersFilterModel::filterAcceptsRow(int sourceRow,
+                                        const QModelIndex &sourceParent) const {
+  if (!users || sourceParent.isValid())
+    return false;
+  if (!showAll && !users->isUsable(sourceRow))
+    return false;
+  if (filter.isEmpty())
+    return true;
+  if (useWildcard)
+    return wildcard.exactMatch(users->name(sourceRow).toString());
+  return users->name(sourceRow).contains(filter, Qt::CaseInsensitive);
+}
@@ -0,0 +1,65 @@
+#ifndef USERSMODEL_H_
+#define USERSMODEL_H_
+
+#include "keytable.h"
+#include <QAbstractListModel>
+#include <QFont>
+#include <QRegExp>
+#include <QSortFilterProxyModel>
+#include <QStringList>
+#include <QVector>
+
+/*!
+    \class UsersModel
+    \brief List model over the keys shown in the UsersDialog.
+
+    Display strings are built once when the users are set, checking a row
+    updates the enabled flag in the KeyTable directly.
+ */
+class UsersModel : public QAbstractListModel {
+  Q_OBJECT
+
+public:
+  explicit UsersModel(QObject *parent = 0);
+
+  void setUsers(KeyTable *users);
+  QStringRef name(int row) const;
+  bool isUsable(int row) const;
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  QVariant data(const QModelIndex &index, int role) const;
+  bool setData(const QModelIndex &index, const QVariant &value, int role);
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+
+private:
+  KeyTable *userList;
+  QStringList displayText;
+  QVector<bool> expired;
+  QFont secretFont;
+};
+
+/*!
+    \class UsersFilterModel
+    \brief The QSortFilterProxyModel for searching in the UsersDialog.
+ */
+class UsersFilterModel : public QSortFilterProxyModel {
+  Q_OBJECT
+
+public:
+  explicit UsersFilterModel(QObject *parent = 0);
+
+  void setUsersModel(UsersModel *model);
+  void setFilter(const QString &filter, bool showAll);
+
+protected:
+  bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+
+private:
+  UsersModel *users;
+  QString filter;
+  QRegExp wildcard;
+  bool useWildcard;
+  bool showAll;
+};
+
+#endif // USERSMODEL_H_
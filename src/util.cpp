@@ -1,12 +1,14 @@
 #include "util.h"
 #include "debughelper.h"
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QDirIterator>
 #include <QFileInfo>
 #include <QProcessEnvironment>
 #include <QString>
 #ifdef Q_OS_WIN
 #include <windows.h>
-#include <bcrypt.h>
 #else
 #include <sys/time.h>
 #endif
@@ -58,6 +60,45 @@ QString Util::findPasswordStore() {
   return Util::normalizeFolderPath(path);
 }
 
+/**
+ * @brief Util::findPasswordEntries look up password files in a store, an
+ * exact path wins, otherwise the same fuzzy match as the search box is used.
+ * @param store the password-store folder
+ * @param query entry name or search words
+ * @return sorted entry names relative to store without '.gpg'
+ */
+QStringList Util::findPasswordEntries(const QString &store,
+                                      const QString &query) {
+  QStringList entries;
+  QDir storeDir(store);
+  if (!query.isEmpty() && QFileInfo(storeDir.filePath(query + ".gpg")).isFile())
+    return entries << QDir::cleanPath(query);
+
+  QRegExp regExp = searchRegExp(query);
+  QDirIterator gpgFiles(store, QStringList() << "*.gpg", QDir::Files,
+                        QDirIterator::Subdirectories);
+  while (gpgFiles.hasNext()) {
+    QString entry = storeDir.relativeFilePath(gpgFiles.next());
+    entry.chop(4);
+    if (entry.contains(regExp))
+      entries << entry;
+  }
+  entries.sort();
+  return entries;
+}
+
+/**
+ * @brief Util::searchRegExp the fuzzy match used for searching entries, words
+ * separated by spaces match in order with anything in between.
+ * @param query
+ * @return
+ */
+QRegExp Util::searchRegExp(const QString &query) {
+  QString pattern = query;
+  pattern.replace(QRegExp(" "), ".*");
+  return QRegExp(pattern, Qt::CaseInsensitive);
+}
+
 /**
  * @brief Util::normalizeFolderPath let's always end folders with a
  * QDir::separator()
@@ -71,47 +112,124 @@ QString Util::normalizeFolderPath(QString path) {
 }
 
 /**
- * @brief Util::findBinaryInPath search for executables.
- * @param binary
+ * @brief Util::isInside whether a path is a folder or lies somewhere in it,
+ * a folder can not be moved or copied there
+ * @param path
+ * @param folder
  * @return
  */
-QString Util::findBinaryInPath(QString binary) {
-  initialiseEnvironment();
+bool Util::isInside(const QString &path, const QString &folder) {
+  QString cleanPath = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+  QString cleanFolder = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+#ifdef Q_OS_WIN
+  Qt::CaseSensitivity cs = Qt::CaseInsensitive;
+#else
+  Qt::CaseSensitivity cs = Qt::CaseSensitive;
+#endif
+  return cleanPath.compare(cleanFolder, cs) == 0 ||
+         cleanPath.startsWith(cleanFolder + '/', cs);
+}
 
-  QString ret = "";
+/**
+ * @brief Util::findBinaryInPath search for executables, the result is cached
+ * in the settings until PATH or one of its folders changes.
+ * @param binary
+ * @param allowStale    accept a result found with another PATH, as long as
+ * the binary it points to did not change
+ * @return absolute path of the binary or an empty string
+ */
+QString Util::findBinaryInPath(QString binary, bool allowStale) {
+  QHash<QString, QString> cache = QtPassSettings::getBinaryCache();
+  // fingerprint, modification time and path, separated by tabs
+  QStringList cached = cache.value(binary).split('\t');
+  // taken anew every time, a binary may have been installed since the last
+  // lookup
+  QString fingerprint;
+  if (cached.length() == 3) {
+    QString ret = cached.at(2);
+    if (!allowStale)
+      fingerprint = pathFingerprint();
+    if ((allowStale || cached.at(0) == fingerprint) &&
+        (ret.isEmpty() || (QFileInfo(ret).isExecutable() &&
+                           modificationTime(ret) == cached.at(1))))
+      return ret;
+  }
 
-  binary.prepend(QDir::separator());
+  QString ret = searchPath(binary);
+  if (fingerprint.isEmpty())
+    fingerprint = pathFingerprint();
+  QStringList entry;
+  entry << fingerprint << modificationTime(ret) << ret;
+  cache.insert(binary, entry.join('\t'));
+  QtPassSettings::setBinaryCache(cache);
+  return ret;
+}
 
-  if (_env.contains("PATH")) {
-    QString path = _env.value("PATH");
+/**
+ * @brief Util::searchPath look for an executable in every PATH entry.
+ * @param binary
+ * @return
+ */
+QString Util::searchPath(QString binary) {
+  binary.prepend(QDir::separator());
+  foreach (QString entry, pathEntries()) {
+    QFileInfo qfi(entry.append(binary));
+#ifdef Q_OS_WIN
+    if (!qfi.exists())
+      qfi.setFile(entry.append(".exe"));
+#endif
+    if (qfi.isExecutable())
+      return qfi.absoluteFilePath();
+  }
+  return QString();
+}
 
-    QStringList entries;
+/**
+ * @brief Util::pathEntries the folders in PATH.
+ * @return
+ */
+QStringList Util::pathEntries() {
+  initialiseEnvironment();
+  if (!_env.contains("PATH"))
+    return QStringList();
+  QString path = _env.value("PATH");
+  QStringList entries;
 #ifndef Q_OS_WIN
-    entries = path.split(':');
-    if (entries.length() < 2) {
+  entries = path.split(':');
+  if (entries.length() < 2) {
 #endif
-      entries = path.split(';');
+    entries = path.split(';');
 #ifndef Q_OS_WIN
-    }
-#endif
-
-    foreach (QString entry, entries) {
-      QScopedPointer<QFileInfo> qfi(new QFileInfo(entry.append(binary)));
-#ifdef Q_OS_WIN
-      if (!qfi->exists())
-        qfi.reset(new QFileInfo(entry.append(".exe")));
-
+  }
 #endif
-      dbg() << entry;
-      if (!qfi->isExecutable())
-        continue;
+  return entries;
+}
 
-      ret = qfi->absoluteFilePath();
-      break;
-    }
+/**
+ * @brief Util::pathFingerprint hash of PATH and the modification times of its
+ * folders, which change whenever a binary is added to or removed from them.
+ * @return
+ */
+QString Util::pathFingerprint() {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  foreach (const QString &entry, pathEntries()) {
+    hash.addData(entry.toUtf8());
+    hash.addData(modificationTime(entry).toUtf8());
   }
+  return hash.result().toHex();
+}
 
-  return ret;
+/**
+ * @brief Util::modificationTime modification time of a file as a string,
+ * empty when it does not exist.
+ * @param path
+ * @return
+ */
+QString Util::modificationTime(const QString &path) {
+  QFileInfo info(path);
+  if (path.isEmpty() || !info.exists())
+    return QString();
+  return QString::number(info.lastModified().toMSecsSinceEpoch());
 }
 
 /**
@@ -177,15 +295,3 @@ void Util::copyDir(const QString src, const QString dest) {
                 dest + QDir::separator() + file);
   }
 }
-
-int Util::rand() {
-#ifdef Q_OS_WIN
-  quint32 ret = 0;
-  if (FAILED(BCryptGenRandom(NULL, (PUCHAR)&ret, sizeof(ret),
-                             BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
-    return qrand();
-  return ret % RAND_MAX;
-#else
-  return qrand();
-#endif
-}
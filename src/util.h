@@ -4,6 +4,7 @@
 #include "storemodel.h"
 #include <QFileSystemModel>
 #include <QProcessEnvironment>
+#include <QRegExp>
 #include <QString>
 
 class StoreModel;
@@ -13,19 +14,26 @@ class StoreModel;
  */
 class Util {
 public:
-  static QString findBinaryInPath(QString binary);
+  static QString findBinaryInPath(QString binary, bool allowStale = false);
   static QString findPasswordStore();
+  static QStringList findPasswordEntries(const QString &store,
+                                         const QString &query);
+  static QRegExp searchRegExp(const QString &query);
   static QString normalizeFolderPath(QString path);
+  static bool isInside(const QString &path, const QString &folder);
   static bool checkConfig();
   static void qSleep(int ms);
   static QString getDir(const QModelIndex &index, bool forPass,
                         const QFileSystemModel &model,
                         const StoreModel &storeModel);
   static void copyDir(const QString src, const QString dest);
-  static int rand();
 
 private:
   static void initialiseEnvironment();
+  static QString searchPath(QString binary);
+  static QStringList pathEntries();
+  static QString pathFingerprint();
+  static QString modificationTime(const QString &path);
   static QProcessEnvironment _env;
   static bool _envInitialised;
 };
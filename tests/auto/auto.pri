@@ -3,3 +3,63 @@
 TEMPLATE = app
 
 !contains(TARGET, ^tst_.*):TARGET = $$join(TARGET,,"tst_")
+
+# the parts of QtPass the tests link against, tests/bench uses them as well
+QTPASS_SRC = $$PWD/../../src
+
+OBJECTS +=      $$QTPASS_SRC/$(OBJECTS_DIR)/util.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/qtpasssettings.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/settingsconstants.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/pass.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/passwordgenerator.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/realpass.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/imitatepass.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/executor.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/executorstats.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/spawner.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/transactionscheduler.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/tracer.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/debughelper.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/filecontent.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/gpgkeyring.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/keyindex.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/keytable.o \
+                $$QTPASS_SRC/$(OBJECTS_DIR)/colonreader.o
+
+HEADERS   += util.h \
+             qtpasssettings.h \
+             settingsconstants.h \
+             pass.h \
+             passwordgenerator.h \
+             realpass.h \
+             imitatepass.h \
+             executor.h \
+             executorstats.h \
+             spawner.h \
+             transactionscheduler.h \
+             tracer.h \
+             filecontent.h \
+             gpgkeyring.h \
+             keyindex.h \
+             keytable.h \
+             colonreader.h
+
+libgit2 {
+    OBJECTS += $$QTPASS_SRC/$(OBJECTS_DIR)/gitworker.o
+    HEADERS += gitworker.h
+    LIBS    += -lgit2
+}
+
+OBJ_PATH += $$QTPASS_SRC/$(OBJECTS_DIR)
+
+VPATH += $$QTPASS_SRC
+INCLUDEPATH += $$QTPASS_SRC
+
+win32 {
+    LIBS += -lbcrypt
+	RC_FILE = $$QTPASS_SRC/../windows.rc
+#	temporary workaround for QTBUG-6453
+	QMAKE_LINK_OBJECT_MAX=24
+#	setting this may also work, but I can't find appropriate value right now
+#	QMAKE_LINK_OBJECT_SCRIPT = 
+}
@@ -1,2 +1,5 @@
 TEMPLATE = subdirs
-SUBDIRS += util
+SUBDIRS += util \
+           keyring \
+           transactions \
+           sync
@@ -0,0 +1,226 @@
+#include "../../../src/colonreader.h"
+#include "../../../src/gpgkeyring.h"
+#include "../../../src/keyindex.h"
+#include "../../../src/keytable.h"
+#include <QCoreApplication>
+#include <QtTest>
+
+/**
+ * @brief The tst_keyring class tests parsing and lookup of gpg keys
+ */
+class tst_keyring : public QObject {
+  Q_OBJECT
+
+public:
+  tst_keyring();
+  ~tst_keyring();
+
+private Q_SLOTS:
+  void initTestCase();
+  void colonReader();
+  void parseKeys();
+  void parseSecretKeys();
+  void findKeys();
+  void resolveRecipients();
+  void keyTable();
+  void parseKeys_benchmark();
+
+private:
+  QByteArray keyring;
+  QByteArray largeKeyring;
+};
+
+/**
+ * @brief tst_keyring::tst_keyring basic constructor
+ */
+tst_keyring::tst_keyring() {}
+
+/**
+ * @brief tst_keyring::~tst_keyring basic destructor
+ */
+tst_keyring::~tst_keyring() {}
+
+/**
+ * @brief tst_keyring::initTestCase a small keyring in the format of GnuPG 2.1
+ * and a synthetic one with 10000 keys for the benchmark.
+ */
+void tst_keyring::initTestCase() {
+  keyring = "tru::1:1494358217:0:3:1:5\n"
+            "pub:u:4096:1:1D2E3F4A5B6C7D8E:1494358202:::u:::scESC::::::23::0:\n"
+            "fpr:::::::::0123456789ABCDEF01231D2E3F4A5B6C7D8E:\n"
+            "uid:u::::1494358202::AAAA::Anne Jan <annejan@example.org>::::::"
+            "::::0:\n"
+            "uid:u::::1494358202::BBBB::Anne Jan \\x3a work <aj@example.com>::"
+            "::::::::0:\n"
+            "sub:u:4096:1:99AA88BB77CC66DD:1494358202::::::e::::::23:\n"
+            "fpr:::::::::FEDCBA987654321000AA99AA88BB77CC66DD:\n"
+            "\r\n"
+            "pub:e:2048:1:0000111122223333:1294358202:1394358202::-:::sc::::::"
+            "23::0:\n"
+            "fpr:::::::::AAAABBBBCCCCDDDDEEEEFFFF0000111122223333:\n"
+            "uid:e::::1294358202::CCCC::Old Key <old@example.org>::::::::::0:\n";
+
+  for (int i = 0; i < 10000; ++i) {
+    QByteArray id = QByteArray::number(0x1000000000000000ULL + i, 16).toUpper();
+    QByteArray subId =
+        QByteArray::number(0x2000000000000000ULL + i, 16).toUpper();
+    largeKeyring += "pub:f:4096:1:" + id + ":1494358202:::f:::scESC:::::::\n";
+    largeKeyring += "fpr:::::::::000000000000000000000000" + id + ":\n";
+    largeKeyring += "uid:f::::1494358202::HASH::User " + QByteArray::number(i) +
+                    " <user" + QByteArray::number(i) +
+                    "@example.org>::::::::::0:\n";
+    largeKeyring += "sub:f:4096:1:" + subId + ":1494358202::::::e:::::::\n";
+    largeKeyring += "fpr:::::::::000000000000000000000000" + subId + ":\n";
+  }
+}
+
+/**
+ * @brief tst_keyring::colonReader fields are split on colons, empty lines are
+ * skipped and escapes are decoded.
+ */
+void tst_keyring::colonReader() {
+  ColonReader record("a:bb::42\n\n\\x3a:x\\x3ay:\xc3\xa9");
+  QVERIFY(record.next());
+  QCOMPARE(record.fieldCount(), 4);
+  QVERIFY(record.fieldIs(0, "a"));
+  QVERIFY(!record.fieldIs(0, "ab"));
+  QCOMPARE(record.firstChar(1), 'b');
+  QCOMPARE(record.firstChar(2), '\0');
+  QCOMPARE(record.number(3), 42u);
+  QCOMPARE(record.text(5), QString());
+  QVERIFY(record.next());
+  QCOMPARE(record.fieldCount(), 3);
+  QCOMPARE(record.text(0), QString(":"));
+  QCOMPARE(record.text(1), QString("x:y"));
+  QCOMPARE(record.text(2), QString::fromUtf8("\xc3\xa9"));
+  QVERIFY(!record.next());
+}
+
+/**
+ * @brief tst_keyring::parseKeys primary key, fingerprints, user ids and
+ * subkeys end up in UserInfo.
+ */
+void tst_keyring::parseKeys() {
+  QList<QStringList> uids;
+  QList<UserInfo> keys = GpgKeyring::parseKeys(keyring, false, &uids);
+  QCOMPARE(keys.size(), 2);
+  QCOMPARE(uids.size(), 2);
+
+  const UserInfo &first = keys.at(0);
+  QCOMPARE(first.key_id, QString("1D2E3F4A5B6C7D8E"));
+  QCOMPARE(first.fingerprint,
+           QString("0123456789ABCDEF01231D2E3F4A5B6C7D8E"));
+  QCOMPARE(first.name, QString("Anne Jan <annejan@example.org>"));
+  QCOMPARE(first.validity, 'u');
+  QCOMPARE(first.created.toTime_t(), 1494358202u);
+  QCOMPARE(first.subkey_ids, QStringList() << "99AA88BB77CC66DD");
+  QCOMPARE(first.subkey_fingerprints,
+           QStringList() << "FEDCBA987654321000AA99AA88BB77CC66DD");
+  QCOMPARE(uids.at(0).size(), 2);
+  QCOMPARE(uids.at(0).at(1), QString("Anne Jan : work <aj@example.com>"));
+
+  const UserInfo &second = keys.at(1);
+  QCOMPARE(second.key_id, QString("0000111122223333"));
+  QCOMPARE(second.validity, 'e');
+  QCOMPARE(second.expiry.toTime_t(), 1394358202u);
+  QVERIFY(second.subkey_ids.isEmpty());
+}
+
+/**
+ * @brief tst_keyring::parseSecretKeys only sec records start a key when
+ * listing secret keys.
+ */
+void tst_keyring::parseSecretKeys() {
+  QByteArray secret = keyring;
+  secret.replace("pub:", "sec:");
+  QCOMPARE(GpgKeyring::parseKeys(secret, true).size(), 2);
+  QCOMPARE(GpgKeyring::parseKeys(secret, false).size(), 0);
+  QCOMPARE(GpgKeyring::parseKeys(keyring, true).size(), 0);
+}
+
+/**
+ * @brief tst_keyring::findKeys key specifications are matched like gpg does.
+ */
+void tst_keyring::findKeys() {
+  QList<QStringList> uids;
+  QList<UserInfo> keys = GpgKeyring::parseKeys(keyring, false, &uids);
+  KeyIndex index(keys, uids);
+
+  QCOMPARE(index.find("1D2E3F4A5B6C7D8E").size(), 1);
+  QCOMPARE(index.find("0x5b6c7d8e").size(), 1);
+  QCOMPARE(index.find("0123456789ABCDEF01231D2E3F4A5B6C7D8E").size(), 1);
+  QCOMPARE(index.find("77CC66DD").first().key_id,
+           QString("1D2E3F4A5B6C7D8E"));
+  QCOMPARE(index.find("<AJ@example.com>").size(), 1);
+  QCOMPARE(index.find("<nobody@example.com>").size(), 0);
+  QCOMPARE(index.find("example.org").size(), 2);
+  QCOMPARE(index.find("=Old Key <old@example.org>").size(), 1);
+  QCOMPARE(index.find("=Old Key").size(), 0);
+  QCOMPARE(index.find("").size(), 0);
+}
+
+/**
+ * @brief tst_keyring::resolveRecipients every recipient gets a status.
+ */
+void tst_keyring::resolveRecipients() {
+  QList<QStringList> uids;
+  QList<UserInfo> keys = GpgKeyring::parseKeys(keyring, false, &uids);
+  QList<RecipientInfo> resolved =
+      KeyIndex(keys, uids).resolve(QStringList() << "annejan@example.org"
+                                                 << "missing@example.org"
+                                                 << "example.org"
+                                                 << "0000111122223333");
+  QCOMPARE(resolved.size(), 4);
+  QCOMPARE(resolved.at(0).status, RecipientInfo::FOUND);
+  QCOMPARE(resolved.at(1).status, RecipientInfo::NOT_FOUND);
+  QCOMPARE(resolved.at(2).status, RecipientInfo::AMBIGUOUS);
+  QCOMPARE(resolved.at(3).status, RecipientInfo::UNUSABLE);
+  QCOMPARE(resolved.at(1).recipient, QString("missing@example.org"));
+}
+
+/**
+ * @brief tst_keyring::keyTable columns hold what was appended, copies share
+ * them until changed, at() gives back the UserInfo that was appended.
+ */
+void tst_keyring::keyTable() {
+  QList<QStringList> uids;
+  QList<UserInfo> keys = GpgKeyring::parseKeys(keyring, false, &uids);
+  KeyTable table = KeyIndex(keys, uids).keys();
+  QCOMPARE(table.size(), 2);
+  QCOMPARE(table.keyId(0), Q_UINT64_C(0x1D2E3F4A5B6C7D8E));
+  QCOMPARE(table.keyIdText(1).toString(), QString("0000111122223333"));
+  QCOMPARE(table.name(1).toString(), QString("Old Key <old@example.org>"));
+  QCOMPARE(table.fingerprint(0).toString(),
+           QString("0123456789ABCDEF01231D2E3F4A5B6C7D8E"));
+  QCOMPARE(table.created(0), Q_INT64_C(1494358202));
+  QCOMPARE(table.expiry(1), Q_INT64_C(1394358202));
+  QVERIFY(table.fullyValid(0));
+  QVERIFY(!table.isValid(1));
+
+  KeyTable copy = table;
+  copy.setEnabled(0, true);
+  QVERIFY(copy.isEnabled(0));
+  QVERIFY(!table.isEnabled(0));
+  QCOMPARE(copy.at(0).key_id, QString("1D2E3F4A5B6C7D8E"));
+  QVERIFY(copy.at(0).enabled);
+
+  UserInfo first = table.at(0);
+  QCOMPARE(first.created, keys.at(0).created);
+  QVERIFY(!first.expiry.isValid());
+  QCOMPARE(first.subkey_ids, keys.at(0).subkey_ids);
+  QCOMPARE(first.subkey_fingerprints, keys.at(0).subkey_fingerprints);
+  QCOMPARE(table.at(1).expiry, keys.at(1).expiry);
+}
+
+/**
+ * @brief tst_keyring::parseKeys_benchmark parsing a keyring with 10000 keys.
+ */
+void tst_keyring::parseKeys_benchmark() {
+  QList<UserInfo> keys;
+  QBENCHMARK { keys = GpgKeyring::parseKeys(largeKeyring, false); }
+  QCOMPARE(keys.size(), 10000);
+  QCOMPARE(keys.last().subkey_ids.size(), 1);
+}
+
+QTEST_MAIN(tst_keyring)
+#include "tst_keyring.moc"
@@ -0,0 +1,7 @@
+!include(../auto.pri) { error("Couldn't find the auto.pri file!") }
+
+SOURCES += tst_sync.cpp
+
+HEADERS += syncscheduler.h
+
+OBJECTS += $$QTPASS_SRC/$(OBJECTS_DIR)/syncscheduler.o
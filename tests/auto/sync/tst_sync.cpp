@@ -0,0 +1,215 @@
+#include "../../../src/qtpasssettings.h"
+#include "../../../src/syncscheduler.h"
+#include <QCoreApplication>
+#include <QProcess>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const int minute = 60 * 1000;
+
+/**
+ * @brief The tst_sync class tests SyncScheduler against a bare remote in a
+ * temporary folder
+ */
+class tst_sync : public QObject {
+  Q_OBJECT
+
+private Q_SLOTS:
+  void initTestCase();
+  void cleanupTestCase();
+  void init();
+  void counts();
+  void backoff();
+  void coalescedPush();
+
+private:
+  QScopedPointer<QTemporaryDir> dir;
+  QString remote;
+  QString seed;
+  QString store;
+  QString portableIni;
+  bool createdIni = false;
+
+  static int git(const QString &workDir, const QStringList &args);
+  static bool commit(const QString &workDir, const QString &name);
+};
+
+/**
+ * @brief tst_sync::initTestCase settings are kept next to the binary so the
+ * test does not touch the settings of the user, git fetches every minute
+ */
+void tst_sync::initTestCase() {
+#ifdef Q_OS_WIN
+  QSKIP("needs a POSIX shell");
+#endif
+  QString gitExecutable = QStandardPaths::findExecutable("git");
+  if (gitExecutable.isEmpty())
+    QSKIP("needs git");
+  portableIni =
+      QCoreApplication::applicationDirPath() + QDir::separator() + "qtpass.ini";
+  createdIni = !QFile::exists(portableIni);
+  if (createdIni) {
+    QFile ini(portableIni);
+    QVERIFY(ini.open(QIODevice::WriteOnly));
+  }
+  QtPassSettings::setGitExecutable(gitExecutable);
+  QtPassSettings::setUseGit(true);
+  QtPassSettings::setUsePass(false);
+  QtPassSettings::setSyncInterval(1);
+  qputenv("GIT_AUTHOR_NAME", "QtPass");
+  qputenv("GIT_AUTHOR_EMAIL", "qtpass@example.org");
+  qputenv("GIT_COMMITTER_NAME", "QtPass");
+  qputenv("GIT_COMMITTER_EMAIL", "qtpass@example.org");
+}
+
+/**
+ * @brief tst_sync::cleanupTestCase remove the settings created for the run
+ */
+void tst_sync::cleanupTestCase() {
+  if (createdIni)
+    QFile::remove(portableIni);
+}
+
+/**
+ * @brief tst_sync::init a bare remote with one commit, the store cloned from
+ * it and a second clone standing in for another computer
+ */
+void tst_sync::init() {
+  dir.reset(new QTemporaryDir);
+  QVERIFY(dir->isValid());
+  remote = dir->filePath("remote.git");
+  seed = dir->filePath("seed");
+  store = dir->filePath("store");
+  QCOMPARE(git(dir->path(), QStringList() << "init"
+                                          << "-q"
+                                          << "--bare" << remote),
+           0);
+  QCOMPARE(git(dir->path(), QStringList() << "clone"
+                                          << "-q" << remote << seed),
+           0);
+  QVERIFY(commit(seed, "first"));
+  QCOMPARE(git(seed, QStringList() << "push"
+                                   << "-q"
+                                   << "origin"
+                                   << "HEAD"),
+           0);
+  QCOMPARE(git(dir->path(), QStringList() << "clone"
+                                          << "-q" << remote << store),
+           0);
+  QtPassSettings::setPassStore(store);
+}
+
+/**
+ * @brief tst_sync::counts a local commit makes the store ahead, a commit
+ * pushed elsewhere makes it behind once it is fetched
+ */
+void tst_sync::counts() {
+  SyncScheduler sync;
+  QSignalSpy counts(&sync, &SyncScheduler::countsChanged);
+  QVERIFY(commit(store, "local"));
+  sync.updateCounts();
+  QVERIFY(counts.wait());
+  QCOMPARE(sync.ahead(), 1);
+  QCOMPARE(sync.behind(), 0);
+
+  QVERIFY(commit(seed, "remote"));
+  QCOMPARE(git(seed, QStringList() << "push"
+                                   << "-q"
+                                   << "origin"
+                                   << "HEAD"),
+           0);
+  sync.fetch();
+  QVERIFY(counts.wait());
+  QCOMPARE(sync.ahead(), 1);
+  QCOMPARE(sync.behind(), 1);
+  QCOMPARE(sync.fetchInterval(), minute);
+}
+
+/**
+ * @brief tst_sync::backoff every failed fetch in a row doubles the interval,
+ * a fetch that works again resets it
+ */
+void tst_sync::backoff() {
+  SyncScheduler sync;
+  QSignalSpy failed(&sync, &SyncScheduler::failed);
+  QCOMPARE(git(store, QStringList() << "remote"
+                                    << "set-url"
+                                    << "origin" << dir->filePath("missing")),
+           0);
+  sync.fetch();
+  QVERIFY(failed.wait());
+  QCOMPARE(sync.fetchInterval(), 2 * minute);
+  sync.fetch();
+  QVERIFY(failed.wait());
+  QCOMPARE(sync.fetchInterval(), 4 * minute);
+
+  QCOMPARE(git(store, QStringList() << "remote"
+                                    << "set-url"
+                                    << "origin" << remote),
+           0);
+  sync.fetch();
+  QTRY_COMPARE(sync.fetchInterval(), minute);
+  QCOMPARE(failed.count(), 2);
+}
+
+/**
+ * @brief tst_sync::coalescedPush pushes asked for while one runs result in
+ * exactly one more push
+ */
+void tst_sync::coalescedPush() {
+  SyncScheduler sync;
+  QSignalSpy pushed(&sync, &SyncScheduler::pushed);
+  QSignalSpy failed(&sync, &SyncScheduler::failed);
+  QVERIFY(commit(store, "local"));
+  for (int i = 0; i < 5; ++i)
+    sync.push();
+  QVERIFY(sync.hasPending());
+  QTRY_VERIFY(!sync.hasPending());
+  // give a wrongly queued third push the chance to show up
+  QTest::qWait(200);
+  QCOMPARE(pushed.count(), 2);
+  QCOMPARE(failed.count(), 0);
+  QCOMPARE(git(store, QStringList() << "diff"
+                                    << "--quiet"
+                                    << "HEAD"
+                                    << "@{upstream}"),
+           0);
+}
+
+/**
+ * @brief tst_sync::git run git and wait for it
+ * @param workDir
+ * @param args
+ * @return exit code, -1 when git did not finish normally
+ */
+int tst_sync::git(const QString &workDir, const QStringList &args) {
+  QProcess process;
+  process.setWorkingDirectory(workDir);
+  process.start(QtPassSettings::getGitExecutable(), args);
+  if (!process.waitForFinished(-1) ||
+      process.exitStatus() != QProcess::NormalExit)
+    return -1;
+  return process.exitCode();
+}
+
+/**
+ * @brief tst_sync::commit commit a new file
+ * @param workDir   clone to commit in
+ * @param name      name and content of the file
+ */
+bool tst_sync::commit(const QString &workDir, const QString &name) {
+  QFile file(QDir(workDir).filePath(name));
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  file.write(name.toUtf8());
+  file.close();
+  return git(workDir, QStringList() << "add" << name) == 0 &&
+         git(workDir, QStringList() << "commit"
+                                    << "-q"
+                                    << "-m" << name) == 0;
+}
+
+QTEST_MAIN(tst_sync)
+#include "tst_sync.moc"
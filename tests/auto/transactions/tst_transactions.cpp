@@ -0,0 +1,375 @@
+#include "../../../src/executorstats.h"
+#include "../../../src/transactionscheduler.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief The tst_transactions class tests ordering and rollback of
+ * transactions
+ */
+class tst_transactions : public QObject {
+  Q_OBJECT
+
+public Q_SLOTS:
+  bool createFile(const QStringList &args);
+
+private Q_SLOTS:
+  void initTestCase();
+  void dependentSteps();
+  void sharedResource();
+  void backgroundStep();
+  void inProcessStep();
+  void pipedInput();
+  void rollback();
+  void deferredBackup();
+  void rollbackCommand();
+  void crashedStep();
+  void executorStats();
+
+private:
+  TransactionScheduler *calling = Q_NULLPTR;
+
+  static TransactionScheduler::Step shell(Enums::PROCESS process,
+                                          const QString &script,
+                                          const QString &resource = QString());
+  static QByteArray readAll(const QString &path);
+};
+
+/**
+ * @brief tst_transactions::initTestCase the steps are run with sh
+ */
+void tst_transactions::initTestCase() {
+#ifdef Q_OS_WIN
+  QSKIP("needs a POSIX shell");
+#endif
+}
+
+/**
+ * @brief tst_transactions::dependentSteps steps added with then() run one
+ * after another and their output is collected in order
+ */
+void tst_transactions::dependentSteps() {
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.begin();
+  scheduler.then(shell(Enums::GIT_ADD, "sleep 0.2; echo 1"));
+  scheduler.then(shell(Enums::GIT_ADD, "echo 2"));
+  scheduler.then(shell(Enums::GIT_COMMIT, "echo 3"));
+  scheduler.end(Enums::PASS_INSERT);
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(spy.at(0).at(0).toInt(), static_cast<int>(Enums::PASS_INSERT));
+  QCOMPARE(spy.at(0).at(1).toInt(), 0);
+  QCOMPARE(spy.at(0).at(2).toString(), QString("1\n2\n3\n"));
+  QVERIFY(scheduler.isIdle());
+}
+
+/**
+ * @brief tst_transactions::sharedResource independent transactions on the
+ * same resource keep the order they were started in
+ */
+void tst_transactions::sharedResource() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString file = dir.filePath("log");
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.add(
+      shell(Enums::GIT_ADD, "sleep 0.2; echo a >> '" + file + "'", "git"));
+  scheduler.add(shell(Enums::GIT_COMMIT, "echo b >> '" + file + "'", "git"));
+  scheduler.add(shell(Enums::PASS_SHOW, "true"));
+
+  while (spy.count() < 3)
+    QVERIFY(spy.wait());
+  // the step without a resource did not wait for the others
+  QCOMPARE(spy.at(0).at(0).toInt(), static_cast<int>(Enums::PASS_SHOW));
+  QCOMPARE(readAll(file), QByteArray("a\nb\n"));
+}
+
+/**
+ * @brief tst_transactions::backgroundStep a background step waits for the
+ * resource like any other but is reported on its own, by step id
+ */
+void tst_transactions::backgroundStep() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString file = dir.filePath("log");
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  QSignalSpy background(&scheduler, &TransactionScheduler::backgroundFinished);
+  QSignalSpy starting(&scheduler, &TransactionScheduler::starting);
+  scheduler.add(
+      shell(Enums::GIT_COMMIT, "sleep 0.2; echo a >> '" + file + "'", "git"));
+  TransactionScheduler::Step fetch =
+      shell(Enums::INVALID, "echo b >> '" + file + "'; exit 1", "git");
+  fetch.background = true;
+  int id = scheduler.add(fetch);
+
+  QVERIFY(background.wait());
+  QCOMPARE(background.at(0).at(0).toInt(), id);
+  QCOMPARE(background.at(0).at(1).toInt(), 1);
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(starting.count(), 1);
+  QCOMPARE(readAll(file), QByteArray("a\nb\n"));
+}
+
+/**
+ * @brief tst_transactions::inProcessStep a step calling a slot claiming a
+ * folder waits for the steps on files inside it, and what it registers is
+ * rolled back with its transaction
+ */
+void tst_transactions::inProcessStep() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString log = dir.filePath("log");
+  QString folder = dir.filePath("folder");
+  QString created = QDir(folder).filePath("created");
+  QVERIFY(QDir().mkpath(folder));
+  TransactionScheduler scheduler;
+  calling = &scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.add(shell(Enums::PASS_INSERT, "sleep 0.2; echo a >> '" + log + "'",
+                      QDir(folder).filePath("file")));
+
+  scheduler.begin();
+  TransactionScheduler::Step call;
+  call.process = Enums::PASS_MOVE;
+  call.resources << folder + "/";
+  call.receiver = this;
+  call.slot = "createFile";
+  call.args << log << created;
+  scheduler.then(call);
+  scheduler.then(shell(Enums::GIT_ADD, "exit 2"));
+  scheduler.end(Enums::PASS_MOVE);
+
+  while (spy.count() < 2)
+    QVERIFY(spy.wait());
+  calling = Q_NULLPTR;
+  // the slot ran after the insert and its file was removed again
+  QCOMPARE(readAll(log), QByteArray("a\nb\n"));
+  QCOMPARE(spy.at(1).at(0).toInt(), static_cast<int>(Enums::PASS_MOVE));
+  QCOMPARE(spy.at(1).at(1).toInt(), 2);
+  QVERIFY(!QFile::exists(created));
+}
+
+/**
+ * @brief tst_transactions::pipedInput a step reads the output of an earlier
+ * step on stdin, that output is not part of the result
+ */
+void tst_transactions::pipedInput() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString file = dir.filePath("file");
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.begin();
+  int decrypt = scheduler.then(shell(Enums::PASS_SHOW, "echo secret"));
+  TransactionScheduler::Step encrypt =
+      shell(Enums::PASS_INSERT, "cat > '" + file + "'; echo done", file);
+  encrypt.inputFrom = decrypt;
+  scheduler.then(encrypt);
+  scheduler.end(Enums::PASS_MOVE);
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.at(0).at(1).toInt(), 0);
+  QCOMPARE(spy.at(0).at(2).toString(), QString("done\n"));
+  QCOMPARE(readAll(file), QByteArray("secret\n"));
+}
+
+/**
+ * @brief tst_transactions::rollback a failing step cancels the rest of its
+ * transaction and undoes what was registered
+ */
+void tst_transactions::rollback() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString edited = dir.filePath("edited");
+  QString created = dir.filePath("created");
+  QFile file(edited);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write("old");
+  file.close();
+
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.begin();
+  scheduler.backupFile(edited);
+  scheduler.undoCreate(created);
+  scheduler.then(shell(Enums::PASS_INSERT, "echo new > '" + edited +
+                                               "'; touch '" + created + "'"));
+  scheduler.then(shell(Enums::GIT_ADD, "echo failing >&2; exit 3"));
+  scheduler.then(shell(Enums::GIT_COMMIT, "echo never"));
+  scheduler.end(Enums::PASS_INSERT);
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(spy.at(0).at(1).toInt(), 3);
+  QVERIFY(!spy.at(0).at(2).toString().contains("never"));
+  QCOMPARE(spy.at(0).at(3).toString().trimmed(), QString("failing"));
+  QCOMPARE(readAll(edited), QByteArray("old"));
+  QVERIFY(!QFile::exists(created));
+  QVERIFY(scheduler.isIdle());
+}
+
+/**
+ * @brief tst_transactions::deferredBackup a file backed up while an earlier
+ * step still writes it is saved once that step is done, so rolling back
+ * keeps what the earlier step wrote
+ */
+void tst_transactions::deferredBackup() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString edited = dir.filePath("edited");
+  QFile file(edited);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write("old\n");
+  file.close();
+
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.add(shell(Enums::PASS_INSERT,
+                      "sleep 0.2; echo first > '" + edited + "'", edited));
+  scheduler.begin();
+  scheduler.backupFile(edited);
+  scheduler.then(
+      shell(Enums::PASS_INSERT, "echo second > '" + edited + "'", edited));
+  scheduler.then(shell(Enums::GIT_ADD, "exit 1"));
+  scheduler.end(Enums::PASS_INSERT);
+
+  while (spy.count() < 2)
+    QVERIFY(spy.wait());
+  QCOMPARE(spy.at(1).at(1).toInt(), 1);
+  QCOMPARE(readAll(edited), QByteArray("first\n"));
+}
+
+/**
+ * @brief tst_transactions::rollbackCommand a command undoing a failed
+ * transaction does not block, it waits its turn on git like any git command
+ */
+void tst_transactions::rollbackCommand() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString log = dir.filePath("log");
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  QSignalSpy background(&scheduler, &TransactionScheduler::backgroundFinished);
+  scheduler.add(shell(Enums::GIT_COMMIT,
+                      "sleep 0.3; echo commit >> '" + log + "'", "git"));
+  scheduler.begin();
+  scheduler.undoCommand(dir.path(), "/bin/sh",
+                        QStringList() << "-c"
+                                      << "echo undo >> '" + log + "'");
+  scheduler.then(shell(Enums::GIT_ADD, "exit 1"));
+  scheduler.end(Enums::PASS_INSERT);
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.at(0).at(0).toInt(), static_cast<int>(Enums::PASS_INSERT));
+  QVERIFY(readAll(log).isEmpty());
+  while (background.count() < 1)
+    QVERIFY(background.wait());
+  QCOMPARE(readAll(log), QByteArray("commit\nundo\n"));
+  QCOMPARE(background.at(0).at(1).toInt(), 0);
+}
+
+/**
+ * @brief tst_transactions::crashedStep a step killed by a signal fails its
+ * transaction and releases its resource for the steps after it
+ */
+void tst_transactions::crashedStep() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  QString created = dir.filePath("created");
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.begin();
+  scheduler.undoCreate(created);
+  scheduler.then(
+      shell(Enums::GIT_ADD, "touch '" + created + "'; kill -9 $$", "git"));
+  scheduler.end(Enums::PASS_INSERT);
+  scheduler.add(shell(Enums::GIT_COMMIT, "echo next", "git"));
+
+  while (spy.count() < 2)
+    QVERIFY(spy.wait());
+  QCOMPARE(spy.at(0).at(0).toInt(), static_cast<int>(Enums::PASS_INSERT));
+  QCOMPARE(spy.at(0).at(1).toInt(), -1);
+  QVERIFY(!QFile::exists(created));
+  QCOMPARE(spy.at(1).at(1).toInt(), 0);
+  QCOMPARE(spy.at(1).at(2).toString(), QString("next\n"));
+  QVERIFY(scheduler.isIdle());
+}
+
+/**
+ * @brief tst_transactions::executorStats every job that ran is counted under
+ * its program with its exit code and timings
+ */
+void tst_transactions::executorStats() {
+  ExecutorStats::reset();
+  TransactionScheduler scheduler;
+  QSignalSpy spy(&scheduler, &TransactionScheduler::finished);
+  scheduler.add(shell(Enums::GIT_ADD, "true"));
+  scheduler.add(shell(Enums::GIT_COMMIT, "sleep 0.1; exit 1"));
+
+  while (spy.count() < 2)
+    QVERIFY(spy.wait());
+  QCOMPARE(ExecutorStats::programs(), QStringList("sh"));
+  QCOMPARE(ExecutorStats::jobs("sh"), 2);
+  QCOMPARE(ExecutorStats::exitCodes("sh").value(0), 1);
+  QCOMPARE(ExecutorStats::exitCodes("sh").value(1), 1);
+  QVERIFY(ExecutorStats::percentile("sh", ExecutorStats::RUN, 99) >= 100000);
+  QVERIFY(ExecutorStats::percentile("sh", ExecutorStats::WAIT, 50) >= 0);
+  QCOMPARE(ExecutorStats::queueDepth(), 0);
+  QVERIFY(ExecutorStats::report().contains("sh"));
+}
+
+/**
+ * @brief tst_transactions::createFile slot of an in-process step, logs that
+ * it ran and creates a file to be removed on rollback
+ * @param args  log file and file to create
+ * @return whether the file was created
+ */
+bool tst_transactions::createFile(const QStringList &args) {
+  QFile log(args.value(0));
+  if (!log.open(QIODevice::Append))
+    return false;
+  log.write("b\n");
+  QFile created(args.value(1));
+  if (!created.open(QIODevice::WriteOnly))
+    return false;
+  calling->undoCreate(args.value(1));
+  return true;
+}
+
+/**
+ * @brief tst_transactions::shell a step running a shell script
+ * @param process
+ * @param script
+ * @param resource
+ */
+TransactionScheduler::Step tst_transactions::shell(Enums::PROCESS process,
+                                                   const QString &script,
+                                                   const QString &resource) {
+  TransactionScheduler::Step step;
+  step.process = process;
+  if (!resource.isEmpty())
+    step.resources << resource;
+  step.workDir = QDir::tempPath();
+  step.app = "/bin/sh";
+  step.args = QStringList() << "-c" << script;
+  return step;
+}
+
+/**
+ * @brief tst_transactions::readAll content of a file
+ * @param path
+ */
+QByteArray tst_transactions::readAll(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+  return file.readAll();
+}
+
+QTEST_MAIN(tst_transactions)
+#include "tst_transactions.moc"
@@ -1,3 +1,5 @@
+#include "../../../src/filecontent.h"
+#include "../../../src/passwordgenerator.h"
 #include "../../../src/util.h"
 #include <QCoreApplication>
 #include <QtTest>
@@ -20,6 +22,10 @@ private Q_SLOTS:
   void initTestCase();
   void cleanupTestCase();
   void normalizeFolderPath();
+  void isInside();
+  void fileContent();
+  void passwordGenerator();
+  void passwordGeneratorUniform();
 };
 
 /**
@@ -61,5 +67,97 @@ void tst_util::normalizeFolderPath() {
   QCOMPARE(Util::normalizeFolderPath("test/"), QDir::toNativeSeparators("test/"));
 }
 
+/**
+ * @brief tst_util::isInside a folder contains itself and everything below
+ * it, but not folders that merely start with its name
+ */
+void tst_util::isInside() {
+  QVERIFY(Util::isInside("/store/work", "/store/work"));
+  QVERIFY(Util::isInside("/store/work/mail/", "/store/work"));
+  QVERIFY(Util::isInside("/store/work/../work/mail", "/store/work/"));
+  QVERIFY(!Util::isInside("/store/workshop", "/store/work"));
+  QVERIFY(!Util::isInside("/store", "/store/work"));
+}
+
+/**
+ * @brief tst_util::fileContent the password, template fields and the rest of
+ * a password file are told apart
+ */
+void tst_util::fileContent() {
+  QString content = "secret\nlogin: annejan\nurl: https://qtpass.org\n"
+                    "pin: 1234\nnotes";
+  FileContent parsed = FileContent::parse(content, "login\nurl", false);
+  QCOMPARE(parsed.getPassword(), QString("secret"));
+  QCOMPARE(parsed.getNamedValues().size(), 2);
+  QCOMPARE(parsed.getNamedValues().at(0).name, QString("login"));
+  QCOMPARE(parsed.getNamedValues().at(0).value, QString(" annejan"));
+  QCOMPARE(parsed.getNamedValues().at(0).position, 1);
+  QCOMPARE(parsed.getNamedValues().at(1).value, QString(" https://qtpass.org"));
+  QCOMPARE(parsed.getRemainingData(), QString("notes"));
+  QCOMPARE(parsed.getContentWithoutPassword(),
+           QString("login: annejan\nurl: https://qtpass.org\npin: 1234\n"
+                   "notes"));
+
+  // a bare url is not taken for a field named https
+  parsed =
+      FileContent::parse(content + "\nhttps://example.org", "login", true);
+  QCOMPARE(parsed.getNamedValues().size(), 3);
+  QCOMPARE(parsed.getNamedValues().at(2).name, QString("pin"));
+  QCOMPARE(parsed.getRemainingData(), QString("notes\nhttps://example.org"));
+}
+
+/**
+ * @brief tst_util::passwordGenerator passwords have the requested length and
+ * only use characters of the charset
+ */
+void tst_util::passwordGenerator() {
+  PasswordGenerator generator;
+  QString charset = "abc123";
+  QStringList passwords = generator.generate(1000, 24, charset);
+  QCOMPARE(passwords.size(), 1000);
+  foreach (const QString &password, passwords) {
+    QCOMPARE(password.length(), 24);
+    foreach (QChar c, password)
+      QVERIFY(charset.contains(c));
+  }
+  QCOMPARE(passwords.removeDuplicates(), 0);
+  QVERIFY(generator.generate(16, QString()).isEmpty());
+}
+
+/**
+ * @brief tst_util::passwordGeneratorUniform every character is equally
+ * likely, taking random bytes modulo 62 would favour the first 8 characters
+ * by a quarter and fail the chi-squared test by far
+ */
+void tst_util::passwordGeneratorUniform() {
+  PasswordGenerator generator;
+  QString charset = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                    "0123456789";
+  const int expected = 2000;
+  QString sample = generator.generate(charset.length() * expected, charset);
+  QCOMPARE(sample.length(), charset.length() * expected);
+  QHash<QChar, int> counts;
+  foreach (QChar c, sample)
+    ++counts[c];
+  double chiSquared = 0;
+  foreach (QChar c, charset) {
+    double difference = counts.value(c) - expected;
+    chiSquared += difference * difference / expected;
+  }
+  // 61 degrees of freedom, exceeded by chance less than once in a million
+  QVERIFY2(chiSquared < 130, qPrintable(QString::number(chiSquared)));
+
+  // bounds above 256 draw four bytes at a time
+  QVector<int> buckets(4);
+  for (int i = 0; i < 40000; ++i) {
+    quint32 value;
+    QVERIFY(generator.uniform(1000, &value));
+    QVERIFY(value < 1000);
+    ++buckets[static_cast<int>(value / 250)];
+  }
+  foreach (int bucket, buckets)
+    QVERIFY(qAbs(bucket - 10000) < 600);
+}
+
 QTEST_MAIN(tst_util)
 #include "tst_util.moc"
@@ -0,0 +1,15 @@
+!include(../auto/auto.pri) { error("Couldn't find the auto.pri file!") }
+
+# not a testcase, so "make check" does not run the benchmarks, run
+# ./tst_bench from this folder instead
+TARGET = tst_bench
+CONFIG -= testcase
+INSTALLS -= target
+
+SOURCES += tst_bench.cpp \
+           storegenerator.cpp
+
+HEADERS += storegenerator.h \
+           storemodel.h
+
+OBJECTS += $$QTPASS_SRC/$(OBJECTS_DIR)/storemodel.o
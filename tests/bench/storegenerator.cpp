@@ -0,0 +1,97 @@
+#include "storegenerator.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+
+/**
+ * @brief StoreGenerator::generate fill a folder with a store
+ * @param root      existing folder that becomes the store
+ * @param entries   number of password files
+ * @return whether everything could be written
+ */
+bool StoreGenerator::generate(const QString &root, int entries) {
+  QDir store(root);
+  if (!writeGpgId(root, "0000000000000000"))
+    return false;
+  QByteArray data(256, '\0');
+  for (int i = 0; i < entries; ++i) {
+    QString path = entryPath(i);
+    QString folder = QFileInfo(path).path();
+    if (!store.exists(folder)) {
+      if (!store.mkpath(folder))
+        return false;
+      QStringList parts = folder.split('/');
+      int team = i % teams;
+      int project = (i / teams) % projects;
+      if (!QFile::exists(store.filePath(parts.at(0) + "/.gpg-id")) &&
+          !writeGpgId(store.filePath(parts.at(0)),
+                      QString("1%1").arg(team, 15, 16, QChar('0'))))
+        return false;
+      if (project % 2 == 1 &&
+          !QFile::exists(store.filePath(parts.at(0) + "/" + parts.at(1) +
+                                        "/.gpg-id")) &&
+          !writeGpgId(store.filePath(parts.at(0) + "/" + parts.at(1)),
+                      QString("2%1").arg(project, 15, 16, QChar('0'))))
+        return false;
+    }
+    for (int j = 0; j < data.size(); ++j)
+      data[j] = static_cast<char>((i * 31 + j * 17) & 0xff);
+    QFile file(store.filePath(path));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief StoreGenerator::entryPath relative path of an entry
+ * @param entry
+ */
+QString StoreGenerator::entryPath(int entry) {
+  int team = entry % teams;
+  int project = (entry / teams) % projects;
+  int group = entry / (teams * projects * perFolder);
+  return QString("team%1/project%2/group%3/site%4.gpg")
+      .arg(team)
+      .arg(project)
+      .arg(group)
+      .arg(entry);
+}
+
+/**
+ * @brief StoreGenerator::deepestEntry the last entry whose .gpg-id is two
+ * folders up, the longest lookup there is
+ * @param entries
+ */
+QString StoreGenerator::deepestEntry(int entries) {
+  int entry = entries - 1;
+  while (entry > 0 && (entry / teams) % projects % 2 == 1)
+    --entry;
+  return entryPath(entry);
+}
+
+/**
+ * @brief StoreGenerator::folders all folders of a store, the store first
+ * @param root
+ */
+QStringList StoreGenerator::folders(const QString &root) {
+  QStringList result(QDir(root).absolutePath());
+  QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext())
+    result << QDir(it.next()).absolutePath();
+  return result;
+}
+
+/**
+ * @brief StoreGenerator::writeGpgId give a folder its own recipient
+ * @param folder
+ * @param recipient
+ */
+bool StoreGenerator::writeGpgId(const QString &folder,
+                                const QString &recipient) {
+  QFile gpgId(QDir(folder).filePath(".gpg-id"));
+  if (!gpgId.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+  return gpgId.write(recipient.toLatin1() + "\n") > 0;
+}
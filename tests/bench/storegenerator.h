@@ -0,0 +1,32 @@
+#ifndef STOREGENERATOR_H_
+#define STOREGENERATOR_H_
+
+#include <QString>
+#include <QStringList>
+
+/*!
+    \class StoreGenerator
+    \brief Creates synthetic password stores for the benchmarks.
+
+    Entries are spread over team/project/group folders, the store and every
+    team have a .gpg-id and every other project overrides it, like stores
+    shared with several groups of people tend to look. The files hold random
+    bytes instead of encrypted data.
+ */
+class StoreGenerator {
+public:
+  static bool generate(const QString &root, int entries);
+
+  static QString entryPath(int entry);
+  static QString deepestEntry(int entries);
+  static QStringList folders(const QString &root);
+
+private:
+  static bool writeGpgId(const QString &folder, const QString &recipient);
+
+  static const int teams = 16;
+  static const int projects = 16;
+  static const int perFolder = 50;
+};
+
+#endif // STOREGENERATOR_H_
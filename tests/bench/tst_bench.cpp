@@ -0,0 +1,488 @@
+#include "../../src/executor.h"
+#include "../../src/filecontent.h"
+#include "../../src/gpgkeyring.h"
+#include "../../src/imitatepass.h"
+#include "../../src/passwordgenerator.h"
+#include "../../src/qtpasssettings.h"
+#include "../../src/realpass.h"
+#include "../../src/storemodel.h"
+#include "storegenerator.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileSystemModel>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+
+/**
+ * @brief The Stopwatch class records when each of a batch of jobs got to a
+ * point, relative to the start of the batch
+ */
+class Stopwatch : public QObject {
+  Q_OBJECT
+
+public:
+  void start() {
+    samples.clear();
+    timer.start();
+  }
+  qint64 elapsed() const { return timer.elapsed(); }
+  QVector<qint64> laps() const { return samples; }
+
+public slots:
+  void lap() { samples << timer.nsecsElapsed() / 1000; }
+
+private:
+  QElapsedTimer timer;
+  QVector<qint64> samples;
+};
+
+/**
+ * @brief The tst_bench class benchmarks the hot paths of QtPass against
+ * synthetic stores and keyrings.
+ *
+ * Stores with 1000, 10000 and 100000 entries are generated on first use and
+ * kept for the whole run. gpg, git and pass are replaced by the stand-in from
+ * tests/fakes so process based benchmarks do not depend on real keys and
+ * their latency can be chosen.
+ */
+class tst_bench : public QObject {
+  Q_OBJECT
+
+private Q_SLOTS:
+  void initTestCase();
+  void cleanupTestCase();
+  void storeModelFilter_data();
+  void storeModelFilter();
+  void getRecipientList_data();
+  void getRecipientList();
+  void parseKeys_data();
+  void parseKeys();
+  void fileContent_data();
+  void fileContent();
+  void generatePassword_data();
+  void generatePassword();
+  void generatePasswords_data();
+  void generatePasswords();
+  void executor_data();
+  void executor();
+  void imitatePass_data();
+  void imitatePass();
+  void realPass_data();
+  void realPass();
+
+private:
+  QTemporaryDir stores;
+  QTemporaryDir fakes;
+  QString fakeStore;
+  QString portableIni;
+  bool createdIni;
+
+  QString store(int entries);
+  bool linkFake(const QString &name);
+  static void storeSizes();
+  static void operations();
+  static void report(int jobs, qint64 elapsed, QVector<qint64> samples);
+
+  static const int fakeEntries = 100;
+};
+
+/**
+ * @brief tst_bench::initTestCase settings are kept next to the binary so the
+ * benchmarks do not touch the settings of the user
+ */
+void tst_bench::initTestCase() {
+  QVERIFY(stores.isValid());
+  portableIni =
+      QCoreApplication::applicationDirPath() + QDir::separator() + "qtpass.ini";
+  createdIni = !QFile::exists(portableIni);
+  if (createdIni) {
+    QFile ini(portableIni);
+    QVERIFY(ini.open(QIODevice::WriteOnly));
+  }
+  QtPassSettings::setUsePwgen(false);
+
+#ifndef Q_OS_WIN
+  QVERIFY(fakes.isValid());
+  QVERIFY2(QFile::exists(QCoreApplication::applicationDirPath() +
+                         "/../fakes/fakebinary"),
+           "build tests/fakes first");
+  QVERIFY(linkFake("gpg"));
+  QVERIFY(linkFake("git"));
+  QVERIFY(linkFake("pass"));
+  QtPassSettings::setGpgExecutable(fakes.filePath("gpg"));
+  QtPassSettings::setGitExecutable(fakes.filePath("git"));
+  QtPassSettings::setPassExecutable(fakes.filePath("pass"));
+  fakeStore = fakes.filePath("store");
+  QVERIFY(QDir().mkpath(fakeStore));
+  QVERIFY(StoreGenerator::generate(fakeStore, fakeEntries));
+#endif
+}
+
+/**
+ * @brief tst_bench::cleanupTestCase remove the settings created for the run
+ */
+void tst_bench::cleanupTestCase() {
+  if (createdIni)
+    QFile::remove(portableIni);
+}
+
+/**
+ * @brief tst_bench::storeSizes rows for the store based benchmarks
+ */
+void tst_bench::storeSizes() {
+  QTest::addColumn<int>("entries");
+  QTest::newRow("1k") << 1000;
+  QTest::newRow("10k") << 10000;
+  QTest::newRow("100k") << 100000;
+}
+
+void tst_bench::storeModelFilter_data() { storeSizes(); }
+
+/**
+ * @brief tst_bench::storeModelFilter filtering a fully loaded store the way
+ * the search field does
+ */
+void tst_bench::storeModelFilter() {
+  QFETCH(int, entries);
+  QString root = store(entries);
+  QVERIFY(!root.isEmpty());
+
+  QFileSystemModel model;
+  QSignalSpy loaded(&model, &QFileSystemModel::directoryLoaded);
+  model.setNameFilters(QStringList() << "*.gpg");
+  model.setNameFilterDisables(false);
+  model.setRootPath(root);
+  QStringList folders = StoreGenerator::folders(root);
+  foreach (const QString &folder, folders)
+    model.fetchMore(model.index(folder));
+  while (loaded.count() < folders.size())
+    QVERIFY2(loaded.wait(30000), "store did not finish loading");
+
+  StoreModel proxyModel;
+  proxyModel.setSourceModel(&model);
+  proxyModel.setModelAndStore(&model, root + "/");
+  proxyModel.setFilterRegExp(QRegExp("site1\\d*7$", Qt::CaseInsensitive));
+  QModelIndex rootIndex = proxyModel.mapFromSource(model.index(root));
+  QBENCHMARK {
+    proxyModel.invalidate();
+    proxyModel.rowCount(rootIndex);
+  }
+}
+
+void tst_bench::getRecipientList_data() { storeSizes(); }
+
+/**
+ * @brief tst_bench::getRecipientList looking up the recipients of an entry
+ * whose .gpg-id is two folders up
+ */
+void tst_bench::getRecipientList() {
+  QFETCH(int, entries);
+  QString root = store(entries);
+  QVERIFY(!root.isEmpty());
+  QtPassSettings::setPassStore(root + "/");
+  QString entry = StoreGenerator::deepestEntry(entries);
+
+  QStringList recipients;
+  QBENCHMARK { recipients = Pass::getRecipientList(entry); }
+  QCOMPARE(recipients.size(), 1);
+}
+
+/**
+ * @brief tst_bench::parseKeys_data keyrings of different sizes
+ */
+void tst_bench::parseKeys_data() {
+  QTest::addColumn<int>("keys");
+  QTest::newRow("100") << 100;
+  QTest::newRow("1000") << 1000;
+  QTest::newRow("10000") << 10000;
+}
+
+/**
+ * @brief tst_bench::parseKeys parsing the output of gpg --list-keys
+ * --with-colons
+ */
+void tst_bench::parseKeys() {
+  QFETCH(int, keys);
+  QByteArray colons;
+  for (int i = 0; i < keys; ++i) {
+    QByteArray id = QByteArray::number(0x1000000000000000ULL + i, 16).toUpper();
+    QByteArray subId =
+        QByteArray::number(0x2000000000000000ULL + i, 16).toUpper();
+    colons += "pub:f:4096:1:" + id + ":1494358202:::f:::scESC:::::::\n";
+    colons += "fpr:::::::::000000000000000000000000" + id + ":\n";
+    colons += "uid:f::::1494358202::HASH::User " + QByteArray::number(i) +
+              " <user" + QByteArray::number(i) + "@example.org>::::::::::0:\n";
+    colons += "sub:f:4096:1:" + subId + ":1494358202::::::e:::::::\n";
+    colons += "fpr:::::::::000000000000000000000000" + subId + ":\n";
+  }
+
+  QList<UserInfo> parsed;
+  QBENCHMARK { parsed = GpgKeyring::parseKeys(colons, false); }
+  QCOMPARE(parsed.size(), keys);
+}
+
+/**
+ * @brief tst_bench::fileContent_data password files with more and more
+ * fields
+ */
+void tst_bench::fileContent_data() {
+  QTest::addColumn<int>("fields");
+  QTest::newRow("10") << 10;
+  QTest::newRow("100") << 100;
+  QTest::newRow("1000") << 1000;
+}
+
+/**
+ * @brief tst_bench::fileContent splitting a decrypted file the way
+ * MainWindow::passShowHandler does
+ */
+void tst_bench::fileContent() {
+  QFETCH(int, fields);
+  QString content = "correct horse battery staple\n";
+  QString passTemplate;
+  for (int i = 0; i < fields; ++i) {
+    content += QString("field%1: value %1\n").arg(i);
+    if (i % 2 == 0)
+      passTemplate += QString("field%1\n").arg(i);
+  }
+  content += "url: https://qtpass.org\nsome notes without a field\n";
+
+  FileContent parsed = FileContent::parse(content, passTemplate, true);
+  QBENCHMARK { parsed = FileContent::parse(content, passTemplate, true); }
+  QCOMPARE(parsed.getNamedValues().size(), fields);
+}
+
+/**
+ * @brief tst_bench::generatePassword_data password lengths
+ */
+void tst_bench::generatePassword_data() {
+  QTest::addColumn<int>("length");
+  QTest::newRow("16") << 16;
+  QTest::newRow("64") << 64;
+  QTest::newRow("1024") << 1024;
+}
+
+/**
+ * @brief tst_bench::generatePassword generating a password without pwgen
+ */
+void tst_bench::generatePassword() {
+  QFETCH(int, length);
+  RealPass pass;
+  QString charset = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                    "1234567890!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+  QString password;
+  QBENCHMARK { password = pass.Generate_b(length, charset); }
+  QCOMPARE(password.length(), length);
+}
+
+/**
+ * @brief tst_bench::generatePasswords_data number of passwords per call
+ */
+void tst_bench::generatePasswords_data() {
+  QTest::addColumn<int>("count");
+  QTest::newRow("1000") << 1000;
+  QTest::newRow("10000") << 10000;
+}
+
+/**
+ * @brief tst_bench::generatePasswords generating passwords of 20 characters
+ * in bulk
+ */
+void tst_bench::generatePasswords() {
+  QFETCH(int, count);
+  PasswordGenerator generator;
+  QString charset = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                    "1234567890!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+  QStringList passwords;
+  QBENCHMARK { passwords = generator.generate(count, 20, charset); }
+  QCOMPARE(passwords.size(), count);
+}
+
+/**
+ * @brief tst_bench::executor_data number of processes run per iteration, how
+ * long each of them takes and how they are started
+ */
+void tst_bench::executor_data() {
+  QTest::addColumn<int>("runs");
+  QTest::addColumn<int>("latency");
+  QTest::addColumn<int>("mode");
+  QTest::newRow("10 instant") << 10 << 0 << int(Executor::QPROCESS);
+  QTest::newRow("100 instant") << 100 << 0 << int(Executor::QPROCESS);
+  QTest::newRow("100 10ms") << 100 << 10 << int(Executor::QPROCESS);
+  QTest::newRow("100 instant posix_spawn")
+      << 100 << 0 << int(Executor::POSIX_SPAWN);
+  QTest::newRow("100 10ms posix_spawn")
+      << 100 << 10 << int(Executor::POSIX_SPAWN);
+}
+
+/**
+ * @brief tst_bench::executor throughput of the executor queue, the queue
+ * wait is the time from execute() until the process is started
+ */
+void tst_bench::executor() {
+#ifdef Q_OS_WIN
+  QSKIP("the stand-in binaries are linked, not copied");
+#endif
+  QFETCH(int, runs);
+  QFETCH(int, latency);
+  QFETCH(int, mode);
+  qputenv("QTPASS_FAKE_LATENCY", QByteArray::number(latency));
+  Executor exec;
+  exec.setSpawnMode(Executor::SpawnMode(mode));
+  QSignalSpy spy(&exec, static_cast<void (Executor::*)(
+                            int, int, const QString &, const QString &)>(
+                            &Executor::finished));
+  Stopwatch waits;
+  // the queue is first in first out, so the n-th start is the n-th job
+  connect(&exec, &Executor::starting, &waits, &Stopwatch::lap);
+  QBENCHMARK {
+    spy.clear();
+    waits.start();
+    for (int i = 0; i < runs; ++i)
+      exec.execute(i, fakes.filePath("git"), QStringList("status"), false);
+    while (spy.count() < runs)
+      QVERIFY(spy.wait(10000));
+  }
+  report(runs, waits.elapsed(), waits.laps());
+  qunsetenv("QTPASS_FAKE_LATENCY");
+}
+
+/**
+ * @brief tst_bench::operations rows for the pass based benchmarks
+ */
+void tst_bench::operations() {
+  QTest::addColumn<bool>("insert");
+  QTest::addColumn<int>("latency");
+  QTest::newRow("show instant") << false << 0;
+  QTest::newRow("show 10ms") << false << 10;
+  QTest::newRow("insert instant") << true << 0;
+  QTest::newRow("insert 10ms") << true << 10;
+}
+
+void tst_bench::imitatePass_data() { operations(); }
+
+/**
+ * @brief tst_bench::imitatePass throughput of ImitatePass on distinct
+ * entries, an insert is encrypting followed by git add and commit, the
+ * samples are the time until each operation finished
+ */
+void tst_bench::imitatePass() {
+#ifdef Q_OS_WIN
+  QSKIP("the stand-in binaries are linked, not copied");
+#endif
+  QFETCH(bool, insert);
+  QFETCH(int, latency);
+  qputenv("QTPASS_FAKE_LATENCY", QByteArray::number(latency));
+  QtPassSettings::setPassStore(fakeStore + "/");
+  QtPassSettings::setUseGit(true);
+  ImitatePass pass;
+  QSignalSpy failed(&pass, &Pass::processErrorExit);
+  Stopwatch done;
+  connect(&pass, &Pass::finishedShow, &done, &Stopwatch::lap);
+  connect(&pass, &Pass::finishedInsert, &done, &Stopwatch::lap);
+  QBENCHMARK {
+    done.start();
+    for (int i = 0; i < fakeEntries; ++i) {
+      QString entry = StoreGenerator::entryPath(i);
+      entry.chop(4);
+      if (insert)
+        pass.Insert(entry, "secret", true);
+      else
+        pass.Show(entry);
+    }
+    while (done.laps().size() < fakeEntries && failed.isEmpty())
+      QTest::qWait(1);
+  }
+  QCOMPARE(failed.count(), 0);
+  report(fakeEntries, done.elapsed(), done.laps());
+  qunsetenv("QTPASS_FAKE_LATENCY");
+}
+
+void tst_bench::realPass_data() { operations(); }
+
+/**
+ * @brief tst_bench::realPass throughput of RealPass, every operation is a
+ * single pass call on the shared executor queue
+ */
+void tst_bench::realPass() {
+#ifdef Q_OS_WIN
+  QSKIP("the stand-in binaries are linked, not copied");
+#endif
+  QFETCH(bool, insert);
+  QFETCH(int, latency);
+  qputenv("QTPASS_FAKE_LATENCY", QByteArray::number(latency));
+  QtPassSettings::setPassStore(fakeStore + "/");
+  RealPass pass;
+  QSignalSpy failed(&pass, &Pass::processErrorExit);
+  Stopwatch done;
+  connect(&pass, &Pass::finishedShow, &done, &Stopwatch::lap);
+  connect(&pass, &Pass::finishedInsert, &done, &Stopwatch::lap);
+  QBENCHMARK {
+    done.start();
+    for (int i = 0; i < fakeEntries; ++i) {
+      QString entry = StoreGenerator::entryPath(i);
+      entry.chop(4);
+      if (insert)
+        pass.Insert(entry, "secret", true);
+      else
+        pass.Show(entry);
+    }
+    while (done.laps().size() < fakeEntries && failed.isEmpty())
+      QTest::qWait(1);
+  }
+  QCOMPARE(failed.count(), 0);
+  report(fakeEntries, done.elapsed(), done.laps());
+  qunsetenv("QTPASS_FAKE_LATENCY");
+}
+
+/**
+ * @brief tst_bench::store a generated store, created on first use
+ * @param entries
+ * @return absolute path without trailing separator, empty when it could not
+ * be generated
+ */
+QString tst_bench::store(int entries) {
+  QString root = QDir(stores.path()).filePath(QString::number(entries));
+  if (QFile::exists(root))
+    return root;
+  if (!QDir().mkpath(root) || !StoreGenerator::generate(root, entries))
+    return QString();
+  return root;
+}
+
+/**
+ * @brief tst_bench::linkFake make the stand-in available under a name
+ * @param name
+ */
+bool tst_bench::linkFake(const QString &name) {
+  return QFile::link(QCoreApplication::applicationDirPath() +
+                         "/../fakes/fakebinary",
+                     fakes.filePath(name));
+}
+
+/**
+ * @brief tst_bench::report print throughput and percentiles of the last
+ * iteration
+ * @param jobs      number of jobs run
+ * @param elapsed   milliseconds they took together
+ * @param samples   microseconds, one per job
+ */
+void tst_bench::report(int jobs, qint64 elapsed, QVector<qint64> samples) {
+  if (samples.isEmpty())
+    return;
+  std::sort(samples.begin(), samples.end());
+  QStringList percentiles;
+  foreach (int percentile, QList<int>() << 50 << 90 << 99) {
+    int at = qMin(samples.size() - 1, samples.size() * percentile / 100);
+    percentiles << QString("p%1 %2us").arg(percentile).arg(samples.at(at));
+  }
+  double perSecond = jobs * 1000.0 / qMax<qint64>(elapsed, 1);
+  qDebug().noquote() << QString("%1 jobs/s,").arg(perSecond, 0, 'f', 1)
+                     << percentiles.join(", ");
+}
+
+QTEST_MAIN(tst_bench)
+#include "tst_bench.moc"
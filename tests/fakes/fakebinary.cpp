@@ -0,0 +1,69 @@
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QThread>
+#include <cstdio>
+
+/*
+ * Stand-in for gpg, git and pass so the benchmarks do not depend on real
+ * keys, a real remote or the speed of the machine's gpg-agent.
+ *
+ * Link or copy it under the name of the binary it replaces, what it does is
+ * read from the environment, QTPASS_FAKE_<NAME>_<SETTING> taking precedence
+ * over QTPASS_FAKE_<SETTING> where <NAME> is the upper case name it was
+ * started as:
+ *
+ *   LATENCY  milliseconds to sleep before doing anything, 0 by default
+ *   OUTPUT   written to stdout
+ *   ERROR    written to stderr
+ *   EXIT     exit code, 0 by default
+ *
+ * When started with --output or -o the data read from stdin is written to
+ * the file that follows, the way gpg --encrypt does.
+ */
+
+/**
+ * @brief setting value of a setting for the binary started as name
+ * @param name
+ * @param setting
+ */
+static QByteArray setting(const QString &name, const char *setting) {
+  QByteArray own = "QTPASS_FAKE_" + name.toUpper().toLatin1() + "_" + setting;
+  if (qEnvironmentVariableIsSet(own.constData()))
+    return qgetenv(own.constData());
+  return qgetenv(QByteArray("QTPASS_FAKE_") + setting);
+}
+
+/**
+ * @brief copyInput write stdin to a file
+ * @param path
+ * @return whether everything was written
+ */
+static bool copyInput(const QString &path) {
+  QFile in;
+  QFile out(path);
+  if (!in.open(stdin, QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly))
+    return false;
+  QByteArray data = in.readAll();
+  return out.write(data) == data.size();
+}
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QStringList args = app.arguments();
+  QString name = QFileInfo(args.takeFirst()).baseName();
+
+  QThread::msleep(setting(name, "LATENCY").toULong());
+
+  int output = qMax(args.indexOf("--output"), args.indexOf("-o"));
+  if (output >= 0 && output + 1 < args.size() && !copyInput(args[output + 1]))
+    return 2;
+
+  QByteArray out = setting(name, "OUTPUT");
+  QByteArray err = setting(name, "ERROR");
+  fwrite(out.constData(), 1, out.size(), stdout);
+  fwrite(err.constData(), 1, err.size(), stderr);
+  return setting(name, "EXIT").toInt();
+}
@@ -0,0 +1,10 @@
+!include(../../qtpass.pri) { error("Couldn't find the qtpass.pri file!") }
+
+# stand-in for gpg, git and pass, see fakebinary.cpp
+TEMPLATE = app
+TARGET = fakebinary
+CONFIG += console warn_on
+CONFIG -= app_bundle
+QT -= gui
+
+SOURCES += fakebinary.cpp
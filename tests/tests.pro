@@ -1,5 +1,6 @@
 !include(tests.pri) { error("Couldn't find the tests.pri file!") }
 
 CONFIG += no_docs_target
-SUBDIRS += auto
+SUBDIRS += auto fakes bench
+bench.depends = fakes
 exists(manual): SUBDIRS += manual